@@ -118,9 +118,9 @@
 
 #define IS_BIT_CLEAR(val,n)        ( ((~(val))&(1<<(n))) != 0 )
 
-#define IS_MASK_SET(val,mask)      ( ((val)&(mask)) != (mask) )
+#define IS_MASK_SET(val,mask)      ( ((val)&(mask)) == (mask) )
 
-#define IS_MASK_CLEAR(val,mask)    ( ((~(val))&(mask)) != 0 )
+#define IS_MASK_CLEAR(val,mask)    ( ((val)&(mask)) == 0 )
 
 // End include guard
 #endif //_BITOPS_XC16_H
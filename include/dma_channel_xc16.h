@@ -512,6 +512,27 @@ int dma_set_block_size(dma_channel_t *dma_channel,
  */
 int dma_get_block_size(dma_channel_t *dma_channel);
 
+/**
+ * @brief Points the start address of the next transfer at buffer A or B.
+ *
+ * @details This function sets the DMAxSTA register to the start of the chosen buffer, so that a
+ * channel with ping-pong mode disabled may still send from either buffer, one transfer at a time.
+ * Software then decides which buffer the next transfer uses instead of the hardware alternating
+ * by itself. The channel should be disabled while the address is changed.
+ *
+ * @param[in]  dma_channel
+ *             A pointer to the DMA channel to work on.
+ * @param[in]  buffer
+ *             A dma_pingpong_status_t value coding for the buffer to start from (A or B).
+ * @returns An integer value representing the outcome of the function. Zero for success, a negative
+ * code for failure (see #dma_error_e).
+ *
+ * @see dma_pingpong_status_t
+ * @public
+ */
+int dma_set_buffer(dma_channel_t *dma_channel,
+                   dma_pingpong_status_t buffer);
+
 /**
  * @brief Outputs the attribute structure stored within a DMA channel.
  *
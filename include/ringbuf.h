@@ -0,0 +1,337 @@
+/* -*- mode: C; tab-width: 4; -*- */
+/**
+ * @file ringbuf.h
+ *
+ * @brief This file defines a single producer, single consumer ring buffer of bytes.
+ *
+ * @details The ring buffer is lock free as long as one context only writes and one context only
+ * reads, for example the main loop and an ISR. The size of the buffer must be a power of two, so
+ * positions are wrapped by masking. The head and tail are free running counters, each written by
+ * only one side: the writer moves the head once the data is in place and the reader moves the
+ * tail once the data has been copied out. Neither side needs a critical section.
+ *
+ * The bulk functions copy with at most two memcpy() calls, split at the end of the storage. The
+ * single byte functions are meant for ISRs which move one character at a time.
+ *
+ * The header has no hardware dependencies, so it also builds on a host machine.
+ *
+ * @date 10/16/2026
+ * @carlnumber FIRM-0009
+ * @version 0.4.0
+ */
+
+/**
+ * @ingroup ringbuf
+ *
+ * @{
+ */
+
+#ifndef _RINGBUF_H
+#define _RINGBUF_H
+
+#include <stdbool.h>
+#include <string.h>
+
+/**
+ * @brief Orders the accesses to the data before and after a head or tail update.
+ *
+ * @details On the single core dsPIC a compiler barrier is enough, since an ISR sees memory in
+ * program order. On host the two sides may be separate threads, so a full fence is used.
+ */
+#if defined(__XC16) || defined(__XC16__) || defined(XC16)
+#define RINGBUF_BARRIER() __asm__ volatile ("" ::: "memory")
+#else
+#define RINGBUF_BARRIER() __sync_synchronize()
+#endif
+
+/**
+ * @brief A single producer, single consumer ring buffer of bytes.
+ *
+ * @details All fields are set by #ringbuf_init() and should only be changed by the ring buffer
+ * functions.
+ *
+ * @public
+ */
+typedef struct ringbuf_s
+{
+    unsigned char *buffer;      /**< Storage of @em mask+1 bytes. */
+    unsigned int mask;          /**< Size of the storage less one, the size is a power of two. */
+    volatile unsigned int head; /**< Bytes written in total, only moved by the writer. */
+    volatile unsigned int tail; /**< Bytes read in total, only moved by the reader. */
+} ringbuf_t;
+
+/**
+ * @brief Initializes an empty ring buffer over the given storage.
+ *
+ * @param[out] ring
+ *             The ring buffer to initialize.
+ * @param[in]  buffer
+ *             The storage to use, at least @em size bytes long.
+ * @param[in]  size
+ *             The size of the ring buffer in bytes, a power of two.
+ * @return True if the ring buffer was initialized, false if @em buffer is NULL or @em size is not
+ * a power of two.
+ *
+ * @public
+ */
+static inline bool ringbuf_init(ringbuf_t *ring,
+                                void *buffer,
+                                unsigned int size)
+{
+    if( buffer == NULL || size == 0 || (size & (size-1)) != 0 )
+    {// Invalid storage
+        return false;
+    }
+
+    ring->buffer = buffer;
+    ring->mask = size-1;
+    ring->head = 0;
+    ring->tail = 0;
+
+    return true;
+}
+
+/**
+ * @brief Returns the number of bytes waiting to be read.
+ *
+ * @public
+ */
+static inline unsigned int ringbuf_count(const ringbuf_t *ring)
+{
+    return ring->head - ring->tail;
+}
+
+/**
+ * @brief Returns the number of bytes which may be written.
+ *
+ * @public
+ */
+static inline unsigned int ringbuf_space(const ringbuf_t *ring)
+{
+    return ring->mask + 1 - (ring->head - ring->tail);
+}
+
+/**
+ * @brief Writes up to @em length bytes into the ring buffer.
+ *
+ * @details Only the writer may call this function.
+ *
+ * @param[in]  ring
+ *             The ring buffer to write to.
+ * @param[in]  data
+ *             The bytes to write.
+ * @param[in]  length
+ *             The number of bytes to write.
+ * @return The number of bytes written, less than @em length if the ring buffer filled.
+ *
+ * @public
+ */
+static inline unsigned int ringbuf_write(ringbuf_t *ring,
+                                         const void *data,
+                                         unsigned int length)
+{
+    unsigned int head = ring->head;
+    unsigned int space = ring->mask + 1 - (head - ring->tail);
+    unsigned int offset = head & ring->mask;
+    unsigned int first;
+
+    if( length > space )
+    {// Write only what fits
+        length = space;
+    }
+
+    // Copy up to the end of the storage, then the rest from its start
+    first = ring->mask + 1 - offset;
+    if( first > length )
+    {// No wrap
+        first = length;
+    }
+    memcpy(ring->buffer + offset, data, first);
+    memcpy(ring->buffer, (const unsigned char *)data + first, length - first);
+
+    // Publish the bytes
+    RINGBUF_BARRIER();
+    ring->head = head + length;
+
+    return length;
+}
+
+/**
+ * @brief Reads up to @em length bytes out of the ring buffer.
+ *
+ * @details Only the reader may call this function.
+ *
+ * @param[in]  ring
+ *             The ring buffer to read from.
+ * @param[out] data
+ *             The array to copy the bytes into.
+ * @param[in]  length
+ *             The maximum number of bytes to read.
+ * @return The number of bytes read, less than @em length if the ring buffer emptied.
+ *
+ * @public
+ */
+static inline unsigned int ringbuf_read(ringbuf_t *ring,
+                                        void *data,
+                                        unsigned int length)
+{
+    unsigned int tail = ring->tail;
+    unsigned int count = ring->head - tail;
+    unsigned int offset = tail & ring->mask;
+    unsigned int first;
+
+    if( length > count )
+    {// Read only what is waiting
+        length = count;
+    }
+
+    // Make sure the bytes are read after the head which published them
+    RINGBUF_BARRIER();
+
+    // Copy up to the end of the storage, then the rest from its start
+    first = ring->mask + 1 - offset;
+    if( first > length )
+    {// No wrap
+        first = length;
+    }
+    memcpy(data, ring->buffer + offset, first);
+    memcpy((unsigned char *)data + first, ring->buffer, length - first);
+
+    // Hand the space back to the writer
+    RINGBUF_BARRIER();
+    ring->tail = tail + length;
+
+    return length;
+}
+
+/**
+ * @brief Returns the waiting bytes which are contiguous in the storage, without reading them.
+ *
+ * @details The bytes stay in the ring buffer until #ringbuf_skip() is called, so they may be used
+ * in place. Bytes which wrap around the end of the storage are returned by the next call, once
+ * those before the wrap have been skipped. Only the reader may call this function.
+ *
+ * @param[in]  ring
+ *             The ring buffer to read from.
+ * @param[out] data
+ *             Set to the first waiting byte.
+ * @return The number of contiguous bytes at @em data, zero if the ring buffer is empty.
+ *
+ * @public
+ */
+static inline unsigned int ringbuf_peek(const ringbuf_t *ring,
+                                        const void **data)
+{
+    unsigned int tail = ring->tail;
+    unsigned int count = ring->head - tail;
+    unsigned int offset = tail & ring->mask;
+
+    if( count > ring->mask + 1 - offset )
+    {// Stop at the end of the storage
+        count = ring->mask + 1 - offset;
+    }
+
+    // Make sure the bytes are read after the head which published them
+    RINGBUF_BARRIER();
+    *data = ring->buffer + offset;
+
+    return count;
+}
+
+/**
+ * @brief Discards bytes from the ring buffer, handing their space back to the writer.
+ *
+ * @details Only the reader may call this function.
+ *
+ * @param[in]  ring
+ *             The ring buffer to read from.
+ * @param[in]  length
+ *             The number of bytes to discard.
+ * @return True if the bytes were discarded, false if fewer than @em length are waiting.
+ *
+ * @public
+ */
+static inline bool ringbuf_skip(ringbuf_t *ring,
+                                unsigned int length)
+{
+    unsigned int tail = ring->tail;
+
+    if( length > ring->head - tail )
+    {// Not that many waiting
+        return false;
+    }
+
+    // Finish with the bytes before handing the space back
+    RINGBUF_BARRIER();
+    ring->tail = tail + length;
+
+    return true;
+}
+
+/**
+ * @brief Writes one byte into the ring buffer.
+ *
+ * @details Only the writer may call this function.
+ *
+ * @return True if the byte was written, false if the ring buffer is full.
+ *
+ * @public
+ */
+static inline bool ringbuf_put(ringbuf_t *ring,
+                               unsigned char value)
+{
+    unsigned int head = ring->head;
+
+    if( head - ring->tail > ring->mask )
+    {// Full
+        return false;
+    }
+
+    ring->buffer[head & ring->mask] = value;
+
+    // Publish the byte
+    RINGBUF_BARRIER();
+    ring->head = head + 1;
+
+    return true;
+}
+
+/**
+ * @brief Reads one byte out of the ring buffer.
+ *
+ * @details Only the reader may call this function.
+ *
+ * @param[in]  ring
+ *             The ring buffer to read from.
+ * @param[out] value
+ *             The byte read.
+ * @return True if a byte was read, false if the ring buffer is empty.
+ *
+ * @public
+ */
+static inline bool ringbuf_get(ringbuf_t *ring,
+                               unsigned char *value)
+{
+    unsigned int tail = ring->tail;
+
+    if( ring->head == tail )
+    {// Empty
+        return false;
+    }
+
+    // Make sure the byte is read after the head which published it
+    RINGBUF_BARRIER();
+    *value = ring->buffer[tail & ring->mask];
+
+    // Hand the space back to the writer
+    RINGBUF_BARRIER();
+    ring->tail = tail + 1;
+
+    return true;
+}
+
+#endif // _RINGBUF_H
+
+/**
+ * @}
+ */
@@ -0,0 +1,305 @@
+/* -*- mode: C; tab-width: 4; -*- */
+/**
+ * @file scheduler_hw.h
+ *
+ * @brief This file defines hardware specific macros for the scheduler. It should only be included
+ * from within the scheduler.
+ *
+ * @details When @c SCHEDULER_HOST is defined the scheduler is compiled for a host machine instead
+ * of the dsPIC33F. The Timer1 registers become plain variables and the critical section macros
+ * compile to nothing, so the scheduling logic can be exercised by the host programs in the test
+ * directory. Timer1 is simulated on host: scheduler_hw_host_advance() counts it forward and calls
+ * the tick ISR on each period match, and idling advances it to the next match, so a host program
+ * can call start_scheduler() and run in simulated time. The interrupt priority level is a per
+ * thread variable on host, so threads can stand in for ISRs. The software interrupts behind the
+ * preemptive bands are threads too.
+ *
+ * @date 10/15/2026
+ * @carlnumber FIRM-0004
+ * @version 0.3.0
+ */
+
+#ifndef _SCHEDULER_HW_H
+#define _SCHEDULER_HW_H
+
+/** Timer1 period register value for one 500us kernel tick. The timer counts PR1+1 cycles per
+ * period. */
+#define SCHEDULER_HW_TICK_PERIOD 5000U
+
+/** Length of one kernel tick in microseconds, SCHEDULER_HW_TICK_PERIOD+1 Timer1 counts */
+#define SCHEDULER_HW_TICK_US 500U
+
+/** Number of interrupt priority levels an ISR may run at (1 to 7) */
+#define SCHEDULER_HW_IPL_LEVELS 7
+
+/** Interrupt priority levels of the preemptive bands. Band 1 runs below the tick ISR (level 4) and
+ * band 2 above it, both below level 7 so that critical sections still hold them off. */
+#define SCHEDULER_HW_BAND1_IPL 2
+#define SCHEDULER_HW_BAND2_IPL 5
+
+#if defined(SCHEDULER_HOST)
+// Host build, no hardware available
+
+#include <pthread.h>
+
+/* Timer1 register stand-ins */
+static volatile unsigned int TMR1;
+static volatile unsigned int PR1;
+static volatile unsigned int T1CON;
+static volatile struct { unsigned int T1IE; } IEC0bits;
+static volatile struct { unsigned int T1IF; } IFS0bits;
+
+#define SCHEDULER_HW_DISABLE_INTERRUPTS() /**< Enter a critical section (nothing on host) */
+#define SCHEDULER_HW_ENABLE_INTERRUPTS()  /**< Leave a critical section (nothing on host) */
+
+#define SCHEDULER_HW_ISR /**< ISR attribute, the tick ISR is a plain function on host */
+
+/** Interrupt priority level of the calling thread, zero for the main loop */
+static __thread unsigned int scheduler_hw_host_ipl = 0;
+
+#define SCHEDULER_HW_CURRENT_IPL() (scheduler_hw_host_ipl) /**< Current interrupt priority level */
+
+/** Read a variable shared with another context, ordering later accesses after the read */
+#define SCHEDULER_HW_LOAD_ACQUIRE(var) __atomic_load_n(&(var), __ATOMIC_ACQUIRE)
+/** Write a variable shared with another context, ordering earlier accesses before the write */
+#define SCHEDULER_HW_STORE_RELEASE(var,value) __atomic_store_n(&(var), (value), __ATOMIC_RELEASE)
+/** Set bits in a variable shared with another context */
+#define SCHEDULER_HW_ATOMIC_OR(var,mask) __atomic_fetch_or(&(var), (mask), __ATOMIC_SEQ_CST)
+/** Clear the bits not in mask in a variable shared with another context */
+#define SCHEDULER_HW_ATOMIC_AND(var,mask) __atomic_fetch_and(&(var), (mask), __ATOMIC_SEQ_CST)
+
+void _T1Interrupt(void);
+
+/** Total number of simulated Timer1 cycles elapsed */
+static unsigned long long scheduler_hw_host_cycles = 0;
+
+/** Number of times the scheduler has idled */
+static unsigned long scheduler_hw_host_idles = 0;
+
+/** Cycles into the next idle at which scheduler_hw_host_wake_isr is raised, or 0 for none. This
+ * models another interrupt waking the device early. It is cleared once raised. */
+static unsigned long scheduler_hw_host_wake_after = 0;
+
+/** Interrupt raised scheduler_hw_host_wake_after cycles into an idle */
+static void (*scheduler_hw_host_wake_isr)(void) = NULL;
+
+/**
+ * Count the simulated Timer1 forward by @em cycles, calling the tick ISR on every period match
+ * while the timer and its interrupt are enabled.
+ */
+static inline void scheduler_hw_host_advance(unsigned long cycles)
+{
+    unsigned long remaining;
+
+    while( cycles > 0 && (T1CON & (1<<15)) )
+    {
+        remaining = (unsigned long)PR1 - TMR1;
+        if( cycles <= remaining )
+        {// No period match
+            TMR1 += cycles;
+            scheduler_hw_host_cycles += cycles;
+
+            return;
+        }
+
+        // Count up to the match and roll over
+        cycles -= remaining + 1;
+        scheduler_hw_host_cycles += remaining + 1;
+        TMR1 = 0;
+        IFS0bits.T1IF = 1;
+        if( IEC0bits.T1IE )
+        {
+            _T1Interrupt();
+        }
+    }
+}
+
+/**
+ * Idle until the next interrupt. Timer1 is the only wake source unless scheduler_hw_host_wake_isr
+ * is due first.
+ */
+static inline void scheduler_hw_host_idle(void)
+{
+    unsigned long to_match = (unsigned long)PR1 - TMR1 + 1;
+    void (*wake_isr)(void) = scheduler_hw_host_wake_isr;
+
+    ++scheduler_hw_host_idles;
+
+    if( scheduler_hw_host_wake_after > 0 && scheduler_hw_host_wake_after < to_match
+        && wake_isr != NULL )
+    {// Another interrupt wakes the device first
+        scheduler_hw_host_advance(scheduler_hw_host_wake_after);
+        scheduler_hw_host_wake_after = 0;
+        wake_isr();
+
+        return;
+    }
+
+    scheduler_hw_host_advance(to_match);
+}
+
+#define SCHEDULER_HW_IDLE() scheduler_hw_host_idle() /**< Idle until the next interrupt */
+/** Called by the main loop, without tickless idle, on each pass which found nothing to run. On host
+ * nothing else counts the simulated Timer1, so it is advanced to the next interrupt. */
+#define SCHEDULER_HW_POLL() scheduler_hw_host_idle()
+
+/* Preemptive band stand-ins
+ * Each band's software interrupt is a thread which waits for its flag and calls the band's vector
+ * at the band's interrupt priority level. Threads run alongside each other rather than preempting,
+ * which is enough to test that work reaches the right band at the right level. The band queue's
+ * critical section is a mutex.
+ */
+/** Guards the band queues */
+static __attribute__((unused)) pthread_mutex_t scheduler_hw_host_band_lock = PTHREAD_MUTEX_INITIALIZER;
+/** Guards the band interrupt flags */
+static pthread_mutex_t scheduler_hw_host_band_mutex = PTHREAD_MUTEX_INITIALIZER;
+/** Signalled when a band interrupt flag is set */
+static pthread_cond_t scheduler_hw_host_band_cond = PTHREAD_COND_INITIALIZER;
+/** Interrupt flag of each band, bit n-1 for band n */
+static unsigned int scheduler_hw_host_band_flags = 0;
+
+void _INT1Interrupt(void);
+void _INT2Interrupt(void);
+
+/** Arguments of a band thread */
+struct scheduler_hw_host_band_s
+{
+    unsigned int band;          /**< The band, from 1 */
+    unsigned int ipl;           /**< The band's interrupt priority level */
+    void (*vector)(void);       /**< The band's interrupt vector */
+};
+
+/**
+ * Band thread, calling the band's vector each time its flag is set.
+ */
+static inline void * scheduler_hw_host_band_thread(void *arg)
+{
+    const struct scheduler_hw_host_band_s *band = arg;
+
+    scheduler_hw_host_ipl = band->ipl;
+    for( ; ; )
+    {
+        pthread_mutex_lock(&scheduler_hw_host_band_mutex);
+        while( !(scheduler_hw_host_band_flags & (1U << (band->band-1))) )
+        {
+            pthread_cond_wait(&scheduler_hw_host_band_cond, &scheduler_hw_host_band_mutex);
+        }
+        pthread_mutex_unlock(&scheduler_hw_host_band_mutex);
+
+        band->vector();
+    }
+
+    return NULL;
+}
+
+/**
+ * Start the thread standing in for a band's software interrupt.
+ */
+static inline void scheduler_hw_host_band_init(unsigned int band, unsigned int ipl,
+                                               void (*vector)(void))
+{
+    static struct scheduler_hw_host_band_s bands[2];
+    pthread_t thread;
+
+    bands[band-1] = (struct scheduler_hw_host_band_s){band, ipl, vector};
+    pthread_create(&thread, NULL, &scheduler_hw_host_band_thread, &bands[band-1]);
+    pthread_detach(thread);
+}
+
+/**
+ * Set or clear a band's interrupt flag.
+ */
+static inline void scheduler_hw_host_band_flag(unsigned int band, int set)
+{
+    pthread_mutex_lock(&scheduler_hw_host_band_mutex);
+    if( set )
+    {
+        scheduler_hw_host_band_flags |= 1U << (band-1);
+        pthread_cond_broadcast(&scheduler_hw_host_band_cond);
+    }
+    else
+    {
+        scheduler_hw_host_band_flags &= ~(1U << (band-1));
+    }
+    pthread_mutex_unlock(&scheduler_hw_host_band_mutex);
+}
+
+#define SCHEDULER_HW_BAND_LOCK() pthread_mutex_lock(&scheduler_hw_host_band_lock) /**< Enter a band queue critical section */
+#define SCHEDULER_HW_BAND_UNLOCK() pthread_mutex_unlock(&scheduler_hw_host_band_lock) /**< Leave it */
+
+#define SCHEDULER_HW_BAND1_VECTOR _INT1Interrupt /**< Vector running band 1 */
+#define SCHEDULER_HW_BAND1_INIT() \
+    scheduler_hw_host_band_init(1, SCHEDULER_HW_BAND1_IPL, &_INT1Interrupt) /**< Enable band 1 */
+#define SCHEDULER_HW_BAND1_TRIGGER() scheduler_hw_host_band_flag(1, 1) /**< Raise band 1 */
+#define SCHEDULER_HW_BAND1_CLEAR() scheduler_hw_host_band_flag(1, 0) /**< Acknowledge band 1 */
+
+#define SCHEDULER_HW_BAND2_VECTOR _INT2Interrupt /**< Vector running band 2 */
+#define SCHEDULER_HW_BAND2_INIT() \
+    scheduler_hw_host_band_init(2, SCHEDULER_HW_BAND2_IPL, &_INT2Interrupt) /**< Enable band 2 */
+#define SCHEDULER_HW_BAND2_TRIGGER() scheduler_hw_host_band_flag(2, 1) /**< Raise band 2 */
+#define SCHEDULER_HW_BAND2_CLEAR() scheduler_hw_host_band_flag(2, 0) /**< Acknowledge band 2 */
+
+#elif defined(__XC16) || defined(__XC16__) || defined(XC16)
+// 16-bit compiler in use
+
+// Microchip peripheral libraries
+#include <p33Fxxxx.h>
+
+// Include hardware definitions
+#include "../def/board.def"
+
+/** Disable interrupts (up to priority 6) for the maximum DISI count */
+#define SCHEDULER_HW_DISABLE_INTERRUPTS() __asm__ volatile ("disi #0x3FFF")
+/** Reenable interrupts disabled by #SCHEDULER_HW_DISABLE_INTERRUPTS */
+#define SCHEDULER_HW_ENABLE_INTERRUPTS()  __asm__ volatile ("disi #0x0000")
+
+#define SCHEDULER_HW_ISR __attribute__((__interrupt__, no_auto_psv)) /**< ISR attribute */
+
+/** Current interrupt priority level, zero for the main loop */
+#define SCHEDULER_HW_CURRENT_IPL() (SRbits.IPL)
+
+/** Read a variable shared with another context. A single core with word sized accesses only needs
+ * the compiler kept from reordering around it. */
+#define SCHEDULER_HW_LOAD_ACQUIRE(var) \
+    ({ __typeof__(var) _v = *(volatile __typeof__(var) *)&(var); __asm__ volatile ("" : : : "memory"); _v; })
+/** Write a variable shared with another context, see #SCHEDULER_HW_LOAD_ACQUIRE */
+#define SCHEDULER_HW_STORE_RELEASE(var,value) \
+    do { __asm__ volatile ("" : : : "memory"); *(volatile __typeof__(var) *)&(var) = (value); } while(0)
+/** Set bits in a variable shared with another context */
+#define SCHEDULER_HW_ATOMIC_OR(var,mask) \
+    do { SCHEDULER_HW_DISABLE_INTERRUPTS(); (var) |= (mask); SCHEDULER_HW_ENABLE_INTERRUPTS(); } while(0)
+/** Clear the bits not in mask in a variable shared with another context */
+#define SCHEDULER_HW_ATOMIC_AND(var,mask) \
+    do { SCHEDULER_HW_DISABLE_INTERRUPTS(); (var) &= (mask); SCHEDULER_HW_ENABLE_INTERRUPTS(); } while(0)
+
+/** Enter Idle mode until the next interrupt. Called inside a DISI window: a peripheral interrupt
+ * still wakes the device, and is then serviced once interrupts are reenabled, so a wakeup raised
+ * after the scheduler decided to idle cannot be lost. */
+#define SCHEDULER_HW_IDLE() __asm__ volatile ("pwrsav #1")
+
+#define SCHEDULER_HW_POLL() /**< Nothing to run, Timer1 counts by itself */
+
+/* Preemptive bands
+ * The external interrupt vectors INT1 and INT2 are used as software interrupts: setting their flag
+ * raises them. Their pins must not be configured as external interrupt inputs elsewhere.
+ */
+#define SCHEDULER_HW_BAND_LOCK() SCHEDULER_HW_DISABLE_INTERRUPTS() /**< Enter a band queue critical section */
+#define SCHEDULER_HW_BAND_UNLOCK() SCHEDULER_HW_ENABLE_INTERRUPTS() /**< Leave it */
+
+#define SCHEDULER_HW_BAND1_VECTOR _INT1Interrupt /**< Vector running band 1 */
+#define SCHEDULER_HW_BAND1_INIT() \
+    do { IPC5bits.INT1IP = SCHEDULER_HW_BAND1_IPL; IFS1bits.INT1IF = 0; IEC1bits.INT1IE = 1; } while(0)
+#define SCHEDULER_HW_BAND1_TRIGGER() (IFS1bits.INT1IF = 1) /**< Raise band 1 */
+#define SCHEDULER_HW_BAND1_CLEAR() (IFS1bits.INT1IF = 0) /**< Acknowledge band 1 */
+
+#define SCHEDULER_HW_BAND2_VECTOR _INT2Interrupt /**< Vector running band 2 */
+#define SCHEDULER_HW_BAND2_INIT() \
+    do { IPC7bits.INT2IP = SCHEDULER_HW_BAND2_IPL; IFS1bits.INT2IF = 0; IEC1bits.INT2IE = 1; } while(0)
+#define SCHEDULER_HW_BAND2_TRIGGER() (IFS1bits.INT2IF = 1) /**< Raise band 2 */
+#define SCHEDULER_HW_BAND2_CLEAR() (IFS1bits.INT2IF = 0) /**< Acknowledge band 2 */
+
+#else
+#error "SCHEDULER: Unknown compiler!"
+#endif // Compiler check
+
+#endif //_SCHEDULER_HW_H
@@ -22,18 +22,317 @@
  *
  * @todo Move this section to a .def file.
  */
-// Maximum number of processes that may be scheduled at one time.
+// Maximum number of processes that may be scheduled at one time. This also sizes the static
+// process pool, so no heap memory is used by the scheduler.
+#ifndef SCHEDULE_LIST_LENGTH
 #define SCHEDULE_LIST_LENGTH 16
+#endif
+
+// Number of buckets in the timing wheel holding delayed processes. Must be a power of two. A delay
+// shorter than this many ticks is examined only once, on the tick it expires.
+#ifndef SCHEDULE_WHEEL_LENGTH
+#define SCHEDULE_WHEEL_LENGTH 32
+#endif
+
+#if SCHEDULE_LIST_LENGTH < 2
+#error "SCHEDULER: SCHEDULE_LIST_LENGTH must be at least two!"
+#endif
+
+#if (SCHEDULE_WHEEL_LENGTH & (SCHEDULE_WHEEL_LENGTH-1)) != 0
+#error "SCHEDULER: SCHEDULE_WHEEL_LENGTH must be a power of two!"
+#endif
+
+// Number of processes each interrupt priority level can queue, with schedule_from_isr(), before the
+// main loop collects them. Must be a power of two.
+#ifndef SCHEDULE_ISR_RING_LENGTH
+#define SCHEDULE_ISR_RING_LENGTH 8
+#endif
+
+#if (SCHEDULE_ISR_RING_LENGTH & (SCHEDULE_ISR_RING_LENGTH-1)) != 0
+#error "SCHEDULER: SCHEDULE_ISR_RING_LENGTH must be a power of two!"
+#endif
+
+// Dispatch policies. Under SCHEDULE_POLICY_FIFO ready processes run in order of their due tick,
+// the tick they were scheduled on plus their priority. Under SCHEDULE_POLICY_EDF they run in order
+// of their absolute deadline, earliest first, see schedule_deadline().
+#define SCHEDULE_POLICY_FIFO 0
+#define SCHEDULE_POLICY_EDF 1
+
+// Dispatch policy in use
+#ifndef SCHEDULE_POLICY
+#define SCHEDULE_POLICY SCHEDULE_POLICY_FIFO
+#endif
+
+#if SCHEDULE_POLICY != SCHEDULE_POLICY_FIFO && SCHEDULE_POLICY != SCHEDULE_POLICY_EDF
+#error "SCHEDULER: SCHEDULE_POLICY must be SCHEDULE_POLICY_FIFO or SCHEDULE_POLICY_EDF!"
+#endif
+
+// Bytes of context each coroutine keeps between runs, see schedule_coroutine(). Every process in the
+// pool reserves this much, rounded up to a whole number of longs.
+#ifndef SCHEDULE_CO_CONTEXT_SIZE
+#define SCHEDULE_CO_CONTEXT_SIZE 8
+#endif
+
+// Tickless idle. When nothing is ready to run, Timer1 is reprogrammed to expire on the next delayed
+// process (up to the longest period Timer1 can count) and the CPU idles until an interrupt.
+//#define SCHEDULE_TICKLESS
+
+// Per-function run time profiling, see scheduler_profile_get(). Everything it adds is compiled out
+// unless this is defined.
+//#define SCHEDULE_PROFILE
+
+// Number of distinct functions which the profiler can track
+#ifndef SCHEDULE_PROFILE_LENGTH
+#define SCHEDULE_PROFILE_LENGTH 16
+#endif
+
+// Size, in bytes, of the header and of each record written by scheduler_profile_dump()
+#define SCHEDULE_PROFILE_DUMP_HEADER_SIZE 10
+#define SCHEDULE_PROFILE_DUMP_RECORD_SIZE 36
+
+// Per-function execution budgets checked by the tick ISR, see scheduler_budget_set(). Everything it
+// adds is compiled out unless this is defined.
+//#define SCHEDULE_BUDGET
+
+// Number of distinct functions which can be given a budget
+#ifndef SCHEDULE_BUDGET_LENGTH
+#define SCHEDULE_BUDGET_LENGTH 8
+#endif
+
+// Number of consecutive runs over budget after which a function is demoted
+#ifndef SCHEDULE_BUDGET_STRIKES
+#define SCHEDULE_BUDGET_STRIKES 3
+#endif
+
+// Number of ticks each run of a demoted function is held back, so that other processes run first
+#ifndef SCHEDULE_BUDGET_BACKOFF
+#define SCHEDULE_BUDGET_BACKOFF 4
+#endif
+
+// Skip the runs of a demoted function instead of holding them back. A skipped periodic release
+// counts as an overrun and a skipped one-shot process is dropped. Coroutines are still held back.
+//#define SCHEDULE_BUDGET_SKIP
+
+// Number of preemptive priority bands, 0 to 2, see schedule_band(). Each band is a spare interrupt
+// vector used as a software interrupt, so work posted to a band preempts the main loop and any lower
+// band. Everything it adds is compiled out when this is 0.
+#ifndef SCHEDULE_BANDS
+#define SCHEDULE_BANDS 0
+#endif
+
+// Number of processes each band can queue. Must be a power of two.
+#ifndef SCHEDULE_BAND_LENGTH
+#define SCHEDULE_BAND_LENGTH 8
+#endif
+
+#if SCHEDULE_BANDS < 0 || SCHEDULE_BANDS > 2
+#error "SCHEDULER: SCHEDULE_BANDS must be between 0 and 2!"
+#endif
+
+#if (SCHEDULE_BAND_LENGTH & (SCHEDULE_BAND_LENGTH-1)) != 0
+#error "SCHEDULER: SCHEDULE_BAND_LENGTH must be a power of two!"
+#endif
     
 
 
+/** Public Data Structures
+ * These are the data structures passed to and from the public functions of the kernel.
+ */
+/**
+ * @brief Handle to a scheduled process, see schedule().
+ *
+ * @details A handle combines the process' place in the pool with a generation which changes each
+ * time the place is reused, so a handle to a process which has run no longer refers to anything.
+ * Zero is never a valid handle.
+ */
+typedef unsigned int scheduler_handle_t;
+
+// Returned by schedule() when called from an ISR. The process is queued and gets its place in the
+// schedule later, so it has no handle.
+#define SCHEDULER_HANDLE_DEFERRED ((scheduler_handle_t)1)
+
+/**
+ * @brief Run statistics of a periodic process, see schedule_periodic().
+ */
+struct scheduler_periodic_stats_s
+{
+    unsigned long releases;         /**< Number of times the process has run. */
+    unsigned int deadline_misses;   /**< Number of runs which completed after their deadline (the
+                                       next release). */
+    unsigned int overruns;          /**< Number of releases skipped because a run completed after
+                                       them. */
+};
+typedef struct scheduler_periodic_stats_s scheduler_periodic_stats_t;
+
+/**
+ * @brief Deadline violations of every process which has a deadline, see
+ * scheduler_deadline_stats().
+ */
+struct scheduler_deadline_stats_s
+{
+    unsigned long misses;           /**< Number of runs which completed after their deadline. */
+    unsigned long max_lateness;     /**< Most ticks a run completed after its deadline. */
+};
+typedef struct scheduler_deadline_stats_s scheduler_deadline_stats_t;
+
+/**
+ * @brief An event group which ISRs post to and processes wait on, see schedule_on_event().
+ *
+ * @details Posted bits stay set until a waiting process consumes them, so a post made before a
+ * process starts waiting is not lost. Initialize with scheduler_event_init() before use. The
+ * members are private to the scheduler.
+ */
+struct scheduler_event_s
+{
+    volatile unsigned int bits;             /**< Posted bits not yet consumed. */
+    struct process_s *waiters;              /**< Processes waiting on the event. */
+    struct scheduler_event_s *next_active;  /**< Next event with waiters. */
+    unsigned char active;                   /**< Whether the event is in the list of events with
+                                               waiters. */
+};
+typedef struct scheduler_event_s scheduler_event_t;
+
+/**
+ * @brief Resume point and context of a coroutine, see schedule_coroutine().
+ *
+ * @details The resume point is managed by the SCHEDULER_CO_ macros. The context is zeroed when the
+ * coroutine is scheduled and is otherwise left to the coroutine, see SCHEDULER_CO_CONTEXT().
+ */
+struct scheduler_co_s
+{
+    unsigned int resume;            /**< Line the coroutine resumes at, zero on its first run. */
+    unsigned long context[(SCHEDULE_CO_CONTEXT_SIZE + sizeof(unsigned long) - 1)
+                          / sizeof(unsigned long)]; /**< Context kept between runs. */
+};
+typedef struct scheduler_co_s scheduler_co_t;
+
+#if defined(SCHEDULE_PROFILE)
+/**
+ * @brief Run time profile of every process which ran a function, see scheduler_profile_get().
+ *
+ * @details Times are in Timer1 counts, SCHEDULER_HW_TICK_PERIOD+1 to a tick. Latency is measured
+ * from the moment a process became ready to run (it was scheduled, or its delay expired) to the
+ * moment it started running.
+ */
+struct scheduler_profile_s
+{
+    void (*func)(void *params);     /**< The function profiled. */
+    unsigned long runs;             /**< Number of times the function has run. */
+    unsigned long long total;       /**< Total execution time. */
+    unsigned long min;              /**< Shortest execution time. */
+    unsigned long max;              /**< Longest execution time. */
+    unsigned long long latency_total; /**< Total ready-to-run latency. */
+    unsigned long latency_max;      /**< Longest ready-to-run latency. */
+};
+typedef struct scheduler_profile_s scheduler_profile_t;
+#endif
+
+#if defined(SCHEDULE_BUDGET)
+/**
+ * @brief Execution budget and overrun record of a function, see scheduler_budget_set().
+ *
+ * @details A run overruns its budget once the tick ISR sees more than @em budget ticks pass since
+ * it started. After SCHEDULE_BUDGET_STRIKES consecutive overruns the function is demoted until a
+ * run completes within budget.
+ */
+struct scheduler_budget_s
+{
+    void (*func)(void *params);     /**< The function budgeted. */
+    unsigned int budget;            /**< Ticks a run may take, zero for no budget. */
+    unsigned int strikes;           /**< Consecutive runs over budget. */
+    unsigned long overruns;         /**< Total runs over budget. */
+    unsigned long max_overrun;      /**< Most ticks a run took over budget. */
+    unsigned long demotions;        /**< Runs held back or skipped while demoted. */
+};
+typedef struct scheduler_budget_s scheduler_budget_t;
+#endif
+
+
 /** Public Function Prototypes
  * These are the function prototypes for public functions implemented by the
  * kernel. These functions may be used outside the kernel.
  */
 void init_scheduler(void);
 void start_scheduler(void) __attribute__((noreturn));
-int schedule(void (*func)(void *), int priority, void *params);
+scheduler_handle_t schedule(void (*func)(void *), int priority, void *params);
+int schedule_from_isr(void (*func)(void *), int priority, void *params);
+int unschedule(scheduler_handle_t handle);
+int reschedule(scheduler_handle_t handle, int priority);
+scheduler_handle_t schedule_periodic(void (*func)(void *), unsigned int period_ticks,
+                                     unsigned int phase, void *params);
+int schedule_periodic_stats(void (*func)(void *), scheduler_periodic_stats_t *stats);
+scheduler_handle_t schedule_deadline(void (*func)(void *), unsigned int delay,
+                                     unsigned int deadline, void *params);
+void scheduler_deadline_stats(scheduler_deadline_stats_t *stats);
+void scheduler_on_deadline_miss(void (*callback)(void (*func)(void *), unsigned long lateness));
+unsigned long long scheduler_now_cycles(void);
+unsigned long long scheduler_now_us(void);
+void scheduler_event_init(scheduler_event_t *event);
+void scheduler_event_post(scheduler_event_t *event, unsigned int bits);
+void scheduler_event_clear(scheduler_event_t *event, unsigned int bits);
+scheduler_handle_t schedule_on_event(void (*func)(void *), scheduler_event_t *event,
+                                     unsigned int mask, unsigned int timeout, void *params);
+unsigned int scheduler_wake_bits(void);
+scheduler_handle_t schedule_coroutine(void (*func)(void *), int priority, void *params);
+scheduler_co_t * scheduler_co_self(void);
+int scheduler_co_sleep(unsigned int ticks);
+int scheduler_co_await(scheduler_event_t *event, unsigned int mask, unsigned int timeout);
+#if defined(SCHEDULE_PROFILE)
+int scheduler_profile_get(void (*func)(void *), scheduler_profile_t *profile);
+unsigned int scheduler_profile_dump(unsigned char *buffer, unsigned int length);
+void scheduler_profile_reset(void);
+#endif
+#if defined(SCHEDULE_BUDGET)
+int scheduler_budget_set(void (*func)(void *), unsigned int budget_ticks);
+int scheduler_budget_get(void (*func)(void *), scheduler_budget_t *budget);
+void scheduler_on_budget_overrun(void (*callback)(void (*func)(void *), unsigned long overrun));
+int scheduler_budget_exceeded(void);
+#endif
+#if SCHEDULE_BANDS > 0
+int schedule_band(unsigned int band, void (*func)(void *), void *params);
+#endif
+
+
+/** Coroutine Macros
+ * These macros write a function scheduled with schedule_coroutine() as sequential code which
+ * suspends and resumes. The function's body must be wrapped in SCHEDULER_CO_BEGIN() and
+ * SCHEDULER_CO_END(), and each run resumes at the point the last one suspended. Local variables are
+ * not kept between runs, anything which must be kept belongs in SCHEDULER_CO_CONTEXT() or
+ * @em params. A coroutine may not suspend inside a switch statement of its own, and two of these
+ * macros may not share a line. Returning from the function without suspending ends the coroutine.
+ */
+// Start the body of a coroutine, resuming where it last suspended
+#define SCHEDULER_CO_BEGIN() switch( scheduler_co_self()->resume ) { case 0:
+
+// End the body of a coroutine
+#define SCHEDULER_CO_END() }
+
+// Marks the deliberate fall through into a resume point for compilers which warn about it
+#if defined(__GNUC__) && __GNUC__ >= 7
+#define SCHEDULER_CO_FALLTHROUGH __attribute__((fallthrough));
+#else
+#define SCHEDULER_CO_FALLTHROUGH
+#endif
+
+// Suspend the coroutine if suspend is true, to resume on the following line when it runs again
+#define SCHEDULER_CO_SUSPEND(suspend) \
+    do { if( suspend ) { scheduler_co_self()->resume = __LINE__; return; } \
+         SCHEDULER_CO_FALLTHROUGH case __LINE__:; } while(0)
+
+// Let every other ready process run, then resume
+#define SCHEDULER_CO_YIELD() SCHEDULER_CO_SUSPEND(scheduler_co_sleep(0))
+
+// Resume after ticks ticks
+#define SCHEDULER_CO_SLEEP(ticks) SCHEDULER_CO_SUSPEND(scheduler_co_sleep(ticks))
+
+// Resume once any of the mask bits are posted to event, or after timeout ticks (zero waits
+// forever). scheduler_wake_bits() then returns the bits which were consumed, or zero on a timeout.
+#define SCHEDULER_CO_AWAIT(event, mask, timeout) \
+    SCHEDULER_CO_SUSPEND(scheduler_co_await((event), (mask), (timeout)))
+
+// The running coroutine's context, as a pointer to type. type may be at most
+// SCHEDULE_CO_CONTEXT_SIZE bytes.
+#define SCHEDULER_CO_CONTEXT(type) ((type *)scheduler_co_self()->context)
 
 
 
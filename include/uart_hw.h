@@ -5,6 +5,12 @@
  * @brief This file defines hardware specific macros for the UART library. It should only be called
  * from within the UART library.
  *
+ * @details When @c UART_HOST is defined the UART library is compiled for a host machine instead of
+ * the dsPIC33F. The UART registers and interrupt bits become plain variables and the critical
+ * section macros compile to nothing, so the driver logic can be exercised by the host programs in
+ * the test directory. The RX FIFO is simulated: uart_hw_host_rx_feed() receives a character, and
+ * reading UxRXREG through #UART_HW_READ_RXREG pops it, updating URXDA and FERR as the device does.
+ *
  * @author Liam Bucci
  * @date 6/14/2014
  * @carlnumber FIRM-0009
@@ -41,6 +47,183 @@
 #define UART_HW_BASE_ADDRESS_UART3 &U3MODE /**< Base address for UART 3 */
 #define UART_HW_BASE_ADDRESS_UART4 &U4MODE /**< Base address for UART 4 */
 
+#define UART_HW_FIFO_LENGTH 4 /**< Number of characters the TX and RX hardware FIFOs hold */
+
+#if defined(UART_HOST)
+// Host build, no hardware available
+
+#include <stdbool.h>
+
+#define UART_HW_HOST_SFRS 5 /**< UxMODE, UxSTA, UxTXREG, UxRXREG and UxBRG of one module */
+
+/** UART register stand-ins, laid out as on the device so that the offsets from UxMODE hold */
+static volatile unsigned int uart_hw_host_sfr[4][UART_HW_HOST_SFRS];
+#define U1MODE (uart_hw_host_sfr[0][0])
+#define U2MODE (uart_hw_host_sfr[1][0])
+#define U3MODE (uart_hw_host_sfr[2][0])
+#define U4MODE (uart_hw_host_sfr[3][0])
+
+/* Interrupt bit stand-ins */
+static volatile struct { unsigned int U1RXIF, U1TXIF; } IFS0bits;
+static volatile struct { unsigned int U1RXIE, U1TXIE; } IEC0bits;
+static volatile struct { unsigned int U2RXIF, U2TXIF; } IFS1bits;
+static volatile struct { unsigned int U2RXIE, U2TXIE; } IEC1bits;
+static volatile struct { unsigned int U3RXIF, U3TXIF, U4RXIF, U4TXIF; } IFS5bits;
+static volatile struct { unsigned int U3RXIE, U3TXIE, U4RXIE, U4TXIE; } IEC5bits;
+
+#define UART_HW_HOST_URXDA 0x0001 /**< UxSTA bit set while the RX FIFO holds a character */
+#define UART_HW_HOST_FERR  0x0004 /**< UxSTA bit set if the character on top had no stop bit */
+
+/** Simulated RX FIFO of each module */
+static struct
+{
+    unsigned int characters[UART_HW_FIFO_LENGTH]; /**< Characters received, oldest at head */
+    bool framing[UART_HW_FIFO_LENGTH];            /**< Whether each character had no stop bit */
+    unsigned int head;                            /**< Index of the oldest character */
+    unsigned int count;                           /**< Number of characters waiting */
+} uart_hw_host_rx[4];
+
+/**
+ * Set URXDA and FERR of the module at @em index from the character on top of its RX FIFO.
+ */
+static inline void uart_hw_host_rx_status(unsigned int index)
+{
+    volatile unsigned int *sta = &uart_hw_host_sfr[index][1];
+
+    *sta &= ~(UART_HW_HOST_URXDA | UART_HW_HOST_FERR);
+    if( uart_hw_host_rx[index].count > 0 )
+    {// Character waiting
+        *sta |= UART_HW_HOST_URXDA;
+        if( uart_hw_host_rx[index].framing[uart_hw_host_rx[index].head] )
+        {
+            *sta |= UART_HW_HOST_FERR;
+        }
+    }
+}
+
+/**
+ * Receive @em character into the RX FIFO of UART @em number as if it arrived from the bus,
+ * @em framing if it had no stop bit. A break reads as a zero character with no stop bit.
+ *
+ * @return True if the character fit in the FIFO.
+ */
+static inline bool uart_hw_host_rx_feed(unsigned int number,
+                                        unsigned int character,
+                                        bool framing)
+{
+    unsigned int index = number - 1;
+    unsigned int tail;
+
+    if( uart_hw_host_rx[index].count >= UART_HW_FIFO_LENGTH )
+    {// FIFO full, the device would overrun
+        return false;
+    }
+
+    tail = (uart_hw_host_rx[index].head + uart_hw_host_rx[index].count) % UART_HW_FIFO_LENGTH;
+    uart_hw_host_rx[index].characters[tail] = character;
+    uart_hw_host_rx[index].framing[tail] = framing;
+    uart_hw_host_rx[index].count++;
+    uart_hw_host_rx_status(index);
+
+    return true;
+}
+
+/**
+ * Read UxRXREG through @em rxreg, popping the RX FIFO of its module as the device does.
+ */
+static inline unsigned int uart_hw_host_rx_read(volatile unsigned int *rxreg)
+{
+    unsigned int index = (unsigned int)(rxreg - &uart_hw_host_sfr[0][0]) / UART_HW_HOST_SFRS;
+
+    if( uart_hw_host_rx[index].count > 0 )
+    {// Pop the oldest character into UxRXREG
+        *rxreg = uart_hw_host_rx[index].characters[uart_hw_host_rx[index].head];
+        uart_hw_host_rx[index].head = (uart_hw_host_rx[index].head + 1) % UART_HW_FIFO_LENGTH;
+        uart_hw_host_rx[index].count--;
+        uart_hw_host_rx_status(index);
+    }
+
+    return *rxreg;
+}
+
+#define UART_HW_READ_RXREG(rxreg) uart_hw_host_rx_read(rxreg) /**< Pop the simulated RX FIFO */
+
+#else
+
+/**
+ * Read the character on top of the RX FIFO through @em rxreg, a pointer to UxRXREG. The read pops
+ * the FIFO, so every read of UxRXREG goes through this macro for the host build to simulate it.
+ */
+#define UART_HW_READ_RXREG(rxreg) (*(rxreg))
+
+#endif
+
+/* Set Interrupt Bits */
+
+/**
+ * Set or clear one interrupt bit of a UART module. @em reg is IFS or IEC and @em bit is RXIF, TXIF,
+ * RXIE or TXIE. Each bit is written through its own bit field with a constant value, which XC16
+ * compiles to a single BSET or BCLR. The IFS and IEC registers are shared with Timer1, the DMA
+ * channels and other peripherals, and a read-modify-write of the whole register would lose a flag
+ * raised, or an enable changed by an ISR, between the read and the write.
+ */
+#define UART_HW_INTERRUPT_BIT_UART1(reg,bit,value) ((reg##0bits).U1##bit = (value))
+#define UART_HW_INTERRUPT_BIT_UART2(reg,bit,value) ((reg##1bits).U2##bit = (value)) /**< @copydoc UART_HW_INTERRUPT_BIT_UART1 */
+#if UART_HW_NUMBER_OF_MODULES >= 3
+#define UART_HW_INTERRUPT_BIT_UART3(reg,bit,value) ((reg##5bits).U3##bit = (value)) /**< @copydoc UART_HW_INTERRUPT_BIT_UART1 */
+#else
+#define UART_HW_INTERRUPT_BIT_UART3(reg,bit,value) ((void)0) /**< No UART 3 on this chip */
+#endif
+#if UART_HW_NUMBER_OF_MODULES >= 4
+#define UART_HW_INTERRUPT_BIT_UART4(reg,bit,value) ((reg##5bits).U4##bit = (value)) /**< @copydoc UART_HW_INTERRUPT_BIT_UART1 */
+#else
+#define UART_HW_INTERRUPT_BIT_UART4(reg,bit,value) ((void)0) /**< No UART 4 on this chip */
+#endif
+
+/**
+ * Set or clear one interrupt bit of the UART module numbered @em number, see
+ * #UART_HW_INTERRUPT_BIT_UART1.
+ */
+#define UART_HW_INTERRUPT_BIT(number,reg,bit,value) \
+    do { \
+        switch( number ) \
+        { \
+        case 1: UART_HW_INTERRUPT_BIT_UART1(reg,bit,value); break; \
+        case 2: UART_HW_INTERRUPT_BIT_UART2(reg,bit,value); break; \
+        case 3: UART_HW_INTERRUPT_BIT_UART3(reg,bit,value); break; \
+        case 4: UART_HW_INTERRUPT_BIT_UART4(reg,bit,value); break; \
+        default: break; \
+        } \
+    } while(0)
+
+/* Set DMA Request Sources */
+
+#define UART_HW_DMA_TX_IRQ_UART1 DMA_IRQ_UART1TX /**< DMA request raised by UART 1 TX */
+#define UART_HW_DMA_TX_IRQ_UART2 DMA_IRQ_UART2TX /**< DMA request raised by UART 2 TX */
+
+#define UART_HW_DMA_TX_PERIPHERAL_UART1 DMA_PERIPHERAL_U1TXREG /**< DMA target of UART 1 TX */
+#define UART_HW_DMA_TX_PERIPHERAL_UART2 DMA_PERIPHERAL_U2TXREG /**< DMA target of UART 2 TX */
+
+#define UART_HW_DMA_RX_IRQ_UART1 DMA_IRQ_UART1RX /**< DMA request raised by UART 1 RX */
+#define UART_HW_DMA_RX_IRQ_UART2 DMA_IRQ_UART2RX /**< DMA request raised by UART 2 RX */
+
+#define UART_HW_DMA_RX_PERIPHERAL_UART1 DMA_PERIPHERAL_U1RXREG /**< DMA source of UART 1 RX */
+#define UART_HW_DMA_RX_PERIPHERAL_UART2 DMA_PERIPHERAL_U2RXREG /**< DMA source of UART 2 RX */
+
+/* Critical Sections */
+
+/**
+ * Enter a critical section shared with the UART and DMA ISRs. DISI holds off every interrupt below
+ * level 7 for up to 0x3FFF cycles, the section must be shorter than that.
+ */
+#if defined(UART_HOST)
+#define UART_HW_DISABLE_INTERRUPTS() /**< Enter a critical section (nothing on host) */
+#define UART_HW_ENABLE_INTERRUPTS()  /**< Leave a critical section (nothing on host) */
+#else
+#define UART_HW_DISABLE_INTERRUPTS() __asm__ volatile ("disi #0x3FFF")
+#define UART_HW_ENABLE_INTERRUPTS()  __asm__ volatile ("disi #0x0000") /**< Leave a critical section */
+#endif
+
 /* Set Baudrate Constants */
 
 // _FCY_ must be defined to set baudrate, unless manually setting baudrate
@@ -48,142 +231,189 @@
     #error "UART: Must supply _FCY_ in order to set baudrate correctly, or manually set baudrate."
 #endif
 
-// Define BRGH value
-#define UART_HW_BRGH 1
-
-// Define BRG values depending on Fcy
-#if _FCY_ == 2000000 // Fcy is 2MHz
-#define UART_HW_BRG_1200 415
-#define UART_HW_BRG_2400 207
-#define UART_HW_BRG_4800 103
-#define UART_HW_BRG_9600 51
-#define UART_HW_BRG_19200 25
-#define UART_HW_BRG_38400 12
-#define UART_HW_BRG_57600 7
-#define UART_HW_BRG_115200 3
-#define UART_HW_BRG_230400 1
-#define UART_HW_BRG_460800 0
-#define UART_HW_BRG_921600 0
-#define UART_HW_BRG_1000000 0
-#define UART_HW_BRG_1843200 0
-#define UART_HW_BRG_2000000 0
-#define UART_HW_BRG_3686400 0
-#elif _FCY_ == 3000000 // Fcy is 3MHz
-#define UART_HW_BRG_1200 624
-#define UART_HW_BRG_2400 311
-#define UART_HW_BRG_4800 155
-#define UART_HW_BRG_9600 77
-#define UART_HW_BRG_19200 38
-#define UART_HW_BRG_38400 18
-#define UART_HW_BRG_57600 12
-#define UART_HW_BRG_115200 5
-#define UART_HW_BRG_230400 2
-#define UART_HW_BRG_460800 0
-#define UART_HW_BRG_921600 0
-#define UART_HW_BRG_1000000 0
-#define UART_HW_BRG_1843200 0
-#define UART_HW_BRG_2000000 0
-#define UART_HW_BRG_3686400 0
-#elif _FCY_ == 4000000 // Fcy is 4MHz
-#define UART_HW_BRG_1200 832
-#define UART_HW_BRG_2400 415
-#define UART_HW_BRG_4800 207
-#define UART_HW_BRG_9600 103
-#define UART_HW_BRG_19200 51
-#define UART_HW_BRG_38400 25
-#define UART_HW_BRG_57600 16
-#define UART_HW_BRG_115200 7
-#define UART_HW_BRG_230400 3
-#define UART_HW_BRG_460800 1
-#define UART_HW_BRG_921600 0
-#define UART_HW_BRG_1000000 0
-#define UART_HW_BRG_1843200 0
-#define UART_HW_BRG_2000000 0
-#define UART_HW_BRG_3686400 0
-#elif _FCY_ == 6000000 // Fcy is 6MHz
-#define UART_HW_BRG_1200 1249
-#define UART_HW_BRG_2400 624
-#define UART_HW_BRG_4800 311
-#define UART_HW_BRG_9600 155
-#define UART_HW_BRG_19200 77
-#define UART_HW_BRG_38400 38
-#define UART_HW_BRG_57600 25
-#define UART_HW_BRG_115200 12
-#define UART_HW_BRG_230400 5
-#define UART_HW_BRG_460800 2
-#define UART_HW_BRG_921600 0
-#define UART_HW_BRG_1000000 0
-#define UART_HW_BRG_1843200 0
-#define UART_HW_BRG_2000000 0
-#define UART_HW_BRG_3686400 0
-#elif _FCY_ == 10000000 // Fcy is 10MHz
-#define UART_HW_BRG_1200 2082
-#define UART_HW_BRG_2400 1040
-#define UART_HW_BRG_4800 519
-#define UART_HW_BRG_9600 259
-#define UART_HW_BRG_19200 129
-#define UART_HW_BRG_38400 64
-#define UART_HW_BRG_57600 42
-#define UART_HW_BRG_115200 20
-#define UART_HW_BRG_230400 9
-#define UART_HW_BRG_460800 4
-#define UART_HW_BRG_921600 1
-#define UART_HW_BRG_1000000 1
-#define UART_HW_BRG_1843200 0
-#define UART_HW_BRG_2000000 0
-#define UART_HW_BRG_3686400 0
-#elif _FCY_ == 12000000 // Fcy is 12MHz
-#define UART_HW_BRG_1200 2499
-#define UART_HW_BRG_2400 1249
-#define UART_HW_BRG_4800 624
-#define UART_HW_BRG_9600 311
-#define UART_HW_BRG_19200 155
-#define UART_HW_BRG_38400 77
-#define UART_HW_BRG_57600 51
-#define UART_HW_BRG_115200 25
-#define UART_HW_BRG_230400 12
-#define UART_HW_BRG_460800 5
-#define UART_HW_BRG_921600 2
-#define UART_HW_BRG_1000000 2
-#define UART_HW_BRG_1843200 0
-#define UART_HW_BRG_2000000 0
-#define UART_HW_BRG_3686400 0
-#elif _FCY_ == 20000000 // Fcy is 20MHz
-#define UART_HW_BRG_1200 4165
-#define UART_HW_BRG_2400 2082
-#define UART_HW_BRG_4800 1040
-#define UART_HW_BRG_9600 519
-#define UART_HW_BRG_19200 259
-#define UART_HW_BRG_38400 129
-#define UART_HW_BRG_57600 85
-#define UART_HW_BRG_115200 42
-#define UART_HW_BRG_230400 20
-#define UART_HW_BRG_460800 9
-#define UART_HW_BRG_921600 4
-#define UART_HW_BRG_1000000 4
-#define UART_HW_BRG_1843200 1
-#define UART_HW_BRG_2000000 1
-#define UART_HW_BRG_3686400 0
-#elif _FCY_ == 40000000 // Fcy is 40MHz
-#define UART_HW_BRG_1200 8332
-#define UART_HW_BRG_2400 4165
-#define UART_HW_BRG_4800 2082
-#define UART_HW_BRG_9600 1040
-#define UART_HW_BRG_19200 519
-#define UART_HW_BRG_38400 259
-#define UART_HW_BRG_57600 172
-#define UART_HW_BRG_115200 85
-#define UART_HW_BRG_230400 42
-#define UART_HW_BRG_460800 20
-#define UART_HW_BRG_921600 9
-#define UART_HW_BRG_1000000 9
-#define UART_HW_BRG_1843200 4
-#define UART_HW_BRG_2000000 4
-#define UART_HW_BRG_3686400 1
-#else // Unknown Fcy
-#error "UART: Fcy is unknown and the baudrate should be set manually."
+// Largest bit time error accepted for a baud rate
+#ifndef UART_DEF_BAUD_ERROR_PPM
+#define UART_DEF_BAUD_ERROR_PPM 20000UL /**< Largest bit time error in ppm (2%) @default */
 #endif
 
+#define UART_HW_BRG_MAX 0xFFFFUL /**< Largest value of the UxBRG register */
+#define UART_HW_DIV_BRGH 4UL     /**< Fcy cycles per BRG count with BRGH set */
+#define UART_HW_DIV_BRGL 16UL    /**< Fcy cycles per BRG count with BRGH clear */
+#define UART_HW_BAUD_ERROR_INVALID 1000000UL /**< Error of a baud rate the BRG cannot reach */
+
+/**
+ * @brief The BRG+1 count which best approximates a baud rate, rounded to nearest.
+ *
+ * @details Each bit lasts @em div*(BRG+1) Fcy cycles, so rounding Fcy/(div*baud) gives the count
+ * with the smallest bit time error. All of the calculator macros are constant expressions when
+ * their arguments are, and use no casts, so they may be used in @c \#if. They are meant for
+ * compile time constants only, since they expand the count and error of each divisor several
+ * times; #uart_hw_brg_calc() works out the same settings at run time. XC16's unsigned long is 32
+ * bits, so @em div*baud wraps for rates far above any the module can generate.
+ * #UART_HW_BRG_ERROR and #uart_hw_brg_calc() reject rates above Fcy/#UART_HW_DIV_BRGH before the
+ * count is calculated.
+ */
+#define UART_HW_BRG_COUNT(fcy, baud, div) \
+    ( ((fcy) + (div)*(baud)/2) / ((div)*(baud)) )
+
+/** Absolute difference of two unsigned values */
+#define UART_HW_ABS_DIFF(a, b) ( (a) > (b) ? (a)-(b) : (b)-(a) )
+
+/**
+ * @brief The bit time error in ppm of the best BRG count for a baud rate and divisor, or
+ * #UART_HW_BAUD_ERROR_INVALID if the rate is above Fcy/#UART_HW_DIV_BRGH or that count does not
+ * fit in the BRG register.
+ */
+#define UART_HW_BRG_ERROR(fcy, baud, div) \
+    ( ((baud) > (fcy)/UART_HW_DIV_BRGH || UART_HW_BRG_COUNT(fcy, baud, div) == 0 \
+       || UART_HW_BRG_COUNT(fcy, baud, div) > UART_HW_BRG_MAX+1) \
+      ? UART_HW_BAUD_ERROR_INVALID \
+      : UART_HW_ABS_DIFF(1ULL*(fcy), 1ULL*(div)*(baud)*UART_HW_BRG_COUNT(fcy, baud, div)) * 1000000ULL / (fcy) )
+
+/** 1 if BRGH set gives a lower error for the baud rate than BRGH clear, which is kept when they
+ * tie since it takes the majority of three samples of each bit */
+#define UART_HW_BRGH_FOR(fcy, baud) \
+    ( UART_HW_BRG_ERROR(fcy, baud, UART_HW_DIV_BRGH) < UART_HW_BRG_ERROR(fcy, baud, UART_HW_DIV_BRGL) ? 1 : 0 )
+
+/** The BRG value for the baud rate, to be used with #UART_HW_BRGH_FOR */
+#define UART_HW_BRG_FOR(fcy, baud) \
+    ( UART_HW_BRGH_FOR(fcy, baud) ? UART_HW_BRG_COUNT(fcy, baud, UART_HW_DIV_BRGH)-1 \
+                                  : UART_HW_BRG_COUNT(fcy, baud, UART_HW_DIV_BRGL)-1 )
+
+/** The bit time error in ppm of the baud rate with #UART_HW_BRGH_FOR and #UART_HW_BRG_FOR */
+#define UART_HW_BAUD_ERROR_FOR(fcy, baud) \
+    ( UART_HW_BRGH_FOR(fcy, baud) ? UART_HW_BRG_ERROR(fcy, baud, UART_HW_DIV_BRGH) \
+                                  : UART_HW_BRG_ERROR(fcy, baud, UART_HW_DIV_BRGL) )
+
+/**
+ * @brief Calculate the best BRG+1 count for a baud rate and divisor, and its bit time error.
+ *
+ * @details Works as #UART_HW_BRG_COUNT and #UART_HW_BRG_ERROR, but calculates the count once.
+ *
+ * @param[in]  fcy
+ *             The instruction clock in Hz.
+ * @param[in]  baud
+ *             The baud rate in Hz, at most Fcy/#UART_HW_DIV_BRGH.
+ * @param[in]  div
+ *             #UART_HW_DIV_BRGH or #UART_HW_DIV_BRGL.
+ * @param[out] count
+ *             Set to the BRG+1 count.
+ * @return The bit time error in ppm, or #UART_HW_BAUD_ERROR_INVALID if the count does not fit in
+ * the BRG register.
+ */
+static inline unsigned long uart_hw_brg_div_calc(unsigned long fcy,
+                                                 unsigned long baud,
+                                                 unsigned long div,
+                                                 unsigned long *count)
+{
+    unsigned long cycles = div*baud;
+
+    *count = (fcy + cycles/2) / cycles;
+    if( *count == 0 || *count > UART_HW_BRG_MAX+1 )
+    {// Count does not fit in the BRG register
+        return UART_HW_BAUD_ERROR_INVALID;
+    }
+
+    return (unsigned long)(UART_HW_ABS_DIFF(1ULL*fcy, 1ULL*cycles*(*count)) * 1000000ULL / fcy);
+}
+
+/**
+ * @brief Calculate the BRGH and BRG settings which best generate a baud rate.
+ *
+ * @param[in]  fcy
+ *             The instruction clock in Hz.
+ * @param[in]  baud
+ *             The baud rate in Hz.
+ * @param[out] brgh
+ *             Set to the BRGH bit value.
+ * @param[out] brg
+ *             Set to the UxBRG register value.
+ * @return The bit time error in ppm, or #UART_HW_BAUD_ERROR_INVALID if the rate cannot be
+ * generated, in which case @em brgh and @em brg are not set. Rates above Fcy/#UART_HW_DIV_BRGH
+ * are rejected before any arithmetic, so @em div*baud cannot wrap in 32 bits.
+ */
+static inline unsigned long uart_hw_brg_calc(unsigned long fcy,
+                                             unsigned long baud,
+                                             unsigned int *brgh,
+                                             unsigned int *brg)
+{
+    unsigned long error_h, error_l;
+    unsigned long count_h, count_l;
+
+    if( fcy == 0 || baud == 0 )
+    {// No clock or no rate
+        return UART_HW_BAUD_ERROR_INVALID;
+    }
+
+    if( baud > fcy/UART_HW_DIV_BRGH )
+    {// Faster than BRG = 0 with BRGH set, and div*baud may wrap
+        return UART_HW_BAUD_ERROR_INVALID;
+    }
+
+    error_h = uart_hw_brg_div_calc(fcy, baud, UART_HW_DIV_BRGH, &count_h);
+    error_l = uart_hw_brg_div_calc(fcy, baud, UART_HW_DIV_BRGL, &count_l);
+
+    // BRGH clear is kept on a tie, as by #UART_HW_BRGH_FOR
+    if( error_h < error_l )
+    {// BRGH set is closer
+        *brgh = 1;
+        *brg = count_h - 1;
+
+        return error_h;
+    }
+
+    if( error_l != UART_HW_BAUD_ERROR_INVALID )
+    {// Rate reachable with BRGH clear
+        *brgh = 0;
+        *brg = count_l - 1;
+    }
+
+    return error_l;
+}
+
+#if defined(_FCY_)
+
+// Define BRGH and BRG values of the standard baud rates for Fcy
+#define UART_HW_BRGH_1200 UART_HW_BRGH_FOR(_FCY_, 1200UL)
+#define UART_HW_BRG_1200 UART_HW_BRG_FOR(_FCY_, 1200UL)
+#define UART_HW_BRGH_2400 UART_HW_BRGH_FOR(_FCY_, 2400UL)
+#define UART_HW_BRG_2400 UART_HW_BRG_FOR(_FCY_, 2400UL)
+#define UART_HW_BRGH_4800 UART_HW_BRGH_FOR(_FCY_, 4800UL)
+#define UART_HW_BRG_4800 UART_HW_BRG_FOR(_FCY_, 4800UL)
+#define UART_HW_BRGH_9600 UART_HW_BRGH_FOR(_FCY_, 9600UL)
+#define UART_HW_BRG_9600 UART_HW_BRG_FOR(_FCY_, 9600UL)
+#define UART_HW_BRGH_19200 UART_HW_BRGH_FOR(_FCY_, 19200UL)
+#define UART_HW_BRG_19200 UART_HW_BRG_FOR(_FCY_, 19200UL)
+#define UART_HW_BRGH_38400 UART_HW_BRGH_FOR(_FCY_, 38400UL)
+#define UART_HW_BRG_38400 UART_HW_BRG_FOR(_FCY_, 38400UL)
+#define UART_HW_BRGH_57600 UART_HW_BRGH_FOR(_FCY_, 57600UL)
+#define UART_HW_BRG_57600 UART_HW_BRG_FOR(_FCY_, 57600UL)
+#define UART_HW_BRGH_115200 UART_HW_BRGH_FOR(_FCY_, 115200UL)
+#define UART_HW_BRG_115200 UART_HW_BRG_FOR(_FCY_, 115200UL)
+#define UART_HW_BRGH_230400 UART_HW_BRGH_FOR(_FCY_, 230400UL)
+#define UART_HW_BRG_230400 UART_HW_BRG_FOR(_FCY_, 230400UL)
+#define UART_HW_BRGH_460800 UART_HW_BRGH_FOR(_FCY_, 460800UL)
+#define UART_HW_BRG_460800 UART_HW_BRG_FOR(_FCY_, 460800UL)
+#define UART_HW_BRGH_921600 UART_HW_BRGH_FOR(_FCY_, 921600UL)
+#define UART_HW_BRG_921600 UART_HW_BRG_FOR(_FCY_, 921600UL)
+#define UART_HW_BRGH_1000000 UART_HW_BRGH_FOR(_FCY_, 1000000UL)
+#define UART_HW_BRG_1000000 UART_HW_BRG_FOR(_FCY_, 1000000UL)
+#define UART_HW_BRGH_1843200 UART_HW_BRGH_FOR(_FCY_, 1843200UL)
+#define UART_HW_BRG_1843200 UART_HW_BRG_FOR(_FCY_, 1843200UL)
+#define UART_HW_BRGH_2000000 UART_HW_BRGH_FOR(_FCY_, 2000000UL)
+#define UART_HW_BRG_2000000 UART_HW_BRG_FOR(_FCY_, 2000000UL)
+#define UART_HW_BRGH_3686400 UART_HW_BRGH_FOR(_FCY_, 3686400UL)
+#define UART_HW_BRG_3686400 UART_HW_BRG_FOR(_FCY_, 3686400UL)
+
+// Fail the build if the baud rate the application needs cannot be generated from Fcy
+#if defined(UART_DEF_BAUDRATE)
+#if UART_HW_BAUD_ERROR_FOR(_FCY_, UART_DEF_BAUDRATE) > UART_DEF_BAUD_ERROR_PPM
+#error "UART: _FCY_ cannot generate UART_DEF_BAUDRATE within UART_DEF_BAUD_ERROR_PPM."
+#endif
+#endif
+
+#endif // defined(_FCY_)
+
 #endif //_UART_HW_H
 
 /**
@@ -0,0 +1,112 @@
+/* -*- mode: C; tab-width: 4; -*- */
+/**
+ * @file uart_lin.h
+ *
+ * @brief This file defines the protocol helpers of the LIN 2.x engine in the UART library.
+ *
+ * @details A LIN frame is a header sent by the master, made of a break, the 0x55 sync character
+ * and the protected identifier (PID), followed by a response of one to eight data bytes and a
+ * checksum, sent by whichever node publishes the frame. The PID carries the six bit frame
+ * identifier in bits 0 to 5 and two parity bits in bits 6 and 7. The checksum is the inverted
+ * eight bit sum with carry of the data bytes, which the enhanced checksum of LIN 2.x extends to
+ * cover the PID. Diagnostic frames always use the classic checksum.
+ *
+ * The header has no hardware dependencies, so it also builds on a host machine.
+ *
+ * @date 10/16/2026
+ * @carlnumber FIRM-0009
+ * @version 0.4.0
+ */
+
+/**
+ * @ingroup uart_module
+ *
+ * @{
+ */
+
+#ifndef _UART_LIN_H
+#define _UART_LIN_H
+
+#include <stdbool.h>
+
+#define UART_LIN_MAX_DATA 8      /**< The most data bytes a LIN response may carry */
+#define UART_LIN_SYNC 0x55       /**< The sync character which follows the break */
+#define UART_LIN_ID_MASK 0x3F    /**< The frame identifier bits of a PID */
+#define UART_LIN_ID_DIAGNOSTIC 0x3C /**< The first diagnostic frame identifier, which with those
+                                       after it always uses the classic checksum */
+
+/**
+ * @brief Returns the protected identifier of a frame identifier.
+ *
+ * @details P0 (bit 6) is ID0 ^ ID1 ^ ID2 ^ ID4 and P1 (bit 7) is the inverse of
+ * ID1 ^ ID3 ^ ID4 ^ ID5.
+ *
+ * @param[in]  id
+ *             The frame identifier, only its low six bits are used.
+ * @return The PID.
+ *
+ * @public
+ */
+static inline unsigned char uart_lin_pid(unsigned char id)
+{
+    unsigned char p0, p1;
+
+    id &= UART_LIN_ID_MASK;
+    p0 = (id ^ (id >> 1) ^ (id >> 2) ^ (id >> 4)) & 0x01;
+    p1 = ~((id >> 1) ^ (id >> 3) ^ (id >> 4) ^ (id >> 5)) & 0x01;
+
+    return id | (p0 << 6) | (p1 << 7);
+}
+
+/**
+ * @brief Returns true if the parity bits of a PID match its frame identifier.
+ *
+ * @public
+ */
+static inline bool uart_lin_pid_is_valid(unsigned char pid)
+{
+    return uart_lin_pid(pid) == pid;
+}
+
+/**
+ * @brief Returns the checksum of a LIN response.
+ *
+ * @param[in]  pid
+ *             The protected identifier of the frame, only used by the enhanced checksum.
+ * @param[in]  data
+ *             The data bytes of the response.
+ * @param[in]  length
+ *             The number of data bytes.
+ * @param[in]  enhanced
+ *             True for the LIN 2.x enhanced checksum, which includes the PID, false for the
+ *             classic checksum. The caller must pass false for diagnostic frames.
+ * @return The checksum byte.
+ *
+ * @public
+ */
+static inline unsigned char uart_lin_checksum(unsigned char pid,
+                                              const unsigned char *data,
+                                              unsigned int length,
+                                              bool enhanced)
+{
+    unsigned int sum = enhanced ? pid : 0;
+    unsigned int index;
+
+    for( index = 0; index < length; index++ )
+    {
+        // Add with carry, folding the carry straight back in
+        sum += data[index];
+        if( sum > 0xFF )
+        {
+            sum -= 0xFF;
+        }
+    }
+
+    return (unsigned char)~sum;
+}
+
+#endif // _UART_LIN_H
+
+/**
+ * @}
+ */
@@ -50,6 +50,9 @@
 // Include DMA channel functionality
 #include <dma_channel.h>
 
+// Include LIN protocol helpers
+#include <uart_lin.h>
+
 /* Public Enumerations Definitions */
 
 /**
@@ -152,14 +155,22 @@ enum uart_mode_e
     UART_MINOR_MODE_STD_8E2        = 0x0050, /**< 8 data bits, even parity, 2 stop bits */
 
     // 9-bit bit format
+    UART_MINOR_MODE_9BIT_FORMAT_BITMASK = 0x0010, /**< Bitmask for 9-bit bit formats */
     UART_MINOR_MODE_9BIT_9N1       = 0x0000, /**< 9 data bits, no parity, 1 stop bit @default */
     UART_MINOR_MODE_9BIT_9N2       = 0x0010, /**< 9 data bits, no parity, 2 stop bits */
 
     // 9-bit addressing
+    UART_MINOR_MODE_9BIT_ADDR_BITMASK = 0x0060, /**< Bitmask for 9-bit addressing, which may be
+                                                 * combined with a 9-bit bit format */
     UART_MINOR_MODE_9BIT_DATA      = 0x0000, /**< Treat bytes as data @default */
     UART_MINOR_MODE_9BIT_ADDR_MASK = 0x0020, /**< Mask bytes not bound for this device */
     UART_MINOR_MODE_9BIT_ADDR_PROM = 0x0040, /**< Listen to all bytes, regardless of address */
 
+    // LIN node settings
+    UART_MINOR_MODE_LIN_MASTER     = 0x0000, /**< LIN master node, which sends the headers of
+                                              * its schedule table @default */
+    UART_MINOR_MODE_LIN_SLAVE      = 0x0010, /**< LIN slave node, which only responds to headers */
+
     // IrDA encoder/decoder settings
     UART_MINOR_MODE_IRDA_INTERNAL  = 0x0000, /**< Use the internal IrDA encoder and decoder @default */
     UART_MINOR_MODE_IRDA_EXTERNAL  = 0x0010, /**< Use an external IrDA encoder and decoder */
@@ -216,9 +227,9 @@ typedef enum uart_tx_buffer_e
     UART_TX_BUFFER_SIZE_MATCH   = 0x0000, /**< Try to match DMA buffer size (hybrid only) @default */
     UART_TX_BUFFER_SIZE_4       = 0x0000, /**< 4 byte software buffer (software only) @default */
     UART_TX_BUFFER_SIZE_8       = 0x0010, /**< 8 byte software buffer */
-    UART_TX_BUFFER_SIZE_12      = 0x0020, /**< 12 byte software buffer */
+    UART_TX_BUFFER_SIZE_12      = 0x0020, /**< 12 byte software buffer, rounded up to 16 bytes */
     UART_TX_BUFFER_SIZE_16      = 0x0030, /**< 16 byte software buffer */
-    UART_TX_BUFFER_SIZE_24      = 0x0040, /**< 24 byte software buffer */
+    UART_TX_BUFFER_SIZE_24      = 0x0040, /**< 24 byte software buffer, rounded up to 32 bytes */
     UART_TX_BUFFER_SIZE_32      = 0x0050, /**< 32 byte software buffer */
     UART_TX_BUFFER_SIZE_64      = 0x0060, /**< 64 byte software buffer */
     UART_TX_BUFFER_SIZE_128     = 0x0070, /**< 128 byte software buffer */
@@ -238,9 +249,9 @@ typedef enum uart_rx_buffer_e
     UART_RX_BUFFER_SIZE_MATCH   = 0x0000, /**< Try to match DMA buffer size (hybrid only) @default */
     UART_RX_BUFFER_SIZE_4       = 0x0000, /**< 4 byte software buffer (software only) @default */
     UART_RX_BUFFER_SIZE_8       = 0x0010, /**< 8 byte software buffer */
-    UART_RX_BUFFER_SIZE_12      = 0x0020, /**< 12 byte software buffer */
+    UART_RX_BUFFER_SIZE_12      = 0x0020, /**< 12 byte software buffer, rounded up to 16 bytes */
     UART_RX_BUFFER_SIZE_16      = 0x0030, /**< 16 byte software buffer */
-    UART_RX_BUFFER_SIZE_24      = 0x0040, /**< 24 byte software buffer */
+    UART_RX_BUFFER_SIZE_24      = 0x0040, /**< 24 byte software buffer, rounded up to 32 bytes */
     UART_RX_BUFFER_SIZE_32      = 0x0050, /**< 32 byte software buffer */
     UART_RX_BUFFER_SIZE_64      = 0x0060, /**< 64 byte software buffer */
     UART_RX_BUFFER_SIZE_128     = 0x0070, /**< 128 byte software buffer */
@@ -302,6 +313,7 @@ enum uart_error_e
     UART_E_SOFTBUF  = -6,     /**< A problem occurred with the software buffer */
     UART_E_ALLOC    = -7,     /**< A problem occurred during dynamic memory allocation */
     UART_E_CLOSED   = -8,     /**< The module is closed and cannot be read from/written to */
+    UART_E_BUSY     = -9,     /**< Not enough buffer space is free yet, try again later */
     UART_E_ASSERT   = 0x8001, /**< An assertion failed */
     UART_E_UNKNOWN  = 0x8000  /**< Unknown error occurred */
 };
@@ -327,6 +339,95 @@ typedef enum uart_direction_e
     UART_DIRECTION_TXRX    = 0x0003  /**< Transmit and Receive */
 } uart_direction_t;
 
+/**
+ * @brief Describes one segment of the characters written by #uart_writev().
+ *
+ * @see uart_writev
+ * @public
+ */
+typedef struct uart_iovec
+{
+    const void *base;    /**< A pointer to the characters of the segment. */
+    unsigned int length; /**< The number of characters in the segment. */
+} uart_iovec_t;
+
+/**
+ * @brief Defines which node sends the response of a LIN frame.
+ *
+ * @public
+ */
+typedef enum uart_lin_direction_e
+{
+    UART_LIN_DIRECTION_IGNORE    = 0x00, /**< The frame is neither sent nor received */
+    UART_LIN_DIRECTION_PUBLISH   = 0x01, /**< This node sends the response */
+    UART_LIN_DIRECTION_SUBSCRIBE = 0x02  /**< Another node sends the response, this node receives
+                                            it */
+} uart_lin_direction_t;
+
+/**
+ * @brief Defines the checksum models of a LIN frame.
+ *
+ * @public
+ */
+typedef enum uart_lin_checksum_e
+{
+    UART_LIN_CHECKSUM_ENHANCED = 0x00, /**< LIN 2.x checksum over the PID and data @default */
+    UART_LIN_CHECKSUM_CLASSIC  = 0x01  /**< LIN 1.x checksum over the data only, also used for the
+                                          diagnostic frames whatever this setting */
+} uart_lin_checksum_t;
+
+/**
+ * @brief Defines the status of a LIN frame, set by the driver as the frame is processed.
+ *
+ * @public
+ */
+typedef enum uart_lin_status_e
+{
+    UART_LIN_STATUS_NONE          = 0x00, /**< The frame has not been seen yet */
+    UART_LIN_STATUS_BUSY          = 0x01, /**< The response is being sent or received */
+    UART_LIN_STATUS_OK            = 0x02, /**< The response was sent, or received and copied into
+                                             the frame data */
+    UART_LIN_STATUS_E_CHECKSUM    = 0x03, /**< The response received had a wrong checksum */
+    UART_LIN_STATUS_E_BIT         = 0x04, /**< A character sent read back differently from the bus,
+                                             another node was sending at the same time */
+    UART_LIN_STATUS_E_FRAMING     = 0x05, /**< A character of the response had no stop bit */
+    UART_LIN_STATUS_E_NO_RESPONSE = 0x06  /**< The response did not complete within the frame slot
+                                             */
+} uart_lin_status_t;
+
+/**
+ * @brief Describes one LIN frame which a node takes part in.
+ *
+ * @details The data of a published frame may be changed whenever its status is not
+ * #UART_LIN_STATUS_BUSY. The data of a subscribed frame is only written once a whole response
+ * with a good checksum has been received.
+ *
+ * @see uart_lin_set_frames
+ * @public
+ */
+typedef struct uart_lin_frame_s
+{
+    unsigned char id;        /**< The frame identifier, 0 to 63, without parity bits. */
+    unsigned char length;    /**< The number of data bytes in the response, 1 to 8. */
+    unsigned char direction; /**< A #uart_lin_direction_t value. */
+    unsigned char checksum;  /**< A #uart_lin_checksum_t value. */
+    unsigned char data[UART_LIN_MAX_DATA]; /**< The data bytes of the response. */
+    volatile unsigned char status; /**< A #uart_lin_status_t value, only set by the driver. */
+} uart_lin_frame_t;
+
+/**
+ * @brief Describes one slot of a LIN master schedule table.
+ *
+ * @see uart_lin_set_schedule
+ * @public
+ */
+typedef struct uart_lin_slot_s
+{
+    uart_lin_frame_t *frame; /**< The frame whose header starts the slot, or NULL for an empty
+                                slot. */
+    unsigned int ticks;      /**< The length of the slot in #uart_tick() calls, at least one. */
+} uart_lin_slot_t;
+
 
 /* ***** Attribute Declaration ***** */
 
@@ -462,10 +563,14 @@ struct uart_module_s
  *             The attribute struct to use to configure the module.
  * @param[in]  tx_dma
  *             The DMA channel which will be used for transmitting if DMA or hybrid buffer modes
- *             are chosen.
+ *             are chosen. The channel must not be initialized and must have both buffers, since
+ *             the module sends from one while filling the other. It is returned to its uninitialized
+ *             state by #uart_cleanup().
  * @param[in]  rx_dma
  *             The DMA channel which will be used for receiving if DMA or hybrid buffer modes are
- *             chosen.
+ *             chosen. The channel must not be initialized and buffer A must hold an even number of
+ *             words, one per character, since the module receives into it continuously as a
+ *             circular buffer. It is returned to its uninitialized state by #uart_cleanup().
  * @returns A #uart_error_e value.
  *
  * @todo Change to variable argument and allow dma channels and callback functions to be optional.
@@ -481,22 +586,177 @@ int uart_init(uart_module_t *module,
               dma_channel_t *tx_dma,
               dma_channel_t *rx_dma);
 
-// Cancels any autobaud (can be called asynchronously)
+// Cancels any autobaud (can be called asynchronously). Returns UART_E_CONFIG if Fcy cannot generate
+// the rate within UART_DEF_BAUD_ERROR_PPM.
 int uart_set_baudrate(uart_module_t *module,
                       uart_baudrate_t baudrate);
 
 int uart_get_baudrate(uart_module_t *module);
 
-// Baudrate will not actually be set until the sync character is received (must be the next
-// character received).
-int uart_autobaud(uart_module_t *module);
+/**
+ * @brief Sets the module to an arbitrary baud rate.
+ *
+ * @details BRGH and BRG are chosen at run time for the lowest bit time error from _FCY_, for rates
+ * which are not in #uart_baudrate_t. Cancels any autobaud in progress, and #uart_get_baudrate()
+ * then returns #UART_BAUDRATE_UNKNOWN.
+ *
+ * @param[in]  module
+ *             The module to set the baud rate of.
+ * @param[in]  baudrate
+ *             The baud rate in Hz.
+ * @returns A #uart_error_e value, #UART_E_CONFIG if Fcy cannot generate the rate within
+ * UART_DEF_BAUD_ERROR_PPM, as for #uart_set_baudrate(), or if the baud rate is set manually through
+ * uart.def.
+ *
+ * @public
+ */
+int uart_set_baudrate_hz(uart_module_t *module,
+                         unsigned long baudrate);
+
+/**
+ * @brief Returns the baud rate the module actually generates, in Hz.
+ *
+ * @details This differs from the rate asked for by the bit time error of the BRG setting.
+ *
+ * @param[in]  module
+ *             The module to query.
+ * @returns The baud rate in Hz, or zero if the module is invalid or the rate is unknown, as after
+ * a manual setting or while an autobaud is in progress. After an autobaud it is the measured rate,
+ * or the standard rate it snapped to.
+ *
+ * @public
+ */
+unsigned long uart_get_baudrate_hz(uart_module_t *module);
+
+/**
+ * @brief Measures the baud rate from the next character received, which must be the 0x55 sync
+ * character.
+ *
+ * @details The hardware autobaud counts the bit times of the sync character and loads UxBRG for
+ * the BRGH setting in force. The sync character itself is not received. Until it arrives
+ * #uart_get_baudrate() returns #UART_BAUDRATE_AUTO. Completion is picked up by #uart_rx_isr(),
+ * and by #uart_tick() for buffer modes whose RX interrupt does not reach #uart_rx_isr(), so at
+ * least one of them must be running.
+ *
+ * On completion the measured rate is worked out from _FCY_. If it lies within
+ * UART_DEF_AUTOBAUD_SNAP_PPM of a #uart_baudrate_t rate the module is set to exactly that rate and
+ * #uart_get_baudrate() returns it. Otherwise the measured setting is kept and
+ * #uart_get_baudrate() returns #UART_BAUDRATE_UNKNOWN. Either way #uart_get_baudrate_hz() returns
+ * the rate generated. Setting the baud rate before completion cancels the autobaud, and the
+ * callback is not called.
+ *
+ * @param[in]  module
+ *             The module to measure the baud rate of.
+ * @param[in]  callback
+ *             The function to call once the baud rate is set, or NULL. It may be called from an
+ *             ISR, under the same restrictions as rx_callback, or from #uart_tick() with
+ *             interrupts enabled.
+ * @returns A #uart_error_e value.
+ *
+ * @public
+ */
+int uart_autobaud(uart_module_t *module,
+                  void (*callback)(uart_module_t *module));
 
+/**
+ * @brief Accepts frames sent to an address in 9-bit masked address mode.
+ *
+ * @details An address character has bit 8 set and the address in its low byte. It and the data
+ * characters which follow it, up to the next address character, are received if its address has
+ * been added, and dropped otherwise. The addresses are kept in a bitmap, so checking an address
+ * character takes the same time however many addresses are added. With the software RX buffer the
+ * hardware drops the characters of other devices' frames itself, so they raise no interrupts.
+ *
+ * No addresses are accepted after #uart_init(). A change takes effect from the next address
+ * character.
+ *
+ * @param[in]  module
+ *             The module to accept the address on.
+ * @param[in]  addr
+ *             The address, 0 to 255.
+ * @returns A #uart_error_e value, #UART_E_CONFIG if the module is not in 9-bit mode.
+ *
+ * @see uart_remove_local_addr
+ * @public
+ */
 int uart_add_local_addr(uart_module_t *module,
                         char addr);
 
+/**
+ * @brief Stops accepting frames sent to an address in 9-bit masked address mode.
+ *
+ * @details A frame to the address which is already being received carries on until the next
+ * address character.
+ *
+ * @param[in]  module
+ *             The module to stop accepting the address on.
+ * @param[in]  addr
+ *             The address, 0 to 255.
+ * @returns A #uart_error_e value, #UART_E_CONFIG if the module is not in 9-bit mode.
+ *
+ * @see uart_add_local_addr
+ * @public
+ */
 int uart_remove_local_addr(uart_module_t *module,
                            char addr);
 
+/**
+ * @brief Sets the LIN frames a node responds to or listens for.
+ *
+ * @details In LIN major mode the RX ISR follows every header on the bus. When the PID of one of
+ * these frames arrives the node sends its response, for a published frame, or receives the
+ * response into the frame, for a subscribed one, and sets the frame status. The response is sent
+ * through the TX DMA or software buffer, so it costs no main loop time. Once the frame completes,
+ * tx_callback is called for a published frame and rx_callback for a subscribed one. LIN traffic
+ * only goes through frames, so #uart_read() and #uart_write() return #UART_E_CONFIG.
+ *
+ * A frame whose response has not completed within UART_DEF_LIN_FRAME_TICKS calls of
+ * #uart_tick() after its break is ended with #UART_LIN_STATUS_E_NO_RESPONSE.
+ *
+ * LIN mode needs the RX buffer mode #UART_RX_BUFFER_MODE_HWONLY, with the module's RX interrupt
+ * calling #uart_rx_isr(), and a TX buffer mode other than #UART_TX_BUFFER_MODE_HWONLY.
+ *
+ * @param[in]  module
+ *             The module to work on.
+ * @param[in]  frames
+ *             The array of frames, which must stay valid until it is replaced, or NULL.
+ * @param[in]  count
+ *             The number of frames, zero to stop responding.
+ * @returns A #uart_error_e value, #UART_E_CONFIG if the module is not in LIN mode or
+ * #UART_E_INPUT if a frame has an invalid identifier or length.
+ *
+ * @public
+ */
+int uart_lin_set_frames(uart_module_t *module,
+                        uart_lin_frame_t *frames,
+                        unsigned int count);
+
+/**
+ * @brief Sets the schedule table a LIN master runs.
+ *
+ * @details Each call of #uart_tick() counts down the slot in progress, and once it ends the next
+ * slot starts with the header of its frame, going back to the first slot after the last. A frame
+ * of the schedule table is handled as if it were given to #uart_lin_set_frames() too, so the
+ * master may publish or subscribe it. A response still in progress when the next slot starts is
+ * ended with #UART_LIN_STATUS_E_NO_RESPONSE, so each slot must be at least as long as its frame.
+ * Calling #uart_tick() from a function scheduled with schedule_periodic() gives the slots a fixed
+ * length in time.
+ *
+ * @param[in]  module
+ *             The module to work on.
+ * @param[in]  schedule
+ *             The array of slots, which must stay valid until it is replaced, or NULL.
+ * @param[in]  count
+ *             The number of slots, zero to stop sending headers.
+ * @returns A #uart_error_e value, #UART_E_CONFIG if the module is not a LIN master or
+ * #UART_E_INPUT if a slot has no ticks or an invalid frame.
+ *
+ * @public
+ */
+int uart_lin_set_schedule(uart_module_t *module,
+                          const uart_lin_slot_t *schedule,
+                          unsigned int count);
+
 
 /**
  * @brief Opens the module for reading, writing, or both.
@@ -533,29 +793,30 @@ int uart_open(uart_module_t *module,
  * of the DMA buffer and the software buffer:
  *
  * <b>TX DMA Enabled and Software Buffer Enabled</b><br />
- * The function will try to write as many characters as possible to the software buffer until
- * either of two conditions is met:
- * - The software buffer is full.
- * - The software buffer has enough characters to fill the DMA buffer.
- * At that point the software buffer will be flushed into the DMA buffer if possible and writing to
- * the software buffer will continue. If there is a DMA transfer in progress then the function will
- * try to keep writing to the software buffer until it is full. If the software buffer is full and
- * there is a DMA transfer in progress the function will exit and return the number of characters
- * successfully written.
+ * The function copies as many characters as fit into the software buffer, where small writes
+ * accumulate. A DMA transfer of up to one DMA buffer of characters starts when either of two
+ * conditions is met while no transfer is in progress:
+ * - The software buffer holds the watermark, UART_DEF_HYBRID_TX_WATERMARK characters or a full
+ *   DMA buffer by default.
+ * - The characters have waited UART_DEF_HYBRID_TX_DEADLINE calls of #uart_tick().
+ * While a transfer is in progress the TX DMA channel's interrupt, which must call #uart_tx_isr(),
+ * starts the next one from the software buffer. If the software buffer is full the function will
+ * return the number of characters written.
  *
  * <b>TX DMA Enabled and Software Buffer Disabled</b><br />
- * If there is no DMA transfer in progress the function will try to write to the DMA buffer until
- * it is full or all characters have been written. If the DMA buffer fills then a DMA transfer will
- * begin and the function will return the number of characters written. Otherwise, the transfer
- * will wait until a full DMA buffer is available or the #uart_flush function is called.
+ * Writes alternate between the DMA channel's two buffers, and each transfer is pointed at its
+ * buffer with dma_set_buffer() when it starts. If there is no DMA transfer in progress the
+ * characters are copied to the next buffer and a transfer of them begins straight away. If there
+ * is a transfer in progress the characters are queued in the other buffer, which is sent as soon
+ * as the transfer completes. If both buffers are full the function will return the number of
+ * characters written. The TX DMA channel's interrupt must call #uart_tx_isr() for queued
+ * characters to be sent.
  *
  * <b> TX DMA Disabled and Software Buffer Enabled</b><br />
- * The function will try to write to the software buffer until it is either full or has enough
- * characters to fill the hardware FIFO buffer (4 characters). If there is no transmission in
- * progress then the software buffer will be flushed to the hardware FIFO buffer and a transmission
- * will begin. Otherwise the function will continue to write to the software buffer until it is
- * full. If a transmission is in progress and the software buffer is full then the function will
- * return the number of characters written.
+ * The function copies as many characters as fit into the software buffer, a lock free ring
+ * buffer, and enables the TX interrupt. The UART's TX interrupt must call #uart_tx_isr(), which
+ * moves characters from the software buffer to the hardware FIFO whenever it has room. If the
+ * software buffer fills then the function will return the number of characters written.
  *
  * <b> TX DMA Disabled and Software Buffer Disabled</b><br />
  * The function will attempt to write to the hardware FIFO buffer directly. If there are no more
@@ -580,12 +841,53 @@ int uart_write(uart_module_t *module,
                const void *buffer,
                unsigned int length);
 
+/**
+ * @brief Writes the characters of several segments as one contiguous frame.
+ *
+ * @details The segments are copied straight from their arrays into the software or DMA buffer,
+ * without an intermediate copy. The frame is written whole or not at all: if the buffer has not
+ * enough room free the function writes nothing and returns #UART_E_BUSY, so the call may simply be
+ * repeated later. Interrupts are held off while the frame is queued, so a writer in an ISR cannot
+ * split it. Called from an ISR which interrupted #uart_write() it returns #UART_E_BUSY rather
+ * than split that write.
+ *
+ * Only standard (8-bit) mode is supported. The frame must fit in the buffer the buffer mode writes
+ * to:
+ * - Software or hybrid buffer: the software buffer.
+ * - DMA buffer: one DMA buffer.
+ * - Hardware buffer only: the hardware FIFO (4 characters), which must be empty.
+ *
+ * @param[in]  module
+ *             The module to which to write.
+ * @param[in]  iov
+ *             The array of segments to write, in order.
+ * @param[in]  count
+ *             The number of segments in @em iov.
+ *
+ * @returns The number of characters written, or a negative #uart_error_e value. #UART_E_INPUT
+ * means the frame can never fit.
+ *
+ * @see uart_write
+ * @public
+ */
+int uart_writev(uart_module_t *module,
+                const struct uart_iovec *iov,
+                unsigned int count);
+
 /**
  * @brief Reads in up to #length characters from the given module.
  *
  * @details This function will try to read in up to #length characters from the given module
  * into the given array.
  *
+ * <b>RX DMA Enabled and Software Buffer Disabled</b><br />
+ * The DMA channel receives continuously into its buffer without a CPU interrupt per character, so
+ * the function returns every character the channel has moved so far, up to #length. The RX DMA
+ * channel's interrupt fires at each half of the buffer and must call #uart_rx_isr(), which in turn
+ * calls rx_callback. Characters which do not fill a half are announced by #uart_tick() once the
+ * line goes idle. If the characters are not read before the channel wraps around to them they are
+ * overwritten.
+ *
  * @note Accesses to the software buffer are atomic.
  *
  * @param[in]  module
@@ -604,6 +906,55 @@ int uart_read(uart_module_t *module,
               void *buffer,
               unsigned int length);
 
+/**
+ * @brief Lends out the received characters which are contiguous in the RX buffer, without
+ * copying them.
+ *
+ * @details The characters stay in the RX buffer, so they may be parsed in place, until they are
+ * handed back with #uart_rx_release(). Characters which wrap around the end of the buffer are
+ * lent out by the next call, once those before the wrap have been released, so a wrapped message
+ * arrives as two spans. This function and #uart_rx_release() take the place of #uart_read() and
+ * must not be mixed with it while characters are lent out.
+ *
+ * Only the DMA and software RX buffer modes have a buffer to lend out. Characters in the DMA
+ * buffer take a word each, holding the character in the low byte, so the return value gives the
+ * size of one character. In 9-bit masked address mode the DMA buffer still holds the characters
+ * for other devices, which only #uart_read() drops, so #UART_E_CONFIG is returned.
+ *
+ * @param[in]  module
+ *             The module from which to read.
+ * @param[out] ptr
+ *             Set to the first character waiting.
+ * @param[out] len
+ *             Set to the number of contiguous characters at @em ptr, zero if none are waiting.
+ *
+ * @returns The size in bytes of one character at @em ptr, or a negative #uart_error_e value.
+ *
+ * @see uart_rx_release
+ * @public
+ */
+int uart_rx_acquire(uart_module_t *module,
+                    const void **ptr,
+                    unsigned int *len);
+
+/**
+ * @brief Hands characters lent out by #uart_rx_acquire() back to the RX buffer.
+ *
+ * @details The oldest @em n characters are released, so they may be fewer than were acquired.
+ *
+ * @param[in]  module
+ *             The module from which to read.
+ * @param[in]  n
+ *             The number of characters to release.
+ *
+ * @returns A #uart_error_e value, #UART_E_INPUT if fewer than @em n characters are waiting.
+ *
+ * @see uart_rx_acquire
+ * @public
+ */
+int uart_rx_release(uart_module_t *module,
+                    unsigned int n);
+
 /**
  * @brief Flushes any data in either the TX or RX buffer.
  *
@@ -620,11 +971,48 @@ int uart_read(uart_module_t *module,
 int uart_flush(uart_module_t *module,
                uart_direction_t direction);
 
+/**
+ * @brief Performs the periodic housekeeping of a UART module.
+ *
+ * @details This function should be called periodically, for example from a scheduled function.
+ * In RX DMA buffer mode it calls rx_callback when characters are waiting which no DMA interrupt
+ * announced and no more arrived since the previous call, so a message which stops part way
+ * through a half buffer is announced within two periods. In TX hybrid buffer mode it starts a DMA
+ * transfer of characters which have waited UART_DEF_HYBRID_TX_DEADLINE periods below the
+ * watermark. It also finishes an autobaud which completed, see #uart_autobaud(). In LIN mode it
+ * times out frames and runs the master schedule table, see #uart_lin_set_schedule().
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @public
+ */
+void uart_tick(uart_module_t *module);
+
 /**
  * @brief The TX interrupt service routine (ISR) for a UART module.
  *
  * @details This function should be inserted into the appropriate ISR for the given UART module.
+ * When the TX buffer mode uses DMA it belongs in the ISR of the TX DMA channel instead, which the
+ * user must enable.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @public
+ */
+void uart_tx_isr(uart_module_t *module);
+
+/**
+ * @brief The RX interrupt service routine (ISR) for a UART module.
+ *
+ * @details This function should be inserted into the appropriate ISR for the given UART module.
+ * When the RX buffer mode uses DMA it belongs in the ISR of the RX DMA channel instead, which the
+ * user must enable.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @public
  */
+void uart_rx_isr(uart_module_t *module);
 
 
 // Blocking?
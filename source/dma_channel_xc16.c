@@ -495,6 +495,39 @@ int dma_get_block_size(dma_channel_t *dma_channel)
 }
 
 
+int dma_set_buffer(dma_channel_t *dma_channel,
+                   dma_pingpong_status_t buffer)
+{
+    // Check for valid DMA channel
+    if( !dma_is_valid(dma_channel) )
+    {// Invalid DMA channel
+        // Return unsuccessfully
+        return DMA_E_CHANNEL;
+    }
+
+    // Point the DMAxSTA register at the chosen buffer
+    // We can't use __builtin_dmaoffset() since we don't have the static variable to get the
+    // address from, so we must do the offset calculation manually.
+    if( buffer == DMA_PINGPONG_BUFFER_A )
+    {// Buffer A
+        *(DMA_GET_BASE_ADDRESS(dma_channel) + DMA_SFR_OFFSET_DMAxSTA) \
+            = (volatile unsigned int)(dma_channel->buffer_a) - (volatile unsigned int)(&_DMA_BASE);
+    }
+    else if( buffer == DMA_PINGPONG_BUFFER_B && dma_channel->buffer_b != NULL )
+    {// Buffer B
+        *(DMA_GET_BASE_ADDRESS(dma_channel) + DMA_SFR_OFFSET_DMAxSTA) \
+            = (volatile unsigned int)(dma_channel->buffer_b) - (volatile unsigned int)(&_DMA_BASE);
+    }
+    else
+    {// Invalid buffer
+        return DMA_E_INPUT;
+    }
+
+    // Return successfully
+    return DMA_E_NONE;
+}
+
+
 int dma_get_attr(dma_channel_t *dma_channel,
                  dma_attr_t *attr)
 {
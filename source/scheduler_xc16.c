@@ -9,29 +9,72 @@
  * @carlnumber FIRM-0004
  * @version    0.3.0
  *
- * @todo Change array lists to linked lists for easier sorting, etc.
  * @todo 
  ****************************************************************************/
 
 // Standard C include files
 #include <stdlib.h>
+#include <limits.h>
 #include <stdint.h>
 #include <stdbool.h>
 
-// Microchip peripheral libraries
-#include <p33Fxxxx.h>
-
-// Include hardware definitions
-#include "../def/board.def"
+// Include hardware definitions (target or host)
+#include "../include/scheduler_hw.h"
 
 // Local include file
-#include "../include/scheduler.h"
+#include "../include/scheduler_xc16.h"
 
 
 /* Private Function Macros
  * These are preprocessor macros that provide some functionality besides
  * storing a value.
  */
+// Timing wheel bucket which holds processes expiring on tick t
+#define WHEEL_BUCKET(t) ((unsigned int)(t) & (SCHEDULE_WHEEL_LENGTH-1))
+
+// True if tick a is at or before tick b, correct across wrap-around of the tick counter
+#define TICK_BEFORE_EQ(a,b) ((long)((a) - (b)) <= 0)
+
+// Longest tickless idle, in ticks, that fits in the 16-bit Timer1 period register
+#define TICKLESS_MAX_TICKS (0x10000UL / (SCHEDULER_HW_TICK_PERIOD+1UL))
+
+// Timer1 period register value for an idle of n ticks
+#define TICKLESS_PERIOD(n) ((n)*(SCHEDULER_HW_TICK_PERIOD+1UL) - 1UL)
+
+// Timer1 counts an early wake needs between reading TMR1 and moving PR1, a tick boundary closer
+// than this is counted as passed so the match is not moved behind the running count
+#define TICKLESS_WAKE_MARGIN 32U
+
+// Timer1 counts per tick
+#define TICK_CYCLES (SCHEDULER_HW_TICK_PERIOD+1UL)
+
+// Number of ticks the current Timer1 period spans, and the Timer1 count the current tick started at
+#if defined(SCHEDULE_TICKLESS)
+#define CURRENT_TICK_STEP() tick_step
+#define CURRENT_TICK_OFFSET() tick_offset
+#else
+#define CURRENT_TICK_STEP() 1
+#define CURRENT_TICK_OFFSET() 0
+#endif
+
+// Index of an ISR ring entry from its free running head or tail
+#define ISR_RING_INDEX(i) ((i) & (SCHEDULE_ISR_RING_LENGTH-1))
+
+// Index of a band queue entry from its free running head or tail
+#define BAND_INDEX(i) ((i) & (SCHEDULE_BAND_LENGTH-1))
+
+// Version of the scheduler_profile_dump() format
+#define PROFILE_DUMP_VERSION 1
+
+// Highest generation a process' handle can carry before the generation wraps back to one
+#define HANDLE_GENERATIONS ((UINT_MAX - SCHEDULE_LIST_LENGTH + 1U) / SCHEDULE_LIST_LENGTH)
+
+// How a coroutine suspended itself during its run
+#define CO_RUNNING 0        // Not suspended, the coroutine ends when it returns
+#define CO_SLEEP 1          // Sleeping until its due tick
+#define CO_AWAIT 2          // Waiting on its event
+#define CO_AWAIT_TIMEOUT 3  // Waiting on its event until its due tick
+#define CO_CANCELLED 4      // Cancelled while running, released when it returns
 
 
 /* Private Kernel Data Structures
@@ -46,11 +89,79 @@ typedef struct process_s
     void *params;                 // A pointer to the parameters that will be
                                   // passed to the function when it is
                                   // executed.
-    int priority;       // When priority is greater than zero it determines the number of ticks until
-                        // it is valid to run (i.e. priority equals zero). When it is zero or less than
-                        // zero the scheduler will determine run order by how negative priority is.
+    unsigned long due;            // The absolute tick at which the process becomes ready (tick
+                                  // scheduled plus priority). Ready processes run in order of due.
+    unsigned int sequence;        // The order in which the process was scheduled. Processes with
+                                  // an equal due tick run in this (FIFO) order.
+    unsigned int period;          // The number of ticks between releases of a periodic process,
+                                  // or zero if the process runs once.
+    unsigned long release;        // The tick of the current release of a periodic process. The
+                                  // next release is anchored here, even when a demoted run has
+                                  // been held back past it.
+    scheduler_periodic_stats_t stats; // Run statistics of a periodic process.
+    unsigned long deadline;       // The absolute tick by which the process must complete. Ready
+                                  // processes run in order of deadline under the EDF policy.
+    unsigned int deadline_ticks;  // The number of ticks from due to deadline, or zero if the
+                                  // process has no deadline of its own and is not checked.
+#if defined(SCHEDULE_PROFILE)
+    unsigned long ready_cycles;   // The time, in Timer1 counts, at which the process became ready.
+#endif
+#if defined(SCHEDULE_BUDGET)
+    unsigned char budget_deferred; // Whether the process has been held back as a demoted run.
+#endif
+    scheduler_event_t *event;     // The event the process is waiting on, or NULL.
+    unsigned int wait_mask;       // The event bits which wake the process.
+    unsigned int wake_bits;       // The event bits which woke the process, zero if it timed out.
+    struct process_s *wait_next;  // The next process waiting on the same event.
+    struct process_s **wait_pprev; // The link pointing to the process in its event's waiters.
+    unsigned char coroutine;      // Whether the process is a coroutine, see schedule_coroutine().
+    unsigned char co_suspend;     // How the running coroutine suspended itself (CO_ macros).
+    scheduler_co_t co;            // The resume point and context of a coroutine.
+    unsigned int generation;      // Incremented each time the process is released, so that handles
+                                  // to its earlier uses no longer match it.
+    unsigned int heap_index;      // The process' index in the schedule heap while it is there.
+    struct process_s *next;       // The next process in the same timing wheel bucket, or the next
+                                  // free process while the process is in the free list.
+    struct process_s **pprev;     // The link pointing to the process in its timing wheel bucket,
+                                  // or NULL if the process is not in the timing wheel.
 } process_t;
 
+// Process queued by an ISR for the main loop to schedule
+typedef struct isr_entry_s
+{
+    void (*func)(void *params);   // The function passed to schedule_from_isr().
+    void *params;                 // The parameters passed to schedule_from_isr().
+    int priority;                 // The priority passed to schedule_from_isr().
+} isr_entry_t;
+
+// Single producer, single consumer ring of processes queued by the ISRs of one interrupt priority
+// level. Only the producer writes head and only the main loop writes tail. Both run freely and
+// are masked into entries with ISR_RING_INDEX().
+typedef struct isr_ring_s
+{
+    unsigned int head;            // Count of entries queued.
+    unsigned int tail;            // Count of entries collected by the main loop.
+    isr_entry_t entries[SCHEDULE_ISR_RING_LENGTH];
+} isr_ring_t;
+
+#if SCHEDULE_BANDS > 0
+// A process queued to a preemptive band with schedule_band().
+typedef struct band_entry_s
+{
+    void (*func)(void *);         // The function to run.
+    void *params;                 // The parameters passed to schedule_band().
+} band_entry_t;
+
+// Ring of processes queued to one preemptive band. Any context may queue a process, so head is only
+// written inside a band critical section. Only the band's vector writes tail.
+typedef struct band_queue_s
+{
+    unsigned int head;            // Count of entries queued.
+    unsigned int tail;            // Count of entries run by the band.
+    band_entry_t entries[SCHEDULE_BAND_LENGTH];
+} band_queue_t;
+#endif
+
     
 /* Private Kernel Data Storage
  * These data storage variables are used internnally by the kernel to keep
@@ -58,28 +169,223 @@ typedef struct process_s
  * only.
  */
 /**
- * Array storing the schedule of pointers to processes to execute.
+ * Binary min-heap storing the schedule of pointers to processes which are ready to execute. The
+ * heap is ordered by due tick, then by sequence, so the next process to run is always
+ * schedule_heap[0].
+ */
+static process_t *schedule_heap[SCHEDULE_LIST_LENGTH] = {0};
+
+/**
+ * Number of processes currently stored in schedule_heap.
+ */
+static unsigned int schedule_length = 0;
+
+/**
+ * Sequence number given to the next scheduled process.
+ */
+static unsigned int schedule_sequence = 0;
+
+/**
+ * Statically allocated storage for every process which may be scheduled at one time.
+ */
+static process_t process_pool[SCHEDULE_LIST_LENGTH];
+
+/**
+ * Singly linked list of processes in the pool which have been run and released.
+ */
+static process_t *free_list = NULL;
+
+/**
+ * Number of processes in the pool which have never been handed out. Processes are taken from the
+ * free list first and then from the unused end of the pool, so the pool needs no initialization.
+ */
+static unsigned int pool_unused = SCHEDULE_LIST_LENGTH;
+
+/**
+ * Hashed timing wheel storing delayed processes. Each bucket is a singly linked list of the
+ * processes whose due tick maps to it with WHEEL_BUCKET(), so delays longer than the wheel share a
+ * bucket with shorter ones and are left in place until their own revolution comes around.
+ */
+static process_t *schedule_wheel[SCHEDULE_WHEEL_LENGTH] = {0};
+
+/**
+ * The last tick whose timing wheel bucket has been expired into the schedule heap. This trails
+ * ticks while the main loop is busy running a process.
+ */
+static unsigned long wheel_ticks = 0;
+
+/**
+ * Processes queued by ISRs, one ring for each interrupt priority level (level 1 at index 0). An ISR
+ * can only be interrupted by ISRs of higher levels, so each ring has a single producer.
+ */
+static isr_ring_t isr_rings[SCHEDULER_HW_IPL_LEVELS];
+
+#if SCHEDULE_BANDS > 0
+/**
+ * Processes queued to each preemptive band (band 1 at index 0) and not yet run.
+ */
+static band_queue_t band_queues[SCHEDULE_BANDS];
+#endif
+
+/**
+ * Singly linked list of events which have had waiters since they were last found without any.
+ */
+static scheduler_event_t *active_events = NULL;
+
+/**
+ * Set by scheduler_event_post() to have the main loop check the active events.
+ */
+static volatile unsigned int events_posted = 0;
+
+/**
+ * The process being run by the main loop, or NULL.
+ */
+static process_t *current_process = NULL;
+
+/**
+ * Deadline violations counted by deadline_check().
+ */
+static scheduler_deadline_stats_t deadline_stats = {0};
+
+/**
+ * Called from the main loop after each run which completed after its deadline, or NULL.
  */
-static process_t *schedule_list[SCHEDULE_LIST_LENGTH] = {0};
+static void (*deadline_miss_callback)(void (*func)(void *), unsigned long lateness) = NULL;
 
 /**
  * Kernel tick counter
  */
 static volatile unsigned long ticks = 0;
 
+#if defined(SCHEDULE_TICKLESS)
+/**
+ * Number of ticks which the current Timer1 period spans. This is one except while idling.
+ */
+static volatile unsigned int tick_step = 1;
+
+/**
+ * Timer1 count at the start of the current tick. This is zero except for the rest of a stretched
+ * period after an early wake, which keeps counting from where the idle left off.
+ */
+static volatile unsigned int tick_offset = 0;
+#endif
+
+#if defined(SCHEDULE_PROFILE)
+/**
+ * Profiles of each function which has run, in the order they first ran.
+ */
+static scheduler_profile_t profile_table[SCHEDULE_PROFILE_LENGTH];
+
+/**
+ * Number of entries used in profile_table.
+ */
+static unsigned int profile_length = 0;
+
+/**
+ * Number of runs of functions which did not fit in profile_table.
+ */
+static unsigned long profile_untracked = 0;
+#endif
+
+#if defined(SCHEDULE_BUDGET)
+/**
+ * Budgets of each function given one, in the order they were set.
+ */
+static scheduler_budget_t budget_table[SCHEDULE_BUDGET_LENGTH];
+
+/**
+ * Number of entries used in budget_table.
+ */
+static unsigned int budget_length = 0;
+
+/**
+ * Set while the running process has a budget, for the tick ISR to check.
+ */
+static volatile unsigned char budget_armed = false;
+
+/**
+ * Last tick the running process may still be running on. Only written while budget_armed is clear.
+ */
+static volatile unsigned long budget_expiry = 0;
+
+/**
+ * Set by the tick ISR once the running process has overrun its budget.
+ */
+static volatile unsigned char budget_overrun = false;
+
+/**
+ * Called from the main loop after each run over budget, or NULL.
+ */
+static void (*budget_overrun_callback)(void (*func)(void *), unsigned long overrun) = NULL;
+#endif
+
 /* Private Function Prototypes
  * These functions are private and should only be used by the kernel itself.
  */
-static void prioritize(); // Sort the schedule by priority
+static bool process_before(const process_t *a, const process_t *b); // Compare run order
+static void heap_sift_up(process_t *process, unsigned int index); // Place a process up the heap
+static void heap_sift_down(process_t *process, unsigned int index); // Place a process down the heap
+static void heap_push(process_t *process); // Insert a process into the schedule
+#if SCHEDULE_POLICY == SCHEDULE_POLICY_EDF
+static unsigned long heap_latest_deadline(unsigned long now); // Find the latest ready deadline
+#endif
+static process_t * heap_pop(void); // Remove the root process from the schedule
+static void heap_remove(process_t *process); // Remove any process from the schedule
 static process_t * get_scheduled(); // Get the next scheduled process
-static void update_priority(); // Decrement priority values in all scheduled processes
+static unsigned long get_ticks(void); // Read the kernel tick counter
+static unsigned long read_time(unsigned int *timer); // Read the tick counter and Timer1 together
+static void wheel_insert(process_t *process); // Insert a delayed process into the timing wheel
+static void wheel_remove(process_t *process); // Remove a delayed process from the timing wheel
+static void wheel_expire(unsigned int bucket, unsigned long now); // Move expired processes to the heap
+static void advance_wheel(void); // Expire every timing wheel bucket up to the current tick
+#if defined(SCHEDULE_TICKLESS)
+static bool isr_rings_pending(void); // Check for processes queued by ISRs
+static unsigned int next_expiry(unsigned long now); // Ticks until the next delayed process is due
+static void idle(void); // Idle until the next process is due or an interrupt schedules one
+#endif
+#if defined(SCHEDULE_PROFILE)
+static unsigned long get_cycles(void); // Read the kernel time in Timer1 counts
+static void profile_record(const process_t *process, unsigned long start, unsigned long end);
+static void profile_put(unsigned char **buffer, unsigned long long value, unsigned int size);
+#endif
+#if defined(SCHEDULE_BUDGET)
+static scheduler_budget_t * budget_find(void (*func)(void *)); // Find a function's budget
+static bool budget_demote(process_t *process, scheduler_budget_t *budget); // Hold back a demoted run
+static void budget_start(const scheduler_budget_t *budget, unsigned long now); // Arm the budget
+static void budget_stop(scheduler_budget_t *budget, unsigned long start); // Check for an overrun
+#endif
+static void schedule_insert(process_t *process, unsigned long now); // Insert into heap or wheel
+static void schedule_place(process_t *process, unsigned long now); // Insert, keeping the deadline
+static void drain_isr_rings(void); // Schedule the processes queued by ISRs
+static void post_events(void); // Wake the processes whose events have been posted
+static void event_wait(process_t *process); // Add a process to its event's waiters
+static void event_unwait(process_t *process); // Remove a process from its event's waiters
+static void event_wake(process_t *process, unsigned int bits, unsigned long now); // Wake a waiter
+static void coroutine_suspend(process_t *process); // Put a suspended coroutine back to sleep
+static void deadline_check(const process_t *process); // Count a run which missed its deadline
+static void process_release(process_t *process); // Schedule the next release of a periodic process
+static process_t * process_alloc(void); // Take a process from the pool
+static void process_free(process_t *process); // Return a process to the pool
+static scheduler_handle_t process_handle(const process_t *process); // Make a handle to a process
+static process_t * handle_process(scheduler_handle_t handle); // Find the process a handle refers to
+static void process_unlink(process_t *process); // Remove a process from the schedule, wheel or event
+#if SCHEDULE_BANDS > 0
+static void band_run(band_queue_t *queue); // Run the processes queued to a band
+#endif
+static bool dispatch(void); // Run the next scheduled process, if any
 
 
 /* Interrupt Service Routine Prototypes
  * These are the function prototypes for the interrupt handling routines used
  * by the kernel internally.
  */
-void __attribute__((__interrupt__, no_auto_psv)) _T1Interrupt(void);
+void SCHEDULER_HW_ISR _T1Interrupt(void);
+#if SCHEDULE_BANDS > 0
+void SCHEDULER_HW_ISR SCHEDULER_HW_BAND1_VECTOR(void);
+#endif
+#if SCHEDULE_BANDS > 1
+void SCHEDULER_HW_ISR SCHEDULER_HW_BAND2_VECTOR(void);
+#endif
 
 
 /* Function Definitions
@@ -95,8 +401,16 @@ void init_scheduler(void)
 {
     // Initialize Timer1 for ticks
     TMR1 = 0x0000;
-    PR1 = 5000L; // 500us/tick
+    PR1 = SCHEDULER_HW_TICK_PERIOD; // 500us/tick
     T1CON = 0;   // Remain paused until kernel starts
+
+    // Enable the software interrupts of the preemptive bands
+#if SCHEDULE_BANDS > 0
+    SCHEDULER_HW_BAND1_INIT();
+#endif
+#if SCHEDULE_BANDS > 1
+    SCHEDULER_HW_BAND2_INIT();
+#endif
 }
 
     
@@ -105,8 +419,6 @@ void init_scheduler(void)
  */
 void start_scheduler(void)
 {
-    process_t *current_process = NULL;
-    
     // Start ticks
     T1CON |= (1<<15);
     
@@ -116,30 +428,113 @@ void start_scheduler(void)
     //! Start endless loop
     for( ; ; )
     {
-        // Prioritize schedule
-        prioritize();
+#if defined(SCHEDULE_TICKLESS)
+        // Idle when there is nothing to run
+        if( !dispatch() )
+        {
+            idle();
+        }
+#else
+        if( !dispatch() )
+        {
+            SCHEDULER_HW_POLL();
+        }
+#endif
+    }   
+}
+
+/**
+ * Run a single pass of the scheduler loop. Delayed processes which have expired since the last pass
+ * are moved to the schedule, then if the next process is ready it is run and returned to the
+ * process pool.
+ *
+ * @return      True if a process was run, false otherwise.
+ */
+bool dispatch(void)
+{
+#if defined(SCHEDULE_PROFILE)
+    unsigned long start;
+#endif
+#if defined(SCHEDULE_BUDGET)
+    scheduler_budget_t *budget;
+    unsigned long started;
+#endif
+
+    // Collect processes queued by ISRs, wake processes whose events were posted, and move expired
+    // delayed processes into the schedule. Events are checked first, so an event posted on the tick
+    // its waiter times out wakes it.
+    drain_isr_rings();
+    post_events();
+    advance_wheel();
+
+    // Get next item on schedule
+    current_process = get_scheduled();
+
+    // Check if next process was valid and run it
+    if( current_process != NULL )
+    {// Process is valid
+        current_process->co_suspend = CO_RUNNING;
+
+#if defined(SCHEDULE_BUDGET)
+        // Hold back or skip the run of a demoted function, otherwise arm its budget
+        budget = budget_find(current_process->func);
+        if( budget != NULL && budget_demote(current_process, budget) )
+        {
+            current_process = NULL;
+
+            return true;
+        }
+        started = get_ticks();
+        budget_start(budget, started);
+#endif
 
-        // Get next item on schedule
-        current_process = get_scheduled();
+        // Run process
+#if defined(SCHEDULE_PROFILE)
+        start = get_cycles();
+        current_process->func(current_process->params);
+        profile_record(current_process, start, get_cycles());
+#else
+        current_process->func(current_process->params);
+#endif
 
-        // Check if next process was valid and run it
-        if( current_process != NULL )
-        {// Process is valid
-            // Run process
-            current_process->func(current_process->params);
+#if defined(SCHEDULE_BUDGET)
+        // Count and report a run over budget
+        budget_stop(budget, started);
+#endif
 
-            // Free process
-            free(current_process);
+        // Report a run which completed after its deadline
+        deadline_check(current_process);
+
+        if( current_process->co_suspend == CO_CANCELLED )
+        {// Cancelled itself while running, return it to the pool without scheduling it again
+            process_free(current_process);
         }
-            
-    }   
+        else if( current_process->period != 0 )
+        {// Periodic process, schedule its next release
+            process_release(current_process);
+        }
+        else if( current_process->co_suspend != CO_RUNNING )
+        {// Coroutine suspended itself, put it back to sleep
+            coroutine_suspend(current_process);
+        }
+        else
+        {// Return process to the pool
+            process_free(current_process);
+        }
+        current_process = NULL;
+
+        return true;
+    }
+
+    return false;
 }
 
 /**
  * This function schedules the run function of the module pointed to by @em kmodule.
  * The scheduler is a simple FIFO queue with the distinction that positive
  * priority values mean a process is paused for that number of kernel ticks.
- * Negative priority values are higher priority. This function is atomic.
+ * Negative priority values are higher priority. Under the EDF policy the process' due tick serves as
+ * its deadline. When called from an ISR the process is queued with schedule_from_isr() instead.
  *
  * @param[in]  func
  *             A pointer to the function which should be executed when the process reaches the top
@@ -155,196 +550,2352 @@ void start_scheduler(void)
  * @param[in]  params
  *             A pointer to the parameters to pass into the scheduled function when it is executed.
  *
- * @return     An integer value representing whether adding the function to the scheduler
- *             succeeded or failed. A zero means success, a negative number means failure.
+ * @return     A handle to the process, which may be passed to unschedule() and reschedule(), or
+ *             zero if @em func was invalid or the schedule was full. When called from an ISR the
+ *             process has no handle yet, and SCHEDULER_HANDLE_DEFERRED is returned if it was queued.
  */
-int schedule(void (*func)(void *), int priority, void *params)
+scheduler_handle_t schedule(void (*func)(void *), int priority, void *params)
 {
-    unsigned int iterator;
-    
-    // Disable interrupts
-    __asm__ volatile ("disi #0x3FFF");
-    
+    process_t *process;
+    unsigned long now;
+
+    // ISRs may not touch the schedule, queue the process for the main loop
+    if( SCHEDULER_HW_CURRENT_IPL() != 0 )
+    {
+        return schedule_from_isr(func, priority, params) ? SCHEDULER_HANDLE_DEFERRED : 0;
+    }
+
     // Check for valid function pointer
     if( func == NULL )
     {// Module is invalid
-        // Reenable interrupts
-        __asm__ volatile ("disi #0x0000");
+        // Return unsuccessfully
+        return 0;
+    }
 
+    // Take a process from the pool. The pool is the same length as the schedule, so this only
+    // fails when the schedule is full.
+    process = process_alloc();
+    if( process == NULL )
+    {// Schedule is full
         // Return unsuccessfully
+        //! @todo Add debug notice here
+        return 0;
+    }
+
+    // Copy data into the process and insert it into the schedule
+    now = get_ticks();
+    process->func = func;
+    process->params = params;
+    process->due = now + priority;
+    process->sequence = schedule_sequence++;
+    process->period = 0;
+    process->event = NULL;
+    process->wake_bits = 0;
+    process->coroutine = false;
+    process->deadline_ticks = 0;
+    schedule_insert(process, now);
+
+    // Return successfully
+    return process_handle(process);
+}
+
+
+/**
+ * This function queues a process for the main loop to schedule. It is lock-free and never masks
+ * interrupts: each interrupt priority level has its own queue, which only that level writes, so it
+ * may be called from an ISR of any level without delaying higher priority interrupts. The process
+ * is inserted into the schedule with @em priority on the next pass of the main loop. When called
+ * from the main loop it is the same as schedule().
+ *
+ * @param[in]  func
+ *             A pointer to the function which should be executed, see schedule().
+ *
+ * @param[in]  priority
+ *             When/in what order the process should be executed, see schedule(). Delays count from
+ *             when the main loop collects the process.
+ *
+ * @param[in]  params
+ *             A pointer to the parameters to pass into the scheduled function when it is executed.
+ *
+ * @return     True if the process was queued, false if @em func was invalid or the queue of the
+ *             calling interrupt priority level is full.
+ */
+int schedule_from_isr(void (*func)(void *), int priority, void *params)
+{
+    unsigned int ipl = SCHEDULER_HW_CURRENT_IPL();
+    isr_ring_t *ring;
+    isr_entry_t *entry;
+    unsigned int head;
+
+    if( ipl == 0 )
+    {// Called from the main loop
+        return schedule(func, priority, params) != 0;
+    }
+
+    // Check for valid function pointer
+    if( func == NULL )
+    {
         return false;
     }
 
-    // Iterate through schedule and find next empty slot
-    for( iterator = 0; iterator < SCHEDULE_LIST_LENGTH; ++iterator )
+    if( ipl > SCHEDULER_HW_IPL_LEVELS )
     {
-        // Check for empty slot
-        if( schedule_list[iterator] == NULL )
-        {// Current slot is empty
-            // Allocate new process and copy data into it
-            schedule_list[iterator] = malloc(sizeof(process_t));
-            schedule_list[iterator]->func = func;
-            schedule_list[iterator]->params = params;
-            schedule_list[iterator]->priority = priority;
+        ipl = SCHEDULER_HW_IPL_LEVELS;
+    }
+    ring = &isr_rings[ipl-1];
 
-            // Reenable interrupts
-            __asm__ volatile ("disi #0x0000");
-            
-            // Return successfully
-            return true;
-        }
+    // Check for room, the main loop may be collecting entries meanwhile
+    head = ring->head;
+    if( head - SCHEDULER_HW_LOAD_ACQUIRE(ring->tail) >= SCHEDULE_ISR_RING_LENGTH )
+    {// Ring is full
+        return false;
     }
 
-    // Reenable interrupts
-    __asm__ volatile ("disi #0x0000");
-    
-    // No empty slots found, return unsuccessfully
-    //! @todo Add debug notice here
-    return false;
+    // Fill the entry, then publish it
+    entry = &ring->entries[ISR_RING_INDEX(head)];
+    entry->func = func;
+    entry->params = params;
+    entry->priority = priority;
+    SCHEDULER_HW_STORE_RELEASE(ring->head, head+1);
+
+    return true;
 }
 
 
-void prioritize()
+#if SCHEDULE_BANDS > 0
+/**
+ * This function queues a process to run in a preemptive priority band. Each band is a software
+ * interrupt at its own interrupt priority level, SCHEDULER_HW_BAND1_IPL and SCHEDULER_HW_BAND2_IPL,
+ * so the process runs as soon as nothing at or above that level is running: it preempts the main
+ * loop and any lower band, and a higher band preempts it in turn. Processes in a band run in the
+ * order they were queued, each to completion. A band process runs at interrupt level, so it may
+ * only use the functions which may be called from an ISR, and a process it schedules with schedule()
+ * reaches the main loop through schedule_from_isr(). May be called from the main loop, an ISR or a
+ * band process, but not from within a critical section.
+ *
+ * @param[in]  band
+ *             The band to run the process in, from 1 to SCHEDULE_BANDS. Higher bands preempt lower
+ *             ones.
+ *
+ * @param[in]  func
+ *             A function pointer to the process to run.
+ *
+ * @param[in]  params
+ *             A pointer to the parameters to pass into the function when it is run.
+ *
+ * @return     True if the process was queued, false if @em band or @em func was invalid or the
+ *             band's queue is full.
+ */
+int schedule_band(unsigned int band, void (*func)(void *), void *params)
 {
-    unsigned int iterator;
-    process_t *tmp_ptr;
-    bool swap = false;
-    
-    // Disable interrupts
-    __asm__ volatile ("disi #0x3FFF");
+    band_queue_t *queue;
+    band_entry_t *entry;
 
-    // Check for empty schedule or only one item in schedule
-    if( schedule_list[0] == NULL || schedule_list[1] == NULL )
-    {// Schedule is empty
-        // Reenable interrupts
-        __asm__ volatile ("disi #0x0000");
+    // Check for valid band and function pointer
+    if( band < 1 || band > SCHEDULE_BANDS || func == NULL )
+    {
+        return false;
+    }
+    queue = &band_queues[band-1];
 
-        return;
+    SCHEDULER_HW_BAND_LOCK();
+
+    // Check for room, the band may be running entries meanwhile
+    if( queue->head - SCHEDULER_HW_LOAD_ACQUIRE(queue->tail) >= SCHEDULE_BAND_LENGTH )
+    {// Queue is full
+        SCHEDULER_HW_BAND_UNLOCK();
+
+        return false;
     }
 
-    // Implement reverse bubble sort, sort by iterating through the list in reverse order
-    // Continue sorting as long as a swap has occurred this round
-    do
+    // Fill the entry, then publish it
+    entry = &queue->entries[BAND_INDEX(queue->head)];
+    entry->func = func;
+    entry->params = params;
+    SCHEDULER_HW_STORE_RELEASE(queue->head, queue->head+1);
+
+    SCHEDULER_HW_BAND_UNLOCK();
+
+    // Raise the band's software interrupt
+#if SCHEDULE_BANDS > 1
+    if( band == 2 )
     {
-        // Initialize swap to false for this round
-        swap = false;
-        
-        // Iterate through entire list from back to front
-        for( iterator = SCHEDULE_LIST_LENGTH-1; iterator > 0; --iterator )
-        {
-            // Check that the current item is not NULL
-            if( schedule_list[iterator] != NULL )
-            {// Current item is not NULL
-                // Check the current item against the next (closer to the front)
-                if( schedule_list[iterator]->priority < schedule_list[iterator-1]->priority )
-                {// Current item has higher priority than the next item
-                    // Swap current item and next item
-                    tmp_ptr = schedule_list[iterator];
-                    schedule_list[iterator] = schedule_list[iterator-1];
-                    schedule_list[iterator-1] = tmp_ptr;
-                    swap = true;
-                }
-            }
-        }
-    } while(swap);
+        SCHEDULER_HW_BAND2_TRIGGER();
 
-    // Reenable interrupts
-    __asm__ volatile ("disi #0x0000");
+        return true;
+    }
+#endif
+    SCHEDULER_HW_BAND1_TRIGGER();
 
-    // Return
-    return;
+    return true;
 }
+#endif
 
 
 /**
- * Get the next scheduled process and shift the schedule array left. This
- * function is atomic.
+ * This function cancels a scheduled process and returns its place in the schedule to the pool in
+ * O(log n). A delayed process, a periodic process, a process waiting on an event and a suspended
+ * coroutine are all cancelled. A periodic process or coroutine which cancels itself while running
+ * is released when it returns, and a cancelled coroutine returns at its next suspension point
+ * without suspending. Must be called from the main loop.
  *
- * @return      A pointer to the next process in the schedule queue.
+ * @param[in]  handle
+ *             The handle returned when the process was scheduled.
+ *
+ * @return     True if the process was cancelled, false if the handle was invalid or the process has
+ *             already run to completion.
  */
-process_t * get_scheduled()
+int unschedule(scheduler_handle_t handle)
 {
-    unsigned int iterator;
-    process_t *next_process = NULL;
-    
-    // Disable interrupts
-    __asm__ volatile ("disi #0x3FFF");
+    process_t *process;
 
-    // Check if schedule is empty
-    if( schedule_list[0] == NULL )
-    {// Schedule is empty
-        // Reenable interrupts
-        __asm__ volatile ("disi #0x0000");
+    if( SCHEDULER_HW_CURRENT_IPL() != 0 )
+    {
+        return false;
+    }
 
-        // Return NULL
-        return NULL;
+    process = handle_process(handle);
+    if( process == NULL )
+    {// Process has run or was cancelled already
+        return false;
     }
-    
-    // Check if next process is ready to run
-    if( schedule_list[0]->priority <= 0 )
-    {// Store next process pointer and shift schedule left
-        next_process = schedule_list[0];
-        for( iterator = 0; schedule_list[iterator] != NULL && iterator < SCHEDULE_LIST_LENGTH-1; ++iterator )
-        {
-            // Copy the next item into the current item
-            schedule_list[iterator] = schedule_list[iterator+1];
-        }
-        // Set last item to NULL (in case it was the last item in array)
-        schedule_list[iterator] = NULL;
 
-        // Reenable interrupts
-        __asm__ volatile ("disi #0x0000");
+    if( process == current_process )
+    {// Running, have dispatch() release it instead of scheduling it again
+        process->period = 0;
+        process->co_suspend = CO_CANCELLED;
 
-        // Return next process
-        return next_process;
+        return true;
     }
 
-    // Reenable interrupts
-    __asm__ volatile ("disi #0x0000");
+    // Released processes have no period, see schedule_periodic_stats()
+    process_unlink(process);
+    process->period = 0;
+    process_free(process);
 
-    // Return NULL
-    return NULL;
+    return true;
 }
 
 
 /**
- * Update the priority levels of all scheduled processes. Simply decrements all
- * processes priority values by one. This function is atomic.
+ * This function moves a scheduled process to run @em priority ticks from now, in O(log n), as if it
+ * had just been scheduled with schedule(). The next release of a periodic process is moved, and
+ * later releases follow on from it. A process waiting on an event keeps waiting, and its timeout
+ * is moved instead; a priority of zero or less wakes it now as though it timed out. Must be
+ * called from the main loop.
+ *
+ * @param[in]  handle
+ *             The handle returned when the process was scheduled.
+ *
+ * @param[in]  priority
+ *             When/in what order the process should be executed, see schedule().
+ *
+ * @return     True if the process was moved, false if the handle was invalid, the process has
+ *             already run to completion, or it is running.
  */
-void update_priority()
+int reschedule(scheduler_handle_t handle, int priority)
 {
-    unsigned int iterator;
-    
-    // Disable interrupts
-    __asm__ volatile ("disi #0x3FFF");
+    process_t *process;
+    unsigned long now;
 
-    // Iterate through schedule and decrement priorities
-    for( iterator = 0; schedule_list[iterator] != NULL && iterator < SCHEDULE_LIST_LENGTH; ++iterator )
+    if( SCHEDULER_HW_CURRENT_IPL() != 0 )
     {
-        schedule_list[iterator]->priority--;
+        return false;
     }
 
-    // Reenable interrupts
-    __asm__ volatile ("disi #0x0000");
+    process = handle_process(handle);
+    if( process == NULL || process == current_process )
+    {
+        return false;
+    }
+
+    now = get_ticks();
+    if( process->event != NULL )
+    {// Waiting on an event, move its timeout
+        if( process->pprev != NULL )
+        {
+            wheel_remove(process);
+        }
+
+        if( priority <= 0 )
+        {
+            event_wake(process, 0, now);
+        }
+        else
+        {
+            process->due = now + priority;
+            wheel_insert(process);
+        }
+
+        return true;
+    }
+
+    process_unlink(process);
+    process->due = now + priority;
+    process->release = process->due;
+    process->sequence = schedule_sequence++;
+    schedule_insert(process, now);
 
-    // Return
-    return;
+    return true;
 }
 
 
-/** Timer1 ISR
- * This is the Timer1 ISR. This ISR is used as the kernels tick counter.
+/**
+ * This function schedules @em func to run periodically, every @em period_ticks ticks, starting
+ * @em phase ticks from now. Releases are anchored to absolute ticks, so the period does not drift
+ * by the time the process takes to run. A run which completes after the next release counts as a
+ * deadline miss and the next release runs as soon as possible. Releases which have passed entirely
+ * are skipped and counted as overruns, so a late process does not run several times back to back.
+ * The process stays scheduled and occupies one place in the schedule permanently. Must be called
+ * from the main loop.
+ *
+ * @param[in]  func
+ *             A pointer to the function which should be executed on each release.
+ *
+ * @param[in]  period_ticks
+ *             The number of ticks between releases. Must be greater than zero.
+ *
+ * @param[in]  phase
+ *             The number of ticks until the first release. Zero releases the process immediately.
+ *
+ * @param[in]  params
+ *             A pointer to the parameters to pass into the scheduled function on each release.
+ *
+ * @return     A handle to the process, see schedule(), or zero if @em func or @em period_ticks was
+ *             invalid, this was called from an ISR, or the schedule was full.
  */
-void __attribute__((__interrupt__, no_auto_psv)) _T1Interrupt(void)
+scheduler_handle_t schedule_periodic(void (*func)(void *), unsigned int period_ticks,
+                                     unsigned int phase, void *params)
 {
-    // Increment kernel ticks
-    //! @todo Make this atomic!
-    ticks++;
+    process_t *process;
+    unsigned long now;
 
-    // Update schedule priorities
-    update_priority();
-    
-    // Reset interrupt flag
-    IFS0bits.T1IF=0;
+    // Check for valid function pointer and period, and that this is not an ISR
+    if( func == NULL || period_ticks == 0 || SCHEDULER_HW_CURRENT_IPL() != 0 )
+    {// Arguments are invalid
+        // Return unsuccessfully
+        return 0;
+    }
+
+    // Take a process from the pool
+    process = process_alloc();
+    if( process == NULL )
+    {// Schedule is full
+        // Return unsuccessfully
+        return 0;
+    }
+
+    // Copy data into the process and insert its first release into the schedule
+    now = get_ticks();
+    process->func = func;
+    process->params = params;
+    process->due = now + phase;
+    process->release = process->due;
+    process->sequence = schedule_sequence++;
+    process->period = period_ticks;
+    process->stats.releases = 0;
+    process->stats.deadline_misses = 0;
+    process->stats.overruns = 0;
+    process->event = NULL;
+    process->wake_bits = 0;
+    process->coroutine = false;
+    process->deadline_ticks = period_ticks;
+    schedule_insert(process, now);
+
+    // Return successfully
+    return process_handle(process);
+}
+
+
+/**
+ * Get the run statistics of the periodic process running @em func. If @em func was scheduled
+ * periodically more than once, the statistics of one of them are returned. Must be called from the
+ * main loop.
+ *
+ * @param[in]  func
+ *             The function which was passed to schedule_periodic().
+ *
+ * @param[out] stats
+ *             A pointer to the statistics structure to fill.
+ *
+ * @return     True if a periodic process running @em func was found, false otherwise.
+ */
+int schedule_periodic_stats(void (*func)(void *), scheduler_periodic_stats_t *stats)
+{
+    unsigned int iterator;
+
+    if( stats == NULL )
+    {
+        return false;
+    }
+
+    // Search the part of the pool which has been handed out. Released processes have no period.
+    for( iterator = pool_unused; iterator < SCHEDULE_LIST_LENGTH; ++iterator )
+    {
+        if( process_pool[iterator].period != 0 && process_pool[iterator].func == func )
+        {// Found the process, copy its statistics
+            *stats = process_pool[iterator].stats;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/**
+ * This function schedules @em func to run once, @em delay ticks from now, and to complete within
+ * @em deadline ticks of that. Under the EDF policy ready processes run in order of their absolute
+ * deadline, so a process with a tight deadline overtakes ones with looser deadlines. Processes
+ * scheduled without a deadline of their own, by schedule() and the like, take their due tick as
+ * their deadline. Under either policy a run which completes after its deadline is counted, see
+ * scheduler_deadline_stats(). Must be called from the main loop.
+ *
+ * @param[in]  func
+ *             A pointer to the function which should be executed.
+ *
+ * @param[in]  delay
+ *             The number of ticks until the process is released. Zero releases it immediately.
+ *
+ * @param[in]  deadline
+ *             The number of ticks, from the release, within which the process must complete. Must
+ *             be greater than zero.
+ *
+ * @param[in]  params
+ *             A pointer to the parameters to pass into the scheduled function when it is executed.
+ *
+ * @return     A handle to the process, see schedule(), or zero if @em func or @em deadline was
+ *             invalid, this was called from an ISR, or the schedule was full.
+ */
+scheduler_handle_t schedule_deadline(void (*func)(void *), unsigned int delay,
+                                     unsigned int deadline, void *params)
+{
+    process_t *process;
+    unsigned long now;
+
+    // Check for valid function pointer and deadline, and that this is not an ISR
+    if( func == NULL || deadline == 0 || SCHEDULER_HW_CURRENT_IPL() != 0 )
+    {
+        return 0;
+    }
+
+    // Take a process from the pool
+    process = process_alloc();
+    if( process == NULL )
+    {// Schedule is full
+        return 0;
+    }
+
+    // Copy data into the process and insert it into the schedule
+    now = get_ticks();
+    process->func = func;
+    process->params = params;
+    process->due = now + delay;
+    process->sequence = schedule_sequence++;
+    process->period = 0;
+    process->event = NULL;
+    process->wake_bits = 0;
+    process->coroutine = false;
+    process->deadline_ticks = deadline;
+    schedule_insert(process, now);
+
+    return process_handle(process);
+}
+
+
+/**
+ * Get the deadline violations counted since the scheduler started. Periodic processes, whose
+ * deadline is their next release, and processes scheduled with schedule_deadline() are checked.
+ * Must be called from the main loop.
+ *
+ * @param[out] stats
+ *             A pointer to the statistics structure to fill.
+ */
+void scheduler_deadline_stats(scheduler_deadline_stats_t *stats)
+{
+    if( stats != NULL )
+    {
+        *stats = deadline_stats;
+    }
+}
+
+
+/**
+ * Set the function called after each run which completed after its deadline. It is called from the
+ * main loop, with the function which ran and the number of ticks by which it was late, before the
+ * next process runs. Must be called from the main loop.
+ *
+ * @param[in]  callback
+ *             A pointer to the function to call, or NULL for none.
+ */
+void scheduler_on_deadline_miss(void (*callback)(void (*func)(void *), unsigned long lateness))
+{
+    deadline_miss_callback = callback;
+}
+
+
+/**
+ * Initialize an event group with no bits posted and no waiters.
+ *
+ * @param[out] event
+ *             A pointer to the event to initialize.
+ */
+void scheduler_event_init(scheduler_event_t *event)
+{
+    event->bits = 0;
+    event->waiters = NULL;
+    event->next_active = NULL;
+    event->active = false;
+}
+
+
+/**
+ * Post bits to an event group. Processes waiting on any of the bits are made ready on the next pass
+ * of the main loop, and the bits they waited on are consumed. Bits which no process waits on stay
+ * posted. This function is lock-free and may be called from an ISR of any level.
+ *
+ * @param[in]  event
+ *             A pointer to the event to post to.
+ *
+ * @param[in]  bits
+ *             The bits to post.
+ */
+void scheduler_event_post(scheduler_event_t *event, unsigned int bits)
+{
+    SCHEDULER_HW_ATOMIC_OR(event->bits, bits);
+    SCHEDULER_HW_STORE_RELEASE(events_posted, 1);
+}
+
+
+/**
+ * Clear posted bits of an event group without waking anything. This function may be called from
+ * an ISR of any level.
+ *
+ * @param[in]  event
+ *             A pointer to the event to clear.
+ *
+ * @param[in]  bits
+ *             The bits to clear.
+ */
+void scheduler_event_clear(scheduler_event_t *event, unsigned int bits)
+{
+    SCHEDULER_HW_ATOMIC_AND(event->bits, ~bits);
+}
+
+
+/**
+ * This function schedules @em func to run once any of the @em mask bits are posted to @em event,
+ * or once @em timeout ticks pass. The waiting process is kept out of the schedule, so it costs
+ * nothing until it is woken. If a bit is already posted the process is ready immediately. The bits
+ * which woke the process are consumed and may be read with scheduler_wake_bits() while it runs.
+ * Must be called from the main loop.
+ *
+ * @param[in]  func
+ *             A pointer to the function which should be executed when the process is woken.
+ *
+ * @param[in]  event
+ *             A pointer to the event to wait on.
+ *
+ * @param[in]  mask
+ *             The event bits which wake the process. Must not be zero.
+ *
+ * @param[in]  timeout
+ *             The number of ticks after which the process is woken anyway, or zero to wait forever.
+ *
+ * @param[in]  params
+ *             A pointer to the parameters to pass into the scheduled function when it is executed.
+ *
+ * @return     A handle to the process, see schedule(), or zero if the arguments were invalid, this
+ *             was called from an ISR, or the schedule was full.
+ */
+scheduler_handle_t schedule_on_event(void (*func)(void *), scheduler_event_t *event,
+                                     unsigned int mask, unsigned int timeout, void *params)
+{
+    process_t *process;
+    unsigned long now;
+    unsigned int bits;
+
+    // Check for valid arguments, and that this is not an ISR
+    if( func == NULL || event == NULL || mask == 0 || SCHEDULER_HW_CURRENT_IPL() != 0 )
+    {
+        return 0;
+    }
+
+    // Take a process from the pool
+    process = process_alloc();
+    if( process == NULL )
+    {// Schedule is full
+        return 0;
+    }
+
+    now = get_ticks();
+    process->func = func;
+    process->params = params;
+    process->period = 0;
+    process->sequence = schedule_sequence++;
+    process->pprev = NULL;
+    process->coroutine = false;
+    process->deadline_ticks = 0;
+
+    // A bit which is already posted wakes the process immediately
+    bits = SCHEDULER_HW_LOAD_ACQUIRE(event->bits) & mask;
+    if( bits != 0 )
+    {
+        SCHEDULER_HW_ATOMIC_AND(event->bits, ~bits);
+        process->event = NULL;
+        process->wake_bits = bits;
+        process->due = now;
+        schedule_insert(process, now);
+
+        return process_handle(process);
+    }
+
+    // Park the process on the event, and in the timing wheel until it times out
+    process->event = event;
+    process->wait_mask = mask;
+    process->wake_bits = 0;
+    event_wait(process);
+    if( timeout != 0 )
+    {
+        process->due = now + timeout;
+        wheel_insert(process);
+    }
+
+    return process_handle(process);
+}
+
+
+/**
+ * Get the event bits which woke the running process. Must be called from a scheduled process.
+ *
+ * @return     The bits consumed when the process was woken by schedule_on_event(), or zero if it
+ *             timed out or was not waiting on an event.
+ */
+unsigned int scheduler_wake_bits(void)
+{
+    if( current_process == NULL )
+    {
+        return 0;
+    }
+
+    return current_process->wake_bits;
+}
+
+
+/**
+ * This function schedules @em func to run as a coroutine. A coroutine suspends itself with the
+ * SCHEDULER_CO_ macros and resumes where it left off on its next run, keeping only its resume point
+ * and a small context in its place in the process pool, so it needs no stack of its own. It keeps
+ * its place in the schedule until it returns without suspending. When called from an ISR the
+ * coroutine is not scheduled.
+ *
+ * @param[in]  func
+ *             A pointer to the coroutine, whose body is wrapped in SCHEDULER_CO_BEGIN() and
+ *             SCHEDULER_CO_END().
+ *
+ * @param[in]  priority
+ *             When/in what order the coroutine first runs, see schedule().
+ *
+ * @param[in]  params
+ *             A pointer to the parameters to pass into the coroutine on every run.
+ *
+ * @return     A handle to the coroutine, see schedule(), or zero if @em func was invalid, this was
+ *             called from an ISR, or the schedule was full.
+ */
+scheduler_handle_t schedule_coroutine(void (*func)(void *), int priority, void *params)
+{
+    process_t *process;
+    unsigned long now;
+    unsigned int iterator;
+
+    // Check for valid function pointer, and that this is not an ISR
+    if( func == NULL || SCHEDULER_HW_CURRENT_IPL() != 0 )
+    {
+        return 0;
+    }
+
+    // Take a process from the pool
+    process = process_alloc();
+    if( process == NULL )
+    {// Schedule is full
+        return 0;
+    }
+
+    // Copy data into the process, start the coroutine from its beginning with a clear context
+    now = get_ticks();
+    process->func = func;
+    process->params = params;
+    process->due = now + priority;
+    process->sequence = schedule_sequence++;
+    process->period = 0;
+    process->event = NULL;
+    process->wake_bits = 0;
+    process->coroutine = true;
+    process->deadline_ticks = 0;
+    process->co.resume = 0;
+    for( iterator = 0; iterator < sizeof(process->co.context)/sizeof(process->co.context[0]);
+         ++iterator )
+    {
+        process->co.context[iterator] = 0;
+    }
+    schedule_insert(process, now);
+
+    return process_handle(process);
+}
+
+
+/**
+ * Get the resume point and context of the running coroutine. Must be called from a coroutine, see
+ * schedule_coroutine().
+ *
+ * @return     A pointer to the running coroutine's state.
+ */
+scheduler_co_t * scheduler_co_self(void)
+{
+    return &current_process->co;
+}
+
+
+/**
+ * Suspend the running coroutine for @em ticks ticks once it returns. Zero lets every other ready
+ * process run first, under the EDF policy too: a yield takes the latest ready deadline if its own
+ * is earlier. This is the function behind SCHEDULER_CO_SLEEP() and SCHEDULER_CO_YIELD().
+ *
+ * @param[in]  ticks
+ *             The number of ticks, from now, after which the coroutine resumes.
+ *
+ * @return     True if the coroutine must return to suspend or because it was cancelled, false if
+ *             this was not called from a coroutine or the coroutine has already suspended itself
+ *             during this run.
+ */
+int scheduler_co_sleep(unsigned int ticks)
+{
+    process_t *process = current_process;
+
+    if( process == NULL || !process->coroutine )
+    {
+        return false;
+    }
+
+    if( process->co_suspend != CO_RUNNING )
+    {// Return straight away if cancelled, dispatch() then releases the coroutine
+        return process->co_suspend == CO_CANCELLED;
+    }
+
+    process->due = get_ticks() + ticks;
+    process->wake_bits = 0;
+    process->co_suspend = CO_SLEEP;
+
+    return true;
+}
+
+
+/**
+ * Suspend the running coroutine, once it returns, until any of the @em mask bits are posted to
+ * @em event or @em timeout ticks pass. If a bit is already posted it is consumed and the coroutine
+ * carries on without suspending. Either way scheduler_wake_bits() returns the bits which were
+ * consumed, or zero after a timeout. This is the function behind SCHEDULER_CO_AWAIT().
+ *
+ * @param[in]  event
+ *             A pointer to the event to wait on.
+ *
+ * @param[in]  mask
+ *             The event bits which wake the coroutine. Must not be zero.
+ *
+ * @param[in]  timeout
+ *             The number of ticks, from now, after which the coroutine resumes anyway, or zero to
+ *             wait forever.
+ *
+ * @return     True if the coroutine must return to suspend or because it was cancelled, false if a
+ *             bit was already posted, the arguments were invalid, this was not called from a
+ *             coroutine, or the coroutine has already suspended itself during this run.
+ */
+int scheduler_co_await(scheduler_event_t *event, unsigned int mask, unsigned int timeout)
+{
+    process_t *process = current_process;
+    unsigned int bits;
+
+    if( process == NULL || !process->coroutine || event == NULL || mask == 0 )
+    {
+        return false;
+    }
+
+    if( process->co_suspend != CO_RUNNING )
+    {// Return straight away if cancelled, without consuming any bits
+        return process->co_suspend == CO_CANCELLED;
+    }
+
+    // A bit which is already posted is consumed without suspending
+    bits = SCHEDULER_HW_LOAD_ACQUIRE(event->bits) & mask;
+    if( bits != 0 )
+    {
+        SCHEDULER_HW_ATOMIC_AND(event->bits, ~bits);
+        process->wake_bits = bits;
+
+        return false;
+    }
+
+    // The coroutine is parked on the event once it returns
+    process->event = event;
+    process->wait_mask = mask;
+    process->wake_bits = 0;
+    process->due = get_ticks() + timeout;
+    process->co_suspend = (timeout != 0) ? CO_AWAIT_TIMEOUT : CO_AWAIT;
+
+    return true;
+}
+
+
+/**
+ * Insert a process into the schedule heap if it is due, or into the timing wheel if it is delayed.
+ * Must be called from the main loop.
+ *
+ * @param[in]  process
+ *             A pointer to the process to insert.
+ *
+ * @param[in]  now
+ *             The current kernel tick.
+ */
+void schedule_insert(process_t *process, unsigned long now)
+{
+    // A process without a deadline of its own is due by its due tick
+    process->deadline = process->due + process->deadline_ticks;
+
+    schedule_place(process, now);
+}
+
+
+/**
+ * Insert a process into the schedule heap if it is due, or into the timing wheel if it is delayed,
+ * without recomputing its deadline. Must be called from the main loop.
+ *
+ * @param[in]  process
+ *             A pointer to the process to insert, with its deadline already set.
+ *
+ * @param[in]  now
+ *             The current kernel tick.
+ */
+void schedule_place(process_t *process, unsigned long now)
+{
+    if( TICK_BEFORE_EQ(process->due, now) )
+    {// Process is ready
+#if defined(SCHEDULE_PROFILE)
+        process->ready_cycles = get_cycles();
+#endif
+        heap_push(process);
+    }
+    else
+    {// Process is delayed, it becomes ready at the start of its due tick
+#if defined(SCHEDULE_PROFILE)
+        process->ready_cycles = process->due * TICK_CYCLES;
+#endif
+        wheel_insert(process);
+    }
+}
+
+
+/**
+ * Move the processes queued by ISRs into the schedule, higher interrupt priority levels first.
+ * Processes which do not fit in the schedule are left queued until there is room. Must be called
+ * from the main loop.
+ */
+void drain_isr_rings(void)
+{
+    unsigned long now = get_ticks();
+    unsigned int level;
+    unsigned int tail;
+    isr_ring_t *ring;
+    isr_entry_t *entry;
+    process_t *process;
+
+    for( level = SCHEDULER_HW_IPL_LEVELS; level > 0; --level )
+    {
+        ring = &isr_rings[level-1];
+        for( tail = ring->tail; tail != SCHEDULER_HW_LOAD_ACQUIRE(ring->head); ++tail )
+        {
+            process = process_alloc();
+            if( process == NULL )
+            {// Schedule is full
+                return;
+            }
+
+            // Copy the entry, then hand its place back to the ISR
+            entry = &ring->entries[ISR_RING_INDEX(tail)];
+            process->func = entry->func;
+            process->params = entry->params;
+            process->due = now + entry->priority;
+            SCHEDULER_HW_STORE_RELEASE(ring->tail, tail+1);
+
+            process->sequence = schedule_sequence++;
+            process->period = 0;
+            process->event = NULL;
+            process->wake_bits = 0;
+            process->coroutine = false;
+            process->deadline_ticks = 0;
+            schedule_insert(process, now);
+        }
+    }
+}
+
+
+
+
+/**
+ * Wake every process waiting on an event which has been posted since the last call. Each waiter is
+ * woken with the posted bits it waits on, and those bits are consumed. Events found without
+ * waiters are dropped from the active list. Must be called from the main loop.
+ */
+void post_events(void)
+{
+    scheduler_event_t **link;
+    scheduler_event_t *event;
+    process_t *process;
+    process_t *next;
+    unsigned long now;
+    unsigned int bits;
+    unsigned int matched;
+    unsigned int consumed;
+
+    // Only clear the flag once it is seen set, and before reading the bits, so a post made
+    // meanwhile is either read below or seen on the next pass. Clearing it unconditionally would
+    // wipe out a post made from an ISR between the test and the clear.
+    if( !SCHEDULER_HW_LOAD_ACQUIRE(events_posted) )
+    {
+        return;
+    }
+    SCHEDULER_HW_STORE_RELEASE(events_posted, 0);
+
+    now = get_ticks();
+    link = &active_events;
+    while( (event = *link) != NULL )
+    {
+        if( event->waiters == NULL )
+        {// No more waiters, drop the event from the active list
+            *link = event->next_active;
+            event->next_active = NULL;
+            event->active = false;
+            continue;
+        }
+
+        bits = SCHEDULER_HW_LOAD_ACQUIRE(event->bits);
+        consumed = 0;
+        for( process = event->waiters; process != NULL && bits != 0; process = next )
+        {
+            next = process->wait_next;
+            matched = bits & process->wait_mask;
+            if( matched != 0 )
+            {
+                consumed |= matched;
+                event_wake(process, matched, now);
+            }
+        }
+
+        if( consumed != 0 )
+        {
+            SCHEDULER_HW_ATOMIC_AND(event->bits, ~consumed);
+        }
+
+        link = &event->next_active;
+    }
+}
+
+
+/**
+ * Add a process to the end of its event's waiters, and the event to the active list if it is not
+ * already there. Must be called from the main loop.
+ *
+ * @param[in]  process
+ *             A pointer to the process to add. Its event must be set.
+ */
+void event_wait(process_t *process)
+{
+    scheduler_event_t *event = process->event;
+    process_t **link = &event->waiters;
+
+    // Waiters are woken in the order they started waiting
+    while( *link != NULL )
+    {
+        link = &(*link)->wait_next;
+    }
+    *link = process;
+    process->wait_pprev = link;
+    process->wait_next = NULL;
+
+    if( !event->active )
+    {
+        event->next_active = active_events;
+        active_events = event;
+        event->active = true;
+    }
+}
+
+
+/**
+ * Remove a process from its event's waiters in O(1). The event is left in the active list, it is
+ * dropped once it is found without waiters. Must be called from the main loop.
+ *
+ * @param[in]  process
+ *             A pointer to the waiting process.
+ */
+void event_unwait(process_t *process)
+{
+    *process->wait_pprev = process->wait_next;
+    if( process->wait_next != NULL )
+    {
+        process->wait_next->wait_pprev = process->wait_pprev;
+    }
+    process->wait_next = NULL;
+    process->wait_pprev = NULL;
+}
+
+
+/**
+ * Wake a process waiting on an event: remove it from the event's waiters and from the timing wheel,
+ * and insert it into the schedule. Must be called from the main loop.
+ *
+ * @param[in]  process
+ *             A pointer to the waiting process.
+ *
+ * @param[in]  bits
+ *             The event bits which woke the process, or zero if it timed out.
+ *
+ * @param[in]  now
+ *             The current kernel tick.
+ */
+void event_wake(process_t *process, unsigned int bits, unsigned long now)
+{
+    event_unwait(process);
+
+    if( process->pprev != NULL )
+    {// Cancel the timeout
+        wheel_remove(process);
+    }
+
+    process->event = NULL;
+    process->wake_bits = bits;
+    process->due = now;
+    process->sequence = schedule_sequence++;
+    schedule_insert(process, now);
+}
+
+
+/**
+ * Put a coroutine which suspended itself during its run back to sleep: into the schedule or timing
+ * wheel if it is sleeping, or onto its event's waiters if it is waiting. A timeout which has
+ * already passed wakes it straight away. Must be called from the main loop.
+ *
+ * @param[in]  process
+ *             A pointer to the coroutine which has just run.
+ */
+void coroutine_suspend(process_t *process)
+{
+    unsigned long now = get_ticks();
+#if SCHEDULE_POLICY == SCHEDULE_POLICY_EDF
+    unsigned long latest;
+#endif
+
+    process->sequence = schedule_sequence++;
+
+    if( process->co_suspend == CO_SLEEP )
+    {
+        process->deadline = process->due + process->deadline_ticks;
+#if SCHEDULE_POLICY == SCHEDULE_POLICY_EDF
+        if( TICK_BEFORE_EQ(process->due, now) )
+        {// A yield sorts behind every process which is already ready, whatever their deadlines
+            latest = heap_latest_deadline(now);
+            if( TICK_BEFORE_EQ(process->deadline, latest) )
+            {
+                process->deadline = latest;
+            }
+        }
+#endif
+        schedule_place(process, now);
+
+        return;
+    }
+
+    // Park the coroutine on its event, and in the timing wheel until it times out
+    process->pprev = NULL;
+    event_wait(process);
+    if( process->co_suspend == CO_AWAIT_TIMEOUT )
+    {
+        if( TICK_BEFORE_EQ(process->due, now) )
+        {// Timed out while still running
+            event_wake(process, 0, now);
+        }
+        else
+        {
+            wheel_insert(process);
+        }
+    }
+}
+
+
+/**
+ * Count a run which completed after its deadline and report it to the deadline miss callback.
+ * Processes without a deadline of their own are not checked. Must be called from the main loop.
+ *
+ * @param[in]  process
+ *             A pointer to the process which has just run.
+ */
+void deadline_check(const process_t *process)
+{
+    unsigned long now;
+    unsigned long lateness;
+
+    if( process->deadline_ticks == 0 )
+    {
+        return;
+    }
+
+    now = get_ticks();
+    if( TICK_BEFORE_EQ(now, process->deadline) )
+    {// Completed in time
+        return;
+    }
+
+    lateness = now - process->deadline;
+    deadline_stats.misses++;
+    if( lateness > deadline_stats.max_lateness )
+    {
+        deadline_stats.max_lateness = lateness;
+    }
+
+    if( deadline_miss_callback != NULL )
+    {
+        deadline_miss_callback(process->func, lateness);
+    }
+}
+
+
+/**
+ * Schedule the next release of a periodic process which has just run. The deadline of the run is
+ * the next release. A run completing after it is counted as a deadline miss, and releases which
+ * have passed in full are skipped and counted as overruns. Must be called from the main loop.
+ *
+ * @param[in]  process
+ *             A pointer to the periodic process which has just run.
+ */
+void process_release(process_t *process)
+{
+    unsigned long now = get_ticks();
+    unsigned long deadline = process->release + process->period;
+    unsigned long skipped = 0;
+
+    if( !TICK_BEFORE_EQ(now, deadline) )
+    {// Completed after the deadline, skip every release which has passed in full
+        skipped = (now - deadline) / process->period;
+    }
+
+    // Record the run
+    process->stats.releases++;
+    if( !TICK_BEFORE_EQ(now, deadline) )
+    {
+        process->stats.deadline_misses++;
+        process->stats.overruns += skipped;
+    }
+
+    // Insert the next release into the schedule
+    process->release = deadline + skipped*process->period;
+    process->due = process->release;
+    process->sequence = schedule_sequence++;
+    schedule_insert(process, now);
+}
+
+
+/**
+ * Determine whether process @em a should run before process @em b. Under the FIFO policy earlier
+ * due ticks run first. A process scheduled with priority p on tick t is due on tick t+p, so this is
+ * the same order the old per-tick priority decrement produced. Under the EDF policy earlier
+ * deadlines run first. Either way ties run in the order they were scheduled.
+ *
+ * @return      True if @em a should run before @em b.
+ */
+bool process_before(const process_t *a, const process_t *b)
+{
+#if SCHEDULE_POLICY == SCHEDULE_POLICY_EDF
+    if( a->deadline != b->deadline )
+    {
+        return (long)(a->deadline - b->deadline) < 0;
+    }
+#else
+    if( a->due != b->due )
+    {
+        return (long)(a->due - b->due) < 0;
+    }
+#endif
+
+    // Compare sequences as a signed difference so that the comparison survives wrap-around
+    return (int)(a->sequence - b->sequence) < 0;
+}
+
+
+/**
+ * Place a process in the schedule heap at @em index or above it, moving parents down until its
+ * place is found. Must be called from the main loop.
+ *
+ * @param[in]  process
+ *             A pointer to the process to place.
+ *
+ * @param[in]  index
+ *             The empty index in the heap to start from.
+ */
+void heap_sift_up(process_t *process, unsigned int index)
+{
+    unsigned int parent;
+
+    while( index > 0 )
+    {
+        parent = (index-1)/2;
+        if( !process_before(process, schedule_heap[parent]) )
+        {// Parent runs first, place found
+            break;
+        }
+        schedule_heap[index] = schedule_heap[parent];
+        schedule_heap[index]->heap_index = index;
+        index = parent;
+    }
+    schedule_heap[index] = process;
+    process->heap_index = index;
+}
+
+
+/**
+ * Place a process in the schedule heap at @em index or below it, moving children up until its
+ * place is found. Must be called from the main loop.
+ *
+ * @param[in]  process
+ *             A pointer to the process to place.
+ *
+ * @param[in]  index
+ *             The empty index in the heap to start from.
+ */
+void heap_sift_down(process_t *process, unsigned int index)
+{
+    unsigned int child;
+
+    for( child = 2*index+1; child < schedule_length; child = 2*index+1 )
+    {
+        // Pick the child which runs first
+        if( child+1 < schedule_length && process_before(schedule_heap[child+1], schedule_heap[child]) )
+        {
+            ++child;
+        }
+        if( !process_before(schedule_heap[child], process) )
+        {// Process runs first, place found
+            break;
+        }
+        schedule_heap[index] = schedule_heap[child];
+        schedule_heap[index]->heap_index = index;
+        index = child;
+    }
+    schedule_heap[index] = process;
+    process->heap_index = index;
+}
+
+
+/**
+ * Insert a process into the schedule heap in O(log n). Must be called from the main loop and with
+ * room in the heap.
+ *
+ * @param[in]  process
+ *             A pointer to the process to insert.
+ */
+void heap_push(process_t *process)
+{
+    heap_sift_up(process, schedule_length++);
+}
+
+
+#if SCHEDULE_POLICY == SCHEDULE_POLICY_EDF
+/**
+ * Find the latest deadline among the processes in the schedule heap. The latest deadline of a heap
+ * ordered by earliest deadline is always on a leaf, so only the lower half is searched. Must be
+ * called from the main loop.
+ *
+ * @param[in]  now
+ *             The current kernel tick, returned if no ready process has a later deadline.
+ *
+ * @return     The latest ready deadline, or @em now.
+ */
+unsigned long heap_latest_deadline(unsigned long now)
+{
+    unsigned long latest = now;
+    unsigned int index;
+
+    for( index = schedule_length/2; index < schedule_length; ++index )
+    {
+        if( TICK_BEFORE_EQ(latest, schedule_heap[index]->deadline) )
+        {
+            latest = schedule_heap[index]->deadline;
+        }
+    }
+
+    return latest;
+}
+#endif
+
+
+/**
+ * Remove the root process from the schedule heap in O(log n). Must be called from the main loop and
+ * with at least one process in the heap.
+ *
+ * @return      A pointer to the removed process.
+ */
+process_t * heap_pop(void)
+{
+    process_t *root = schedule_heap[0];
+
+    heap_remove(root);
+
+    return root;
+}
+
+
+/**
+ * Remove any process from the schedule heap in O(log n). The last process in the heap takes its
+ * place and is sifted up or down from there. Must be called from the main loop.
+ *
+ * @param[in]  process
+ *             A pointer to the process to remove. It must be in the heap.
+ */
+void heap_remove(process_t *process)
+{
+    unsigned int index = process->heap_index;
+    process_t *last = schedule_heap[--schedule_length];
+
+    schedule_heap[schedule_length] = NULL;
+    if( last == process )
+    {// Removed the last process, nothing to fill
+        return;
+    }
+
+    if( index > 0 && process_before(last, schedule_heap[(index-1)/2]) )
+    {
+        heap_sift_up(last, index);
+    }
+    else
+    {
+        heap_sift_down(last, index);
+    }
+}
+
+
+/**
+ * Get the next scheduled process if it is ready to run and remove it from the
+ * schedule. Must be called from the main loop.
+ *
+ * @return      A pointer to the next process in the schedule queue.
+ */
+process_t * get_scheduled()
+{
+    process_t *next_process = NULL;
+
+    // Every process in the heap is ready to run, delayed processes wait in the timing wheel
+    if( schedule_length > 0 )
+    {// Remove next process from the schedule
+        next_process = heap_pop();
+    }
+
+    // Return next process (or NULL)
+    return next_process;
+}
+
+
+/**
+ * Take an unused process from the static process pool. Must be called from the main loop.
+ *
+ * @return      A pointer to an unused process, or NULL if the pool is exhausted.
+ */
+process_t * process_alloc(void)
+{
+    process_t *process;
+
+    // Reuse a released process if there is one
+    if( free_list != NULL )
+    {// Pop the head of the free list
+        process = free_list;
+        free_list = process->next;
+
+        return process;
+    }
+
+    // Otherwise hand out a process which has never been used
+    if( pool_unused > 0 )
+    {// Take the next unused process, its handles start at the first generation
+        --pool_unused;
+        process_pool[pool_unused].generation = 1;
+
+        return &process_pool[pool_unused];
+    }
+
+    // Pool is exhausted
+    return NULL;
+}
+
+
+/**
+ * Return a process to the static process pool. Must be called from the main loop.
+ *
+ * @param[in]  process
+ *             A pointer to the process to release. It must have been taken with process_alloc().
+ */
+void process_free(process_t *process)
+{
+#if defined(SCHEDULE_BUDGET)
+    process->budget_deferred = false;
+#endif
+
+    // Invalidate handles to the process
+    process->generation = (process->generation < HANDLE_GENERATIONS) ? process->generation+1 : 1;
+
+    // Push process onto the free list
+    process->next = free_list;
+    free_list = process;
+}
+
+
+/**
+ * Make a handle to a process from its place in the pool and its generation.
+ *
+ * @param[in]  process
+ *             A pointer to a process taken with process_alloc().
+ *
+ * @return      The process' handle, never zero or SCHEDULER_HANDLE_DEFERRED.
+ */
+scheduler_handle_t process_handle(const process_t *process)
+{
+    return process->generation*SCHEDULE_LIST_LENGTH + (unsigned int)(process - process_pool);
+}
+
+
+/**
+ * Find the process a handle refers to in O(1). Must be called from the main loop.
+ *
+ * @param[in]  handle
+ *             A handle returned by schedule() or the like.
+ *
+ * @return      A pointer to the process, or NULL if the handle is invalid or the process it referred
+ *             to has been released.
+ */
+process_t * handle_process(scheduler_handle_t handle)
+{
+    unsigned int index = handle % SCHEDULE_LIST_LENGTH;
+
+    if( index < pool_unused || process_pool[index].generation != handle / SCHEDULE_LIST_LENGTH )
+    {// Never handed out, or released since
+        return NULL;
+    }
+
+    return &process_pool[index];
+}
+
+
+/**
+ * Remove a scheduled process from wherever it waits: the schedule heap, the timing wheel, or its
+ * event's waiters and the timing wheel. Must be called from the main loop.
+ *
+ * @param[in]  process
+ *             A pointer to the process to remove. It must not be running.
+ */
+void process_unlink(process_t *process)
+{
+    bool waiting = (process->event != NULL);
+
+    if( waiting )
+    {
+        event_unwait(process);
+        process->event = NULL;
+    }
+
+    if( process->pprev != NULL )
+    {// Delayed, or waiting with a timeout
+        wheel_remove(process);
+    }
+    else if( !waiting )
+    {// Ready
+        heap_remove(process);
+    }
+}
+
+
+/**
+ * Read the kernel tick counter. The counter is wider than a single instruction can read, so it is
+ * read again until two reads agree, in case the tick ISR changed it between the halves of a read.
+ * This function is atomic and leaves interrupts enabled, so it may be called from a critical
+ * section or an ISR.
+ *
+ * @return      The current kernel tick.
+ */
+unsigned long get_ticks(void)
+{
+    unsigned long now;
+
+    do
+    {
+        now = ticks;
+    } while( now != ticks );
+
+    return now;
+}
+
+
+/**
+ * Read the kernel tick counter together with the Timer1 count into the current tick. If the tick
+ * ISR runs during the read, the tick counter no longer matches the Timer1 count and both are read
+ * again. If the period has ended but the tick ISR is held off (this is called from an ISR or a
+ * critical section), the rolled over Timer1 count is read and the pending ticks are counted here.
+ * This function is atomic and may be called from an ISR.
+ *
+ * @param[out] timer
+ *             The Timer1 count since the start of the returned tick. This exceeds a tick's worth
+ *             of counts while the scheduler idles tickless.
+ *
+ * @return      The current kernel tick.
+ */
+unsigned long read_time(unsigned int *timer)
+{
+    unsigned long now;
+    unsigned int count;
+    unsigned int pending;
+
+    do
+    {
+        now = ticks;
+        count = TMR1 - CURRENT_TICK_OFFSET();
+        pending = 0;
+        if( IFS0bits.T1IF )
+        {// The period has ended but the tick ISR has not counted it yet, reread the rolled over timer
+            count = TMR1;
+            pending = CURRENT_TICK_STEP();
+        }
+    } while( now != ticks );
+
+    *timer = count;
+
+    return now + pending;
+}
+
+
+/**
+ * Read the kernel time in Timer1 counts, the tick counter scaled by the counts per tick plus the
+ * count of the current tick, see read_time(). Timer1 counts at the instruction clock, so this
+ * resolves to a fraction of a microsecond. The result wraps around with the tick counter. This
+ * function is atomic and may be called from an ISR.
+ *
+ * @return      The current kernel time in Timer1 counts.
+ */
+unsigned long long scheduler_now_cycles(void)
+{
+    unsigned int timer;
+    unsigned long now = read_time(&timer);
+
+    return (unsigned long long)now*TICK_CYCLES + timer;
+}
+
+
+/**
+ * Read the kernel time in microseconds, see scheduler_now_cycles(). The result wraps around with
+ * the tick counter. This function is atomic and may be called from an ISR.
+ *
+ * @return      The current kernel time in microseconds.
+ */
+unsigned long long scheduler_now_us(void)
+{
+    unsigned int timer;
+    unsigned long now = read_time(&timer);
+
+    return (unsigned long long)now*SCHEDULER_HW_TICK_US
+           + ((unsigned long)timer*SCHEDULER_HW_TICK_US) / TICK_CYCLES;
+}
+
+
+#if defined(SCHEDULE_PROFILE)
+/**
+ * Read the kernel time in Timer1 counts, truncated to an unsigned long, see scheduler_now_cycles().
+ * Only differences are meaningful. This function is atomic.
+ *
+ * @return      The current kernel time in Timer1 counts.
+ */
+unsigned long get_cycles(void)
+{
+    unsigned int timer;
+    unsigned long now = read_time(&timer);
+
+    return now*TICK_CYCLES + timer;
+}
+#endif
+
+
+/**
+ * Insert a delayed process into the timing wheel bucket for its due tick in O(1). Must be called
+ * from the main loop.
+ *
+ * @param[in]  process
+ *             A pointer to the process to insert. Its due tick must be after the current tick.
+ */
+void wheel_insert(process_t *process)
+{
+    process_t **bucket = &schedule_wheel[WHEEL_BUCKET(process->due)];
+
+    process->next = *bucket;
+    if( process->next != NULL )
+    {
+        process->next->pprev = &process->next;
+    }
+    *bucket = process;
+    process->pprev = bucket;
+}
+
+
+/**
+ * Remove a delayed process from its timing wheel bucket in O(1). Must be called from the main loop.
+ *
+ * @param[in]  process
+ *             A pointer to the process to remove. It must be in the timing wheel.
+ */
+void wheel_remove(process_t *process)
+{
+    *process->pprev = process->next;
+    if( process->next != NULL )
+    {
+        process->next->pprev = process->pprev;
+    }
+    process->next = NULL;
+    process->pprev = NULL;
+}
+
+
+/**
+ * Move every process in a timing wheel bucket which is due on or before @em now into the schedule
+ * heap. Processes due on a later revolution of the wheel are left in the bucket. Must be called
+ * from the main loop.
+ *
+ * @param[in]  bucket
+ *             The index of the timing wheel bucket to expire.
+ *
+ * @param[in]  now
+ *             The current kernel tick.
+ */
+void wheel_expire(unsigned int bucket, unsigned long now)
+{
+    process_t **link;
+    process_t *process;
+
+    link = &schedule_wheel[bucket];
+    while( *link != NULL )
+    {
+        process = *link;
+        if( TICK_BEFORE_EQ(process->due, now) )
+        {// Process has expired, unlink it and add it to the schedule
+            wheel_remove(process);
+            if( process->event != NULL )
+            {// Process timed out waiting on an event
+                event_wake(process, 0, now);
+            }
+            else
+            {
+                heap_push(process);
+            }
+        }
+        else
+        {// Process is due on a later revolution
+            link = &process->next;
+        }
+    }
+}
+
+
+/**
+ * Expire the timing wheel bucket of every tick since the last call, up to the current tick. This
+ * runs from the main loop rather than the Timer1 ISR, so the ISR does constant work regardless of
+ * how many processes are delayed. If the main loop has fallen a full revolution or more behind,
+ * each bucket is expired once instead of once per missed tick.
+ */
+void advance_wheel(void)
+{
+    unsigned long now = get_ticks();
+    unsigned int bucket;
+
+    if( now - wheel_ticks >= SCHEDULE_WHEEL_LENGTH )
+    {// A full revolution or more has passed, every bucket may hold expired processes
+        for( bucket = 0; bucket < SCHEDULE_WHEEL_LENGTH; ++bucket )
+        {
+            wheel_expire(bucket, now);
+        }
+        wheel_ticks = now;
+
+        return;
+    }
+
+    while( wheel_ticks != now )
+    {
+        ++wheel_ticks;
+        wheel_expire(WHEEL_BUCKET(wheel_ticks), now);
+    }
+}
+
+
+#if defined(SCHEDULE_TICKLESS)
+/**
+ * Check whether any ISR has queued a process which the main loop has not collected.
+ *
+ * @return      True if a process is queued.
+ */
+bool isr_rings_pending(void)
+{
+    unsigned int level;
+
+    for( level = 0; level < SCHEDULER_HW_IPL_LEVELS; ++level )
+    {
+        if( SCHEDULER_HW_LOAD_ACQUIRE(isr_rings[level].head) != isr_rings[level].tail )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/**
+ * Find the number of ticks until the next delayed process is due, searching no further than the
+ * longest period Timer1 can count. Must be called after advance_wheel() has caught up to @em now.
+ *
+ * @param[in]  now
+ *             The current kernel tick.
+ *
+ * @return      The number of ticks to idle, between 1 and TICKLESS_MAX_TICKS.
+ */
+unsigned int next_expiry(unsigned long now)
+{
+    unsigned int offset;
+    process_t *process;
+
+    for( offset = 1; offset < TICKLESS_MAX_TICKS; ++offset )
+    {
+        for( process = schedule_wheel[WHEEL_BUCKET(now+offset)]; process != NULL;
+             process = process->next )
+        {
+            if( TICK_BEFORE_EQ(process->due, now+offset) )
+            {// Process is due on this tick
+                return offset;
+            }
+        }
+    }
+
+    return TICKLESS_MAX_TICKS;
+}
+
+
+/**
+ * Idle the CPU until the next delayed process is due. Timer1 is stretched to span every tick until
+ * then, so the tick ISR does not wake the CPU in between. If another interrupt wakes the CPU first
+ * the ticks which have already passed are counted and Timer1 returns to single ticks, so the tick
+ * counter stays exact across periods of any length.
+ */
+void idle(void)
+{
+    unsigned long now = get_ticks();
+    unsigned int sleep_ticks;
+    unsigned int elapsed;
+    unsigned int count;
+
+    // Search the wheel with interrupts enabled, only the main loop changes it
+    sleep_ticks = next_expiry(now);
+
+    // Disable interrupts
+    SCHEDULER_HW_DISABLE_INTERRUPTS();
+
+    // Give up if anything is ready, an ISR queued a process or posted an event, or a tick passed
+    // since the search
+    if( schedule_length > 0 || isr_rings_pending() || events_posted || now != ticks
+        || IFS0bits.T1IF )
+    {
+        // Reenable interrupts
+        SCHEDULER_HW_ENABLE_INTERRUPTS();
+
+        return;
+    }
+
+    // Stretch the current Timer1 period. TMR1 is still within the first tick, so the match is
+    // sleep_ticks whole ticks after the last one. For the rest of a period cut short by an early
+    // wake the match already ends the current tick, and is left alone.
+    if( tick_offset == 0 )
+    {
+        tick_step = sleep_ticks;
+        PR1 = TICKLESS_PERIOD(sleep_ticks);
+    }
+
+    // Wait for an interrupt
+    SCHEDULER_HW_IDLE();
+
+    // The DISI count may have run out during a long idle, so the fixup takes a window of its own
+    SCHEDULER_HW_DISABLE_INTERRUPTS();
+
+    if( tick_step > 1 && !IFS0bits.T1IF )
+    {// Woken early by another interrupt, count the whole ticks passed and return to single ticks
+        // Timer1 keeps running and the match moves to the end of the current tick, so no counts
+        // are lost. A tick boundary about to pass is counted now rather than moving the match
+        // behind the running count.
+        count = TMR1;
+        elapsed = count / (SCHEDULER_HW_TICK_PERIOD+1U);
+        if( elapsed+1U < tick_step
+            && (elapsed+1U) * (SCHEDULER_HW_TICK_PERIOD+1U) - count < TICKLESS_WAKE_MARGIN )
+        {
+            ++elapsed;
+        }
+
+        ticks += elapsed;
+        tick_offset = elapsed * (SCHEDULER_HW_TICK_PERIOD+1U);
+        if( elapsed+1U < tick_step )
+        {// Otherwise the match already ends the current tick
+            PR1 = TICKLESS_PERIOD(elapsed+1U);
+        }
+        tick_step = 1;
+    }
+    // Otherwise the tick ISR is pending, or has run, and accounts for the whole period
+
+    // Reenable interrupts
+    SCHEDULER_HW_ENABLE_INTERRUPTS();
+}
+#endif
+
+
+#if defined(SCHEDULE_PROFILE)
+/**
+ * Add a run of a process to the profile of its function. Functions which do not fit in the profile
+ * table are only counted in profile_untracked.
+ *
+ * @param[in]  process
+ *             A pointer to the process which ran.
+ *
+ * @param[in]  start
+ *             The time, in Timer1 counts, at which the process started running.
+ *
+ * @param[in]  end
+ *             The time, in Timer1 counts, at which the process finished running.
+ */
+void profile_record(const process_t *process, unsigned long start, unsigned long end)
+{
+    scheduler_profile_t *profile = NULL;
+    unsigned long elapsed = end - start;
+    unsigned long latency = start - process->ready_cycles;
+    unsigned int iterator;
+
+    // Find the function's profile
+    for( iterator = 0; iterator < profile_length; ++iterator )
+    {
+        if( profile_table[iterator].func == process->func )
+        {
+            profile = &profile_table[iterator];
+            break;
+        }
+    }
+
+    if( profile == NULL )
+    {// First run of this function
+        if( profile_length >= SCHEDULE_PROFILE_LENGTH )
+        {// Profile table is full
+            profile_untracked++;
+
+            return;
+        }
+
+        profile = &profile_table[profile_length++];
+        profile->func = process->func;
+        profile->min = elapsed;
+    }
+
+    // Latency is negative when a delayed process was rescheduled ahead of its due tick
+    if( (long)latency < 0 )
+    {
+        latency = 0;
+    }
+
+    profile->runs++;
+    profile->total += elapsed;
+    profile->latency_total += latency;
+    if( elapsed < profile->min )
+    {
+        profile->min = elapsed;
+    }
+    if( elapsed > profile->max )
+    {
+        profile->max = elapsed;
+    }
+    if( latency > profile->latency_max )
+    {
+        profile->latency_max = latency;
+    }
+}
+
+
+/**
+ * Write the low @em size bytes of @em value to @em buffer, least significant byte first, and
+ * advance @em buffer past them.
+ */
+void profile_put(unsigned char **buffer, unsigned long long value, unsigned int size)
+{
+    while( size-- > 0 )
+    {
+        *(*buffer)++ = (unsigned char)value;
+        value >>= 8;
+    }
+}
+
+
+/**
+ * Get the run time profile of @em func. Must be called from the main loop (i.e. from a scheduled
+ * process), since the profiles are updated there.
+ *
+ * @param[in]  func
+ *             The function whose profile should be returned.
+ *
+ * @param[out] profile
+ *             A pointer to the profile structure to fill.
+ *
+ * @return     True if @em func has run and is tracked, false otherwise.
+ */
+int scheduler_profile_get(void (*func)(void *), scheduler_profile_t *profile)
+{
+    unsigned int iterator;
+
+    if( profile == NULL )
+    {
+        return false;
+    }
+
+    for( iterator = 0; iterator < profile_length; ++iterator )
+    {
+        if( profile_table[iterator].func == func )
+        {
+            *profile = profile_table[iterator];
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/**
+ * Write every profile to @em buffer in a compact binary format, for sending over a serial link.
+ * All values are little endian. The header is SCHEDULE_PROFILE_DUMP_HEADER_SIZE bytes:
+ *
+ * <tt>'S' 'P' version:1 records:1 tick_counts:2 untracked_runs:4</tt>
+ *
+ * It is followed by one SCHEDULE_PROFILE_DUMP_RECORD_SIZE byte record per function:
+ *
+ * <tt>func:4 runs:4 total:8 min:4 max:4 latency_total:8 latency_max:4</tt>
+ *
+ * Only the records which fit in @em length are written. Must be called from the main loop.
+ *
+ * @param[out] buffer
+ *             A pointer to the buffer to write to.
+ *
+ * @param[in]  length
+ *             The length of @em buffer in bytes.
+ *
+ * @return     The number of bytes written, or zero if the header does not fit.
+ */
+unsigned int scheduler_profile_dump(unsigned char *buffer, unsigned int length)
+{
+    unsigned char *position = buffer;
+    unsigned int records;
+    unsigned int iterator;
+
+    if( buffer == NULL || length < SCHEDULE_PROFILE_DUMP_HEADER_SIZE )
+    {
+        return 0;
+    }
+
+    // Number of records which fit
+    records = (length - SCHEDULE_PROFILE_DUMP_HEADER_SIZE) / SCHEDULE_PROFILE_DUMP_RECORD_SIZE;
+    if( records > profile_length )
+    {
+        records = profile_length;
+    }
+    if( records > 0xFF )
+    {
+        records = 0xFF;
+    }
+
+    // Header
+    *position++ = 'S';
+    *position++ = 'P';
+    profile_put(&position, PROFILE_DUMP_VERSION, 1);
+    profile_put(&position, records, 1);
+    profile_put(&position, TICK_CYCLES, 2);
+    profile_put(&position, profile_untracked, 4);
+
+    // Records
+    for( iterator = 0; iterator < records; ++iterator )
+    {
+        profile_put(&position, (uintptr_t)profile_table[iterator].func, 4);
+        profile_put(&position, profile_table[iterator].runs, 4);
+        profile_put(&position, profile_table[iterator].total, 8);
+        profile_put(&position, profile_table[iterator].min, 4);
+        profile_put(&position, profile_table[iterator].max, 4);
+        profile_put(&position, profile_table[iterator].latency_total, 8);
+        profile_put(&position, profile_table[iterator].latency_max, 4);
+    }
+
+    return (unsigned int)(position - buffer);
+}
+
+
+/**
+ * Clear every profile. Must be called from the main loop.
+ */
+void scheduler_profile_reset(void)
+{
+    unsigned int iterator;
+
+    for( iterator = 0; iterator < profile_length; ++iterator )
+    {
+        profile_table[iterator] = (scheduler_profile_t){0};
+    }
+    profile_length = 0;
+    profile_untracked = 0;
+}
+#endif
+
+
+#if defined(SCHEDULE_BUDGET)
+/**
+ * Set the execution budget of every process which runs @em func. The tick ISR flags a run which
+ * takes longer, and it is counted and reported to the overrun callback once it returns. A process
+ * may poll scheduler_budget_exceeded() to give up early. After SCHEDULE_BUDGET_STRIKES consecutive
+ * overruns the function is demoted: each of its runs is held back SCHEDULE_BUDGET_BACKOFF ticks, or
+ * skipped if SCHEDULE_BUDGET_SKIP is defined, until a run completes within budget. Setting the
+ * budget of a function again keeps its record. Must be called from the main loop.
+ *
+ * @param[in]  func
+ *             The function to budget.
+ *
+ * @param[in]  budget_ticks
+ *             The number of ticks a run may take, or zero to stop checking the function.
+ *
+ * @return     True if the budget was set, false if @em func was invalid or the budget table is
+ *             full.
+ */
+int scheduler_budget_set(void (*func)(void *), unsigned int budget_ticks)
+{
+    scheduler_budget_t *budget;
+
+    if( func == NULL )
+    {
+        return false;
+    }
+
+    budget = budget_find(func);
+    if( budget == NULL )
+    {// First budget of this function
+        if( budget_length >= SCHEDULE_BUDGET_LENGTH )
+        {// Budget table is full
+            return false;
+        }
+
+        budget = &budget_table[budget_length++];
+        *budget = (scheduler_budget_t){0};
+        budget->func = func;
+    }
+    budget->budget = budget_ticks;
+
+    return true;
+}
+
+
+/**
+ * Get the budget and overrun record of a function. Must be called from the main loop.
+ *
+ * @param[in]  func
+ *             The function to look up.
+ *
+ * @param[out] budget
+ *             A pointer to the record to fill.
+ *
+ * @return     True if @em func has been given a budget, false otherwise.
+ */
+int scheduler_budget_get(void (*func)(void *), scheduler_budget_t *budget)
+{
+    scheduler_budget_t *entry;
+
+    if( budget == NULL )
+    {
+        return false;
+    }
+
+    entry = budget_find(func);
+    if( entry == NULL )
+    {
+        return false;
+    }
+
+    *budget = *entry;
+
+    return true;
+}
+
+
+/**
+ * Set the function called after each run over budget. It is called from the main loop, with the
+ * function which ran and the number of ticks by which it overran, before the next process runs.
+ * Must be called from the main loop.
+ *
+ * @param[in]  callback
+ *             A pointer to the function to call, or NULL for none.
+ */
+void scheduler_on_budget_overrun(void (*callback)(void (*func)(void *), unsigned long overrun))
+{
+    budget_overrun_callback = callback;
+}
+
+
+/**
+ * Check whether the running process has overrun its budget. A long running process may poll this
+ * and return early, rescheduling the rest of its work. Must be called from a scheduled process.
+ *
+ * @return     True if the tick ISR has flagged the running process, false otherwise.
+ */
+int scheduler_budget_exceeded(void)
+{
+    return budget_overrun;
+}
+
+
+/**
+ * Find the budget of a function. Must be called from the main loop.
+ *
+ * @param[in]  func
+ *             The function to look up.
+ *
+ * @return     A pointer to the function's entry in budget_table, or NULL if it has none.
+ */
+scheduler_budget_t * budget_find(void (*func)(void *))
+{
+    unsigned int iterator;
+
+    for( iterator = 0; iterator < budget_length; ++iterator )
+    {
+        if( budget_table[iterator].func == func )
+        {
+            return &budget_table[iterator];
+        }
+    }
+
+    return NULL;
+}
+
+
+/**
+ * Hold back or skip a run of a demoted function. A run is only held back once, it runs when it
+ * comes up again. Must be called from the main loop.
+ *
+ * @param[in]  process
+ *             A pointer to the process about to run.
+ *
+ * @param[in]  budget
+ *             A pointer to the budget of the process' function.
+ *
+ * @return     True if the run was held back or skipped, false if it should go ahead.
+ */
+bool budget_demote(process_t *process, scheduler_budget_t *budget)
+{
+    unsigned long now;
+
+    if( budget->strikes < SCHEDULE_BUDGET_STRIKES || process->budget_deferred )
+    {// Not demoted, or already held back
+        process->budget_deferred = false;
+
+        return false;
+    }
+
+    budget->demotions++;
+    now = get_ticks();
+
+#if defined(SCHEDULE_BUDGET_SKIP)
+    if( !process->coroutine )
+    {// Skip the run, which works off a strike so that a later run gets another chance
+        budget->strikes--;
+        if( process->period != 0 )
+        {// Skip to the next release
+            process->stats.overruns++;
+            process->release += process->period;
+            process->due = process->release;
+            process->sequence = schedule_sequence++;
+            schedule_insert(process, now);
+        }
+        else
+        {
+            process_free(process);
+        }
+
+        return true;
+    }
+#endif
+
+    // Hold the run back behind the other processes. Only the due tick moves, the deadline and a
+    // periodic process' next release stay anchored to this run
+    process->budget_deferred = true;
+    process->due = now + SCHEDULE_BUDGET_BACKOFF;
+    process->sequence = schedule_sequence++;
+    schedule_place(process, now);
+
+    return true;
+}
+
+
+/**
+ * Arm the tick ISR's budget check for the process about to run. Must be called from the main loop.
+ *
+ * @param[in]  budget
+ *             A pointer to the budget of the process' function, or NULL if it has none.
+ *
+ * @param[in]  now
+ *             The tick the process starts running on.
+ */
+void budget_start(const scheduler_budget_t *budget, unsigned long now)
+{
+    budget_overrun = false;
+    if( budget != NULL && budget->budget != 0 )
+    {
+        // The ISR ignores the expiry until the budget is armed
+        budget_expiry = now + budget->budget;
+        budget_armed = true;
+    }
+}
+
+
+/**
+ * Disarm the tick ISR's budget check after a run, and count and report an overrun. Must be called
+ * from the main loop.
+ *
+ * @param[in]  budget
+ *             A pointer to the budget of the function which ran, or NULL if it has none.
+ *
+ * @param[in]  start
+ *             The tick the process started running on.
+ */
+void budget_stop(scheduler_budget_t *budget, unsigned long start)
+{
+    unsigned long overrun;
+
+    budget_armed = false;
+    if( budget == NULL || budget->budget == 0 )
+    {
+        return;
+    }
+
+    if( !budget_overrun )
+    {// Completed within budget, the function is no longer demoted
+        budget->strikes = 0;
+
+        return;
+    }
+    budget_overrun = false;
+
+    overrun = get_ticks() - start - budget->budget;
+    budget->overruns++;
+    if( overrun > budget->max_overrun )
+    {
+        budget->max_overrun = overrun;
+    }
+    if( budget->strikes < SCHEDULE_BUDGET_STRIKES )
+    {
+        budget->strikes++;
+    }
+
+    if( budget_overrun_callback != NULL )
+    {
+        budget_overrun_callback(budget->func, overrun);
+    }
+}
+#endif
+
+
+/** Timer1 ISR
+ * This is the Timer1 ISR. This ISR is used as the kernels tick counter. It does constant work,
+ * delayed processes are expired from the timing wheel by the main loop.
+ */
+void SCHEDULER_HW_ISR _T1Interrupt(void)
+{
+    // Update the tick counter and clear the flag in one step, so that the tick counter and the flag
+    // are seen consistently by higher priority ISRs reading the time
+    SCHEDULER_HW_DISABLE_INTERRUPTS();
+
+#if defined(SCHEDULE_TICKLESS)
+    // Count every tick the period spanned and return to single ticks
+    ticks += tick_step;
+    tick_step = 1;
+    tick_offset = 0;
+    PR1 = SCHEDULER_HW_TICK_PERIOD;
+#else
+    // Increment kernel ticks
+    ticks++;
+#endif
+
+    // Reset interrupt flag
+    IFS0bits.T1IF=0;
+
+#if defined(SCHEDULE_BUDGET)
+    // Flag the running process once it has taken longer than its budget, this is constant work
+    if( budget_armed && !TICK_BEFORE_EQ(ticks, budget_expiry) )
+    {
+        budget_armed = false;
+        budget_overrun = true;
+    }
+#endif
+
+    SCHEDULER_HW_ENABLE_INTERRUPTS();
+}
+
+
+#if SCHEDULE_BANDS > 0
+/**
+ * Run every process queued to a band, including those queued while it runs. Only called from the
+ * band's vector, so it is the queue's single consumer.
+ */
+static void band_run(band_queue_t *queue)
+{
+    band_entry_t entry;
+    unsigned int tail = queue->tail;
+
+    while( tail != SCHEDULER_HW_LOAD_ACQUIRE(queue->head) )
+    {
+        // Copy the entry out before releasing its place to producers
+        entry = queue->entries[BAND_INDEX(tail)];
+        tail++;
+        SCHEDULER_HW_STORE_RELEASE(queue->tail, tail);
+
+        entry.func(entry.params);
+    }
+}
+
+
+/** Band 1 ISR
+ * Software interrupt running the processes queued to band 1. The flag is cleared before the queue is
+ * read, so a process queued meanwhile raises the interrupt again rather than being missed.
+ */
+void SCHEDULER_HW_ISR SCHEDULER_HW_BAND1_VECTOR(void)
+{
+    SCHEDULER_HW_BAND1_CLEAR();
+    band_run(&band_queues[0]);
+}
+#endif
+
+
+#if SCHEDULE_BANDS > 1
+/** Band 2 ISR
+ * Software interrupt running the processes queued to band 2, see band 1.
+ */
+void SCHEDULER_HW_ISR SCHEDULER_HW_BAND2_VECTOR(void)
+{
+    SCHEDULER_HW_BAND2_CLEAR();
+    band_run(&band_queues[1]);
 }
+#endif
 
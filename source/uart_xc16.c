@@ -18,21 +18,29 @@
 
 // Include standard C library files
 #include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
 
+#if !defined(UART_HOST)
 // Include Microchip Peripheral Library files
 #include <xc.h>
 #include <pps.h>
 
 // Include board information
 #include <board.def>
+#endif
 
 // Include local library code
 #include <bitops.h>
 #include <dma_channel.h>
+#include <ringbuf.h>
 
-// Include user definitions
+// Include user definitions, the defaults on host
+#if defined(UART_HOST)
+#include "../def/uart_xc16.def"
+#else
 #include <uart.def>
+#endif
 
 // Include private hardware definitions
 #include <uart_hw.h>
@@ -40,10 +48,33 @@
 // Include module declaration
 #include <uart.h>
 
-/**
- * @todo move to .def file.
- */
-#define UART_DEF_LOCAL_ADDR_SIZE 8 /**< The maximum size of the local_addr_ array */
+#ifndef UART_DEF_HYBRID_TX_WATERMARK
+#define UART_DEF_HYBRID_TX_WATERMARK 0 /**< Characters which start a hybrid TX transfer, 0 for a
+                                          full DMA buffer */
+#endif
+
+#ifndef UART_DEF_HYBRID_TX_DEADLINE
+#define UART_DEF_HYBRID_TX_DEADLINE 1 /**< uart_tick() calls before a hybrid TX transfer starts
+                                         below the watermark */
+#endif
+
+#if UART_DEF_HYBRID_TX_DEADLINE < 1
+#error "UART: UART_DEF_HYBRID_TX_DEADLINE must be at least one tick."
+#endif
+
+#ifndef UART_DEF_LIN_FRAME_TICKS
+#define UART_DEF_LIN_FRAME_TICKS 2 /**< uart_tick() calls a LIN frame may take from its break
+                                      before it is ended */
+#endif
+
+#if UART_DEF_LIN_FRAME_TICKS < 1
+#error "UART: UART_DEF_LIN_FRAME_TICKS must be at least one tick."
+#endif
+
+#ifndef UART_DEF_AUTOBAUD_SNAP_PPM
+#define UART_DEF_AUTOBAUD_SNAP_PPM 30000UL /**< Largest difference in ppm between a measured and a
+                                              standard baud rate which snaps to the standard rate */
+#endif
 
 /* ***** Private Macros ***** */
 
@@ -61,6 +92,69 @@
  */
 #define UART_GET_ATTR(module) ( ((uart_private_t *)((module)->private))->attr_ )
 
+/**
+ * @brief Return a pointer to the private object of the given UART module.
+ *
+ * @private
+ */
+#define UART_GET_PRIVATE(module) ( (uart_private_t *)((module)->private) )
+
+/**
+ * @brief Marks an RX DMA buffer word which holds no received character.
+ *
+ * @details The RX DMA channel transfers whole words from UxRXREG, whose upper bits always read as
+ * zero, so a received character can never equal this value. Every word is set to it before the
+ * channel starts and again once the character in it has been read.
+ *
+ * @private
+ */
+#define UART_DMA_RX_EMPTY 0xFFFF
+
+/**
+ * @brief Bit 8 of a 9-bit character, set on address characters.
+ *
+ * @private
+ */
+#define UART_9BIT_ADDRESS 0x0100
+
+/**
+ * @brief Bits per word of the local address bitmap, and words in the bitmap.
+ *
+ * @details The bitmap holds one bit for each of the 256 addresses, so an address character is
+ * accepted or rejected with one word lookup however many local addresses are set.
+ *
+ * @private
+ */
+#define UART_LOCAL_ADDR_BITS (8*sizeof(unsigned int))
+#define UART_LOCAL_ADDR_WORDS (256/UART_LOCAL_ADDR_BITS) /**< @private */
+
+/**
+ * @brief Return non-zero if the address is set in the local address bitmap of the given module.
+ *
+ * @private
+ */
+#define UART_LOCAL_ADDR_IS_SET(module, addr) \
+    ( UART_GET_PRIVATE(module)->local_addr_[(addr)/UART_LOCAL_ADDR_BITS] \
+      & (1U << ((addr) % UART_LOCAL_ADDR_BITS)) )
+
+/**
+ * @brief Enable or disable the TX and RX interrupts of the given UART module, and set or clear
+ * their flags.
+ *
+ * @details The TX interrupt is only enabled while the TX ring buffer may hold characters, and the
+ * TX ISR disables it once the ring buffer is empty. The flag and enable registers are shared with
+ * other peripherals, so each bit is set or cleared on its own, see #UART_HW_INTERRUPT_BIT_UART1.
+ *
+ * @private
+ */
+#define UART_ENABLE_TX_INTERRUPT(module)  UART_HW_INTERRUPT_BIT((module)->uart_number, IEC, TXIE, 1)
+#define UART_DISABLE_TX_INTERRUPT(module) UART_HW_INTERRUPT_BIT((module)->uart_number, IEC, TXIE, 0)
+#define UART_ENABLE_RX_INTERRUPT(module)  UART_HW_INTERRUPT_BIT((module)->uart_number, IEC, RXIE, 1)
+#define UART_DISABLE_RX_INTERRUPT(module) UART_HW_INTERRUPT_BIT((module)->uart_number, IEC, RXIE, 0)
+#define UART_SET_TX_FLAG(module)   UART_HW_INTERRUPT_BIT((module)->uart_number, IFS, TXIF, 1)
+#define UART_CLEAR_TX_FLAG(module) UART_HW_INTERRUPT_BIT((module)->uart_number, IFS, TXIF, 0)
+#define UART_CLEAR_RX_FLAG(module) UART_HW_INTERRUPT_BIT((module)->uart_number, IFS, RXIF, 0)
+
 /* ***** Private Constants ***** */
 
 
@@ -145,6 +239,19 @@ enum uart_sfr_defaults_e
 };
 
 /* ***** Private Data Declaration ***** */
+/**
+ * @brief The states of the LIN frame state machine in the RX ISR.
+ *
+ * @private
+ */
+enum uart_lin_state_e
+{
+    UART_LIN_STATE_IDLE     = 0, /**< Waiting for a break */
+    UART_LIN_STATE_SYNC     = 1, /**< Break received, waiting for the sync character */
+    UART_LIN_STATE_PID      = 2, /**< Sync received, waiting for the PID */
+    UART_LIN_STATE_RESPONSE = 3  /**< Sending or receiving the response of a frame for this node */
+};
+
 /**
  * @brief The private object of a UART module.
  *
@@ -218,6 +325,27 @@ typedef struct uart_private_s
      */
     uart_baudrate_t baudrate_;
 
+    /**
+     * @brief The baud rate the module generates, in Hz.
+     *
+     * @details Set from Fcy and the BRGH and BRG values by #uart_set_baudrate() and
+     * #uart_set_baudrate_hz(), so it is the actual rate rather than the one asked for. It is zero
+     * when the rate is unknown, as after a manual setting or an autobaud.
+     *
+     * @private
+     */
+    unsigned long baudrate_hz_;
+
+    /**
+     * @brief The function to call once an autobaud completes, or NULL.
+     *
+     * @details Set by #uart_autobaud(). An autobaud is in progress while #_baudrate is
+     * #UART_BAUDRATE_AUTO.
+     *
+     * @private
+     */
+    void (*autobaud_callback_)(uart_module_t *module);
+
     /**
      * @brief The current open state of the module, either RX only, TX and RX, or none.
      *
@@ -230,16 +358,113 @@ typedef struct uart_private_s
      */
     uart_direction_t open_state_;
     
-    void *tx_buffer_; /**< A pointer to the software TX buffer (either char or int). @private */
-    void *tx_head_;   /**< A pointer to the last write into the TX software buffer. @private */
-    void *tx_tail_;   /**< A pointer to the last read out of the TX software buffer. @private */
+    void *tx_buffer_;   /**< A pointer to the software TX buffer (either char or int). @private */
+    ringbuf_t tx_ring_; /**< The ring buffer over #tx_buffer_, written by uart_write() and read by
+                           the TX ISR. @private */
+
+    void *rx_buffer_;   /**< A pointer to the software RX buffer (either char or int). @private */
+    ringbuf_t rx_ring_; /**< The ring buffer over #rx_buffer_, written by the RX ISR and read by
+                           uart_read(). @private */
+
+    /**
+     * @brief The TX DMA buffer currently being filled by writes.
+     *
+     * @details The TX DMA channel runs in one-shot mode without ping-pong. Software selects the
+     * buffer each transfer sends with dma_set_buffer() when it is started. While one buffer is
+     * being sent writes fill the other, which is started as soon as the transfer in progress
+     * completes.
+     *
+     * @see dma_pingpong_status_t
+     * @private
+     */
+    volatile unsigned int tx_dma_fill_;
+    volatile unsigned int tx_dma_count_; /**< Characters waiting in the TX DMA buffer being
+                                            filled. @private */
+    volatile bool tx_dma_busy_;          /**< A TX DMA transfer is in progress. @private */
+    volatile bool tx_writing_;           /**< A write is filling a TX buffer outside a critical
+                                            section, so the TX DMA ISR must not start it and
+                                            uart_writev() must not append to it. @private */
+
+    /**
+     * @brief The index of the next RX DMA buffer word to read.
+     *
+     * @details The RX DMA channel runs continuously over buffer A, so the buffer is circular and
+     * the channel always holds the write position. Reads follow it through this index until they
+     * reach a word marked #UART_DMA_RX_EMPTY.
+     *
+     * @private
+     */
+    unsigned int rx_dma_head_;
+    volatile unsigned int rx_dma_half_;  /**< The next RX DMA interrupt, half or full block.
+                                            @see dma_interrupt_on_t @private */
+    unsigned int rx_dma_idle_count_;     /**< Characters waiting at the last #uart_tick(). @private */
+    volatile bool rx_dma_notified_;      /**< The user was told about the characters waiting.
+                                            @private */
+
+    /**
+     * @brief The number of bytes in the TX software buffer which start a hybrid TX transfer.
+     *
+     * @details Set from #UART_DEF_HYBRID_TX_WATERMARK during #uart_init(), limited to the smaller
+     * DMA buffer and the software buffer, so it can always be reached. It is kept in bytes so it
+     * compares directly with the ring buffer count, two per character in 9-bit mode.
+     *
+     * @private
+     */
+    unsigned int tx_hybrid_watermark_;
+    unsigned int tx_hybrid_age_; /**< uart_tick() calls the characters in the TX software buffer
+                                    have waited for an idle DMA channel. @private */
+
+    /**
+     * @brief The addresses to accept in 9-bit, masked mode, one bit per address.
+     *
+     * @details Only changed by #uart_add_local_addr() and #uart_remove_local_addr(). The RX path
+     * only reads it, so a change takes effect from the next address character.
+     *
+     * @private
+     */
+    unsigned int local_addr_[UART_LOCAL_ADDR_WORDS];
+    bool rx_addr_filter_; /**< True in 9-bit, masked mode, when characters are filtered by
+                             address. @private */
+    bool rx_addr_adden_; /**< True if the filter also sets ADDEN while not addressed, so the
+                            hardware drops other devices' characters. @private */
+    volatile bool rx_addressed_; /**< True from an address character in #local_addr_ until the
+                                    next address character which is not. @private */
 
-    void *rx_buffer_; /**< A pointer to the software RX buffer (either char or int). @private */
-    void *rx_head_;   /**< A pointer to the last write into the RX software buffer. @private */
-    void *rx_tail_;   /**< A pointer to the last read out of the RX software buffer. @private */
+    /**
+     * @brief The LIN frames this node responds to or listens for.
+     *
+     * @details Set by #uart_lin_set_frames() and searched by the RX ISR on each PID.
+     *
+     * @private
+     */
+    uart_lin_frame_t *lin_frames_;
+    unsigned int lin_frames_count_; /**< The number of frames in #lin_frames_. @private */
 
-    char *local_addr_; /**< An array of addresses to accept in 9-bit, masked mode. @private */
-    int local_addr_length_; /**< The length of the local_addr_ array. @private */
+    /**
+     * @brief The schedule table run by a LIN master.
+     *
+     * @details Set by #uart_lin_set_schedule(). #lin_slot_ is the next slot to start, once
+     * #lin_slot_ticks_ more calls of #uart_tick() have ended the slot in progress.
+     *
+     * @private
+     */
+    const uart_lin_slot_t *lin_schedule_;
+    unsigned int lin_schedule_count_; /**< The number of slots in #lin_schedule_. @private */
+    unsigned int lin_slot_;           /**< The next slot to start. @private */
+    unsigned int lin_slot_ticks_;     /**< uart_tick() calls left in the slot. @private */
+
+    uart_lin_frame_t *lin_header_frame_; /**< The frame whose header this master sent last, until
+                                            its PID reads back. @private */
+    uart_lin_frame_t *lin_frame_; /**< The frame whose response is in progress, or NULL.
+                                     @private */
+    volatile unsigned char lin_state_; /**< A #uart_lin_state_e value. @private */
+    unsigned char lin_pid_;    /**< The PID of the frame in progress. @private */
+    unsigned char lin_count_;  /**< Response characters sent or received so far. @private */
+    unsigned char lin_length_; /**< Response characters including the checksum. @private */
+    unsigned char lin_response_[UART_LIN_MAX_DATA+1]; /**< The response being sent or received,
+                                                         with its checksum. @private */
+    unsigned int lin_age_; /**< uart_tick() calls since the break of the frame in progress.
+                              @private */
 
     int (*write_)(uart_module_t *module,
                   const void *buffer,
@@ -263,306 +488,468 @@ typedef struct uart_private_s
 /* ***** Private Function Definitions ***** */
 
 /**
- * @brief The private implementation of the UART write function for 8-bit mode and HW buffers only.
+ * @brief Round a software buffer size up to the next power of two.
  *
- * @details This function defines the private implementation of the UART write function when the
- * module is initialized in standard (8-bit) mode and uses only the hardware FIFO buffer. During
- * initialization a pointer to this function is supplied in the uart_module_t::write() function
- * pointer of the initialized #uart_module_t object.
+ * @details Software buffers are ring buffers, which wrap by masking, so the 12 and 24 character
+ * sizes become 16 and 32 characters.
  *
- * The #buffer parameter is cast to a "const unsigned char", so the user must also provide the same
- * type when passing an array. This is explained to the user in uart_module_t::write().
- *
- * @param[in]  module
- *             The UART module to work on.
- * @param[in]  buffer
- *             A pointer to the array to write out to the UART hardware.
- * @param[in]  length
- *             The length of the #buffer array.
- * @return If zero or positive, the number of characters written; if negative, an error value
- * corresponding to one of #uart_error_e.
+ * @param[in]  size
+ *             The number of characters requested.
+ * @return The number of characters to allocate.
  *
  * @private
  */
-static int uart_private_write_8bit_hwonly(uart_module_t *module,
-                                          const void *buffer,
-                                          unsigned int length)
+static unsigned int uart_private_ring_size(unsigned int size)
 {
-    int data_written = 0;
-    const unsigned char *write_ptr = buffer;
-    
-    // Check for a valid module
-    if( !uart_is_valid(module) )
-    {// Invalid module
-        return UART_E_MODULE;
-    }
-
-    // Check if TX enabled
-    if( !uart_is_open(module, UART_DIRECTION_TX) )
-    {// TX is closed
-        return UART_E_CLOSED;
-    }
+    unsigned int ring_size = 1;
 
-    // If space avaliable in FIFO, write data
-    while( !IS_MASK_SET( *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxSTA), UART_SFR_BITMASK_UTXBF ) )
-    {// Space available in TX FIFO buffer
-        if( data_written < length )
-        {// More data to write
-            *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxTXREG) = *(write_ptr);
-            write_ptr++;
-            data_written++;
-        }
-        else
-        {// No more data to write
-            return data_written;
-        }
+    while( ring_size < size )
+    {
+        ring_size <<= 1;
     }
 
-    return data_written;
+    return ring_size;
 }
 
 /**
- * @brief The private implementation of the UART write function for 8-bit mode with DMA buffer.
+ * @brief Return the size in bytes of one character in a software buffer.
  *
- * @details This function defines the private implementation of the UART write function when the
- * module is initialized in standard (8-bit) mode and uses a user provided DMA buffer. During
- * initialization a pointer to this function is supplied in the uart_module_t::write() function
- * pointer of the initialized #uart_module_t object.
- *
- * The #buffer parameter is cast to a "const unsigned char", so the user must also provide the same
- * type when passing an array. This is explained to the user in uart_module_t::write().
+ * @details 9-bit characters take a word each, all others take a byte.
  *
  * @param[in]  module
  *             The UART module to work on.
- * @param[in]  buffer
- *             A pointer to the array to write out to the UART hardware.
- * @param[in]  length
- *             The length of the #buffer array.
- * @return If zero or positive, the number of characters written; if negative, an error value
- * corresponding to one of #uart_error_e.
+ * @return The size of a character in bytes.
  *
  * @private
  */
-static int uart_private_write_8bit_dma(uart_module_t *module,
-                                       const void *buffer,
-                                       unsigned int length)
+static unsigned int uart_private_character_size(uart_module_t *module)
 {
-    return UART_E_NONE;
+    if( (UART_GET_ATTR(module).mode_settings & UART_MAJOR_MODE_BITMASK) == UART_MAJOR_MODE_9BIT )
+    {// Using 9-bit mode
+        return sizeof(int);
+    }
+
+    return sizeof(char);
 }
 
 /**
- * @brief The private implementation of the UART write function for 8-bit mode with a software
- * buffer.
+ * @brief Decide whether a received 9-bit character is kept, according to the local addresses.
  *
- * @details This function defines the private implementation of the UART write function when the
- * module is initialized in standard (8-bit) mode and uses a software buffer. During initialization
- * a pointer to this function is supplied in the uart_module_t::write() function pointer of the
- * initialized #uart_module_t object.
+ * @details An address character starts a frame, which is kept if the address is in the local
+ * address bitmap, up to the next address character. The address character itself is kept with
+ * its frame, so the reader sees which address the data was sent to. Without address filtering
+ * every character is kept.
  *
- * The #buffer parameter is cast to a "const unsigned char", so the user must also provide the same
- * type when passing an array. This is explained to the user in uart_module_t::write().
+ * When the filter drives ADDEN, it is set while no frame for this device is in progress, so the
+ * hardware drops other devices' data characters without raising an interrupt. It is cleared by the
+ * RX ISR of the matching address character, which must run before the following character has
+ * been received.
+ *
+ * Only the RX path, the single reader of the hardware, may call this function.
  *
  * @param[in]  module
  *             The UART module to work on.
- * @param[in]  buffer
- *             A pointer to the array to write out to the UART hardware.
- * @param[in]  length
- *             The length of the #buffer array.
- * @return If zero or positive, the number of characters written; if negative, an error value
- * corresponding to one of #uart_error_e.
+ * @param[in]  character
+ *             The 9-bit character received.
+ * @return True if the character should be passed on to the user.
  *
  * @private
  */
-static int uart_private_write_8bit_soft(uart_module_t *module,
-                                        const void *buffer,
-                                        unsigned int length)
+static bool uart_private_rx_9bit_accept(uart_module_t *module,
+                                        unsigned int character)
 {
-    return UART_E_NONE;
+    uart_private_t *private = UART_GET_PRIVATE(module);
+
+    if( !private->rx_addr_filter_ )
+    {// Not filtering
+        return true;
+    }
+
+    if( (character & UART_9BIT_ADDRESS) != 0 )
+    {// Address character, one lookup decides the frame
+        private->rx_addressed_ = UART_LOCAL_ADDR_IS_SET(module, character & 0x00FF) != 0;
+
+        if( private->rx_addr_adden_ )
+        {// Let the hardware drop characters outside our frames
+            if( private->rx_addressed_ )
+            {
+                WRITE_MASK_CLEAR(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxSTA), UART_SFR_BITMASK_ADDEN);
+            }
+            else
+            {
+                WRITE_MASK_SET(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxSTA), UART_SFR_BITMASK_ADDEN);
+            }
+        }
+    }
+
+    return private->rx_addressed_;
 }
 
 /**
- * @brief The private implementation of the UART write function for 8-bit mode and a hybrid --
- * software plus DMA -- buffer implementation.
- *
- * @details This function defines the private implementation of the UART write function when the
- * module is initialized in standard (8-bit) mode and uses both a software and DMA buffer. During
- * initialization a pointer to this function is supplied in the uart_module_t::write() function
- * pointer of the initialized #uart_module_t object.
+ * @brief Move characters from the TX ring buffer to the hardware FIFO.
  *
- * The #buffer parameter is cast to a "const unsigned char", so the user must also provide the same
- * type when passing an array. This is explained for the user in uart_module_t::write().
+ * @details The FIFO is filled until it is full or the ring buffer is empty. Only the TX ISR, the
+ * single reader of the ring buffer, may call this function.
  *
  * @param[in]  module
  *             The UART module to work on.
- * @param[in]  buffer
- *             A pointer to the array to write out to the UART hardware.
- * @param[in]  length
- *             The length of the #buffer array.
- * @return If zero or positive, the number of characters written; if negative, an error value
- * corresponding to one of #uart_error_e.
  *
  * @private
  */
-static int uart_private_write_8bit_hybrid(uart_module_t *module,
-                                          const void *buffer,
-                                          unsigned int length)
+static void uart_private_tx_fill_fifo(uart_module_t *module)
 {
-    return UART_E_NONE;
+    volatile unsigned int *sta = UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxSTA;
+    volatile unsigned int *txreg = UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxTXREG;
+    unsigned char character;
+    unsigned int word;
+
+    if( uart_private_character_size(module) == sizeof(int) )
+    {// 9-bit characters take a word of the ring buffer, which only ever holds whole words
+        while( (*sta & UART_SFR_BITMASK_UTXBF) == 0
+               && ringbuf_read(&UART_GET_PRIVATE(module)->tx_ring_, &word, sizeof(word)) == sizeof(word) )
+        {// Room in the FIFO and characters waiting
+            *txreg = word;
+        }
+        return;
+    }
+
+    while( (*sta & UART_SFR_BITMASK_UTXBF) == 0
+           && ringbuf_get(&UART_GET_PRIVATE(module)->tx_ring_, &character) )
+    {// Room in the FIFO and characters waiting
+        *txreg = character;
+    }
 }
 
 /**
- * @brief The private implementation of the UART read function for 8-bit mode and HW buffer only.
+ * @brief Initialize the TX DMA channel of a UART module.
  *
- * @details This function defines the private implementation of the UART read function when the
- * module is initialized in standard (8-bit) mode and uses only the hardware FIFO buffer. During
- * initialization a pointer to this function is supplied in the uart_module_t::read() function pointer of the
- * initialized #uart_module_t object.
- *
- * The #buffer parameter is cast to a "const unsigned char", so the user must also provide the same
- * type when passing an array. This is explained for the user in uart_module_t::read().
+ * @details The channel is set up to send characters from its buffers to the module's TXREG, one
+ * buffer per transfer, in one-shot mode. Ping-pong mode is left disabled: it would switch to the
+ * other buffer after each transfer and stay enabled, so the next TX request would send that buffer
+ * before it was filled. Instead software selects each transfer's buffer with dma_set_buffer() when
+ * it is started. Both DMA buffers must be provided. The buffer sizes are counted in characters,
+ * bytes in 8-bit mode and words in 9-bit mode.
  *
  * @param[in]  module
  *             The UART module to work on.
- * @param[in]  buffer
- *             A pointer to the array to which to write any new data from the UART hardware.
- * @param[in]  length
- *             The length of the #buffer array.
- * @return If zero or positive, the number of characters read in; if negative, an error value
- * corresponding to one of #uart_error_e.
+ * @param[in]  tx_dma
+ *             The uninitialized DMA channel to use for transmitting.
+ * @return A value corresponding to one of #uart_error_e.
  *
  * @private
  */
-static int uart_private_read_8bit_hwonly(uart_module_t *module,
-                                         void *buffer,
-                                         unsigned int length)
+static int uart_private_init_tx_dma(uart_module_t *module,
+                                    dma_channel_t *tx_dma)
 {
-    int data_read = 0;
-    unsigned char *read_ptr = buffer;
+    dma_attr_t dma_attr;
 
-    // Check for a valid module
-    if( !uart_is_valid(module) )
-    {// Invalid module
-        return UART_E_MODULE;
+    // Check for a DMA channel with both buffers
+    if( tx_dma == NULL || tx_dma->buffer_b == NULL || tx_dma->buffer_b_size == 0 )
+    {// Invalid DMA channel
+        return UART_E_INPUT;
     }
 
-    // Check if RX enabled
-    if( !uart_is_open(module, UART_DIRECTION_RX) )
-    {// RX is closed
-        return UART_E_CLOSED;
-    }
+    // Send one buffer of characters to TXREG per transfer, 9-bit characters as words
+    dma_attr.config = DMA_CONFIG_OPMODE_ONESHOT
+        | DMA_CONFIG_PINGPONG_DIS
+        | DMA_CONFIG_ADDRMODE_REGIND_POSTINC
+        | DMA_CONFIG_NULLWRITE_DIS
+        | DMA_CONFIG_DIR_TO_PERIPHERAL
+        | (uart_private_character_size(module) == sizeof(int) ? DMA_CONFIG_DATASIZE_WORD
+                                                              : DMA_CONFIG_DATASIZE_BYTE);
 
-    // If data is available in FIFO, read data
-    while( !IS_MASK_SET( *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxSTA), UART_SFR_BITMASK_URXDA ) )
-    {// Data available in RX FIFO buffer
-        if( data_read < length )
-        {// More space available in user buffer
-            *(read_ptr) = *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxRXREG);
-            read_ptr++;
-            data_read++;
-        }
-        else
-        {// No space available in user buffer
-            return data_read;
-        }
+    switch( module->uart_number )
+    {
+    case 1:
+        dma_attr.irq = UART_HW_DMA_TX_IRQ_UART1;
+        dma_attr.peripheral_address = UART_HW_DMA_TX_PERIPHERAL_UART1;
+        break;
+    case 2:
+        dma_attr.irq = UART_HW_DMA_TX_IRQ_UART2;
+        dma_attr.peripheral_address = UART_HW_DMA_TX_PERIPHERAL_UART2;
+        break;
+    default:
+        // Module has no DMA request
+        return UART_E_DMA;
     }
 
-    return data_read;
+    if( dma_init(tx_dma, &dma_attr) != DMA_E_NONE )
+    {// DMA channel failed to initialize
+        return UART_E_DMA;
+    }
+
+    // Copy DMA channel to private object
+    UART_GET_PRIVATE(module)->tx_dma_ = tx_dma;
+
+    // Start filling buffer A
+    UART_GET_PRIVATE(module)->tx_dma_fill_ = DMA_PINGPONG_BUFFER_A;
+    UART_GET_PRIVATE(module)->tx_dma_count_ = 0;
+    UART_GET_PRIVATE(module)->tx_dma_busy_ = false;
+    UART_GET_PRIVATE(module)->tx_writing_ = false;
+
+    return UART_E_NONE;
 }
 
 /**
- * @brief The private implementation of the UART read function for 8-bit mode and DMA buffer.
- *
- * @details This function defines the private implementation of the UART read function when the
- * module is initialized in standard (8-bit) mode and uses a user supplied DMA buffer. During
- * initialization a pointer to this function is supplied in the uart_module_t::read() function pointer of the
- * initialized #uart_module_t object.
+ * @brief Initialize the RX DMA channel of a UART module.
  *
- * The #buffer parameter is cast to a "const unsigned char", so the user must also provide the same
- * type when passing an array. This is explained to the user in uart_module_t::read().
+ * @details The channel is set up to move every received character from the module's RXREG into
+ * buffer A, one word per character, continuously and without ping-pong. Buffer A is used as a
+ * circular buffer and must hold an even number of words, so that it splits into two halves.
  *
  * @param[in]  module
  *             The UART module to work on.
- * @param[in]  buffer
- *             A pointer to the array to which to write any new data from the UART hardware.
- * @param[in]  length
- *             The length of the #buffer array.
- * @return If zero or positive, the number of characters read in; if negative, an error value
- * corresponding to one of #uart_error_e.
+ * @param[in]  rx_dma
+ *             The uninitialized DMA channel to use for receiving.
+ * @return A value corresponding to one of #uart_error_e.
  *
  * @private
  */
-static int uart_private_read_8bit_dma(uart_module_t *module,
-                                      void *buffer,
-                                      unsigned int length)
+static int uart_private_init_rx_dma(uart_module_t *module,
+                                    dma_channel_t *rx_dma)
 {
+    dma_attr_t dma_attr;
+
+    // Check for a DMA channel with a buffer of two equal halves
+    if( rx_dma == NULL || rx_dma->buffer_a_size < 2 || (rx_dma->buffer_a_size & 0x0001) != 0 )
+    {// Invalid DMA channel
+        return UART_E_INPUT;
+    }
+
+    // Move each character from RXREG as a word, forever
+    dma_attr.config = DMA_CONFIG_OPMODE_CONTINUOUS
+        | DMA_CONFIG_PINGPONG_DIS
+        | DMA_CONFIG_ADDRMODE_REGIND_POSTINC
+        | DMA_CONFIG_NULLWRITE_DIS
+        | DMA_CONFIG_DIR_FROM_PERIPHERAL
+        | DMA_CONFIG_DATASIZE_WORD;
+
+    switch( module->uart_number )
+    {
+    case 1:
+        dma_attr.irq = UART_HW_DMA_RX_IRQ_UART1;
+        dma_attr.peripheral_address = UART_HW_DMA_RX_PERIPHERAL_UART1;
+        break;
+    case 2:
+        dma_attr.irq = UART_HW_DMA_RX_IRQ_UART2;
+        dma_attr.peripheral_address = UART_HW_DMA_RX_PERIPHERAL_UART2;
+        break;
+    default:
+        // Module has no DMA request
+        return UART_E_DMA;
+    }
+
+    if( dma_init(rx_dma, &dma_attr) != DMA_E_NONE )
+    {// DMA channel failed to initialize
+        return UART_E_DMA;
+    }
+
+    // Copy DMA channel to private object
+    UART_GET_PRIVATE(module)->rx_dma_ = rx_dma;
+
     return UART_E_NONE;
 }
 
 /**
- * @brief The private implementation of the UART read function for 8-bit mode and software buffer.
+ * @brief Start continuous RX DMA reception into an empty buffer.
  *
- * @details This function defines the private implementation of the UART read function when the
- * module is initialized in standard (8-bit) mode and uses a software buffer. During initialization
- * a pointer to this function is supplied in the uart_module_t::read() function pointer of the
- * initialized #uart_module_t object.
+ * @details Every word of buffer A is marked empty, then the channel is enabled with one block
+ * covering the whole buffer and interrupting at its half.
  *
- * The #buffer parameter is cast to a "const unsigned char", so the user must also provide the same
- * type when passing an array. This is explained to the user in uart_module_t::read().
+ * @param[in]  module
+ *             The UART module to work on.
+ *
+ * @private
+ */
+static void uart_private_rx_dma_start(uart_module_t *module)
+{
+    uart_private_t *private = UART_GET_PRIVATE(module);
+    unsigned int i;
+
+    for( i = 0; i < private->rx_dma_->buffer_a_size; i++ )
+    {
+        private->rx_dma_->buffer_a[i] = UART_DMA_RX_EMPTY;
+    }
+
+    private->rx_dma_head_ = 0;
+    private->rx_dma_half_ = DMA_INTERRUPT_ON_HALF;
+    private->rx_dma_idle_count_ = 0;
+    private->rx_dma_notified_ = false;
+
+    dma_set_block_size(private->rx_dma_, private->rx_dma_->buffer_a_size);
+    dma_set_interrupt_on(private->rx_dma_, DMA_INTERRUPT_ON_HALF);
+    dma_enable(private->rx_dma_);
+}
+
+/**
+ * @brief Count the characters waiting in the RX DMA buffer.
  *
  * @param[in]  module
  *             The UART module to work on.
- * @param[in]  buffer
- *             A pointer to the array to which to write any new data from the UART hardware.
- * @param[in]  length
- *             The length of the #buffer array.
- * @return If zero or positive, the number of characters read in; if negative, an error value
- * corresponding to one of #uart_error_e.
+ * @return The number of characters which may be read without waiting.
  *
  * @private
  */
-static int uart_private_read_8bit_soft(uart_module_t *module,
-                                       void *buffer,
-                                       unsigned int length)
+static unsigned int uart_private_rx_dma_available(uart_module_t *module)
 {
-    return UART_E_NONE;
+    uart_private_t *private = UART_GET_PRIVATE(module);
+    unsigned int index = private->rx_dma_head_;
+    unsigned int count = 0;
+
+    while( count < private->rx_dma_->buffer_a_size
+           && private->rx_dma_->buffer_a[index] != UART_DMA_RX_EMPTY )
+    {
+        count++;
+        index++;
+        if( index >= private->rx_dma_->buffer_a_size )
+        {// Wrap around
+            index = 0;
+        }
+    }
+
+    return count;
 }
 
 /**
- * @brief The private implementation of the UART read function for 8-bit mode and a hybrid --
- * software plus DMA -- buffer.
+ * @brief Tell the user about RX DMA characters which no half block interrupt will announce.
  *
- * @details This function defines the private implementation of the UART read function when the
- * module is initialized in standard (8-bit) mode and uses a hybrid buffer, which implements both
- * software and DMA buffers. During initialization a pointer to this function is supplied in the
- * uart_module_t::read() function pointer of the initialized #uart_module_t object.
+ * @details The RX DMA channel only interrupts at each half of its buffer, so the tail of a message
+ * which stops part way through a half would never be announced. Called on each #uart_tick(), this
+ * calls rx_callback once characters are waiting and none have arrived since the previous tick.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ *
+ * @private
+ */
+static void uart_private_tick_rx_dma(uart_module_t *module)
+{
+    uart_private_t *private = UART_GET_PRIVATE(module);
+    unsigned int count = uart_private_rx_dma_available(module);
+
+    if( count != private->rx_dma_idle_count_ )
+    {// Characters arrived or were read since the last tick, wait for the line to go idle
+        if( count > private->rx_dma_idle_count_ )
+        {// New characters need announcing
+            private->rx_dma_notified_ = false;
+        }
+        private->rx_dma_idle_count_ = count;
+        return;
+    }
+
+    if( count > 0 && !private->rx_dma_notified_ )
+    {// Line is idle with characters waiting
+        private->rx_dma_notified_ = true;
+
+        // Notify user by calling rx_callback
+        if( module->rx_callback != NULL )
+        {// Callback is valid
+            module->rx_callback(module);
+        }
+    }
+}
+
+/**
+ * @brief Start a TX DMA transfer of the buffer being filled.
+ *
+ * @details The channel sends the characters waiting in the buffer being filled, and writes move
+ * on to the other buffer. Must be called with interrupts disabled or from the TX ISR, and only
+ * while no transfer is in progress.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ *
+ * @private
+ */
+static void uart_private_tx_dma_start(uart_module_t *module)
+{
+    uart_private_t *private = UART_GET_PRIVATE(module);
+
+    // Send exactly the characters waiting, from the buffer they were written to. Ping-pong mode is
+    // disabled, so the buffer is selected here for every transfer
+    dma_set_buffer(private->tx_dma_, private->tx_dma_fill_);
+    dma_set_block_size(private->tx_dma_, private->tx_dma_count_);
+
+    // One-shot mode disables the channel after each transfer, so reenable it and force the first
+    // character out, the UART requests the rest
+    dma_enable(private->tx_dma_);
+    dma_force(private->tx_dma_);
+
+    // Fill the other buffer meanwhile
+    private->tx_dma_busy_ = true;
+    private->tx_dma_fill_ ^= 1;
+    private->tx_dma_count_ = 0;
+}
+
+/**
+ * @brief Start a hybrid TX DMA transfer of the characters in the TX software buffer.
+ *
+ * @details If the DMA channel is idle, up to one DMA buffer of characters is moved from the
+ * software buffer into the DMA buffer being filled and sent as one transfer. The TX DMA ISR is
+ * the only reader of the software buffer, so anywhere else this must be called with interrupts
+ * disabled.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ *
+ * @private
+ */
+static void uart_private_tx_hybrid_feed(uart_module_t *module)
+{
+    uart_private_t *private = UART_GET_PRIVATE(module);
+    void *dma_ptr;
+    unsigned int size;
+
+    if( private->tx_dma_busy_ || ringbuf_count(&private->tx_ring_) == 0 )
+    {// Transfer in progress or nothing to send
+        return;
+    }
+
+    if( private->tx_dma_fill_ == DMA_PINGPONG_BUFFER_A )
+    {// Filling buffer A
+        dma_ptr = (void *)private->tx_dma_->buffer_a;
+        size = private->tx_dma_->buffer_a_size;
+    }
+    else
+    {// Filling buffer B
+        dma_ptr = (void *)private->tx_dma_->buffer_b;
+        size = private->tx_dma_->buffer_b_size;
+    }
+
+    private->tx_dma_count_ = ringbuf_read(&private->tx_ring_, dma_ptr, size*uart_private_character_size(module))
+        / uart_private_character_size(module);
+    private->tx_hybrid_age_ = 0;
+    uart_private_tx_dma_start(module);
+}
+
+/**
+ * @brief The private implementation of the UART write function for 8-bit mode and HW buffers only.
+ *
+ * @details This function defines the private implementation of the UART write function when the
+ * module is initialized in standard (8-bit) mode and uses only the hardware FIFO buffer. During
+ * initialization a pointer to this function is supplied in the uart_module_t::write() function
+ * pointer of the initialized #uart_module_t object.
  *
  * The #buffer parameter is cast to a "const unsigned char", so the user must also provide the same
- * type when passing an array. This is explained to the user in uart_module_t::read().
+ * type when passing an array. This is explained to the user in uart_module_t::write().
  *
  * @param[in]  module
  *             The UART module to work on.
  * @param[in]  buffer
- *             A pointer to the array to which to write any new data from the UART hardware.
+ *             A pointer to the array to write out to the UART hardware.
  * @param[in]  length
  *             The length of the #buffer array.
- * @return If zero or positive, the number of characters read in; if negative, an error value
+ * @return If zero or positive, the number of characters written; if negative, an error value
  * corresponding to one of #uart_error_e.
  *
  * @private
  */
-static int uart_private_read_8bit_hybrid(uart_module_t *module,
-                                         void *buffer,
-                                         unsigned int length)
-{
-    return UART_E_NONE;
-}
-
-static int uart_private_write_9bit_hwonly(uart_module_t *module,
+static int uart_private_write_8bit_hwonly(uart_module_t *module,
                                           const void *buffer,
                                           unsigned int length)
 {
     int data_written = 0;
-    const unsigned int *write_ptr = buffer;
+    const unsigned char *write_ptr = buffer;
     
     // Check for a valid module
     if( !uart_is_valid(module) )
@@ -579,14 +966,14 @@ static int uart_private_write_9bit_hwonly(uart_module_t *module,
     // If space avaliable in FIFO, write data
     while( !IS_MASK_SET( *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxSTA), UART_SFR_BITMASK_UTXBF ) )
     {// Space available in TX FIFO buffer
-        if( data_written <= length )
+        if( data_written < length )
         {// More data to write
-            *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxTXREG) = *write_ptr;
+            *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxTXREG) = *(write_ptr);
             write_ptr++;
             data_written++;
         }
         else
-        {
+        {// No more data to write
             return data_written;
         }
     }
@@ -594,33 +981,38 @@ static int uart_private_write_9bit_hwonly(uart_module_t *module,
     return data_written;
 }
 
-static int uart_private_write_9bit_dma(uart_module_t *module,
+/**
+ * @brief The private implementation of the UART write function for 8-bit mode with DMA buffer.
+ *
+ * @details This function defines the private implementation of the UART write function when the
+ * module is initialized in standard (8-bit) mode and uses a user provided DMA buffer. During
+ * initialization a pointer to this function is supplied in the uart_module_t::write() function
+ * pointer of the initialized #uart_module_t object.
+ *
+ * The #buffer parameter is cast to a "const unsigned char", so the user must also provide the same
+ * type when passing an array. This is explained to the user in uart_module_t::write().
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @param[in]  buffer
+ *             A pointer to the array to write out to the UART hardware.
+ * @param[in]  length
+ *             The length of the #buffer array.
+ * @return If zero or positive, the number of characters written; if negative, an error value
+ * corresponding to one of #uart_error_e.
+ *
+ * @private
+ */
+static int uart_private_write_8bit_dma(uart_module_t *module,
                                        const void *buffer,
                                        unsigned int length)
 {
-    return UART_E_NONE;
-}
-
-static int uart_private_write_9bit_soft(uart_module_t *module,
-                                        const void *buffer,
-                                        unsigned int length)
-{
-    return UART_E_NONE;
-}
-
-static int uart_private_write_9bit_hybrid(uart_module_t *module,
-                                          const void *buffer,
-                                          unsigned int length)
-{
-    return UART_E_NONE;
-}
-
-static int uart_private_read_9bit_hwonly(uart_module_t *module,
-                                         void *buffer,
-                                         unsigned int length)
-{
-    int data_read = 0;
-    unsigned int *read_ptr = buffer;
+    uart_private_t *private;
+    const unsigned char *write_ptr = buffer;
+    volatile unsigned char *dma_ptr;
+    unsigned int data_written = 0;
+    unsigned int size;
+    unsigned int count;
 
     // Check for a valid module
     if( !uart_is_valid(module) )
@@ -628,259 +1020,2041 @@ static int uart_private_read_9bit_hwonly(uart_module_t *module,
         return UART_E_MODULE;
     }
 
-    // Check if RX enabled
-    if( !uart_is_open(module, UART_DIRECTION_RX) )
-    {// RX is closed
+    // Check if TX enabled
+    if( !uart_is_open(module, UART_DIRECTION_TX) )
+    {// TX is closed
         return UART_E_CLOSED;
     }
 
-    // If data is available in FIFO, read data
-    while( !IS_MASK_SET( *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxSTA), UART_SFR_BITMASK_URXDA ) )
-    {// Data available in RX FIFO buffer
-        if( data_read < length )
-        {// More space available in user buffer
-            *read_ptr = *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxRXREG);
-            read_ptr++;
-            data_read++;
+    private = UART_GET_PRIVATE(module);
+
+    // Keep the ISR from starting the buffer being filled while characters are copied into it
+    private->tx_writing_ = true;
+
+    while( data_written < length )
+    {
+        // Find the room left in the buffer being filled
+        if( private->tx_dma_fill_ == DMA_PINGPONG_BUFFER_A )
+        {// Filling buffer A
+            dma_ptr = (volatile unsigned char *)private->tx_dma_->buffer_a;
+            size = private->tx_dma_->buffer_a_size;
         }
         else
-        {// No space available in user buffer
-            return data_read;
+        {// Filling buffer B
+            dma_ptr = (volatile unsigned char *)private->tx_dma_->buffer_b;
+            size = private->tx_dma_->buffer_b_size;
+        }
+
+        count = private->tx_dma_count_;
+        if( count >= size )
+        {// Buffer is full and the other is still being sent
+            break;
+        }
+
+        // Copy as many characters as fit
+        dma_ptr += count;
+        while( count < size && data_written < length )
+        {
+            *dma_ptr = *write_ptr;
+            dma_ptr++;
+            write_ptr++;
+            count++;
+            data_written++;
+        }
+
+        // Publish the characters, and send them now if the channel is idle
+        UART_HW_DISABLE_INTERRUPTS();
+        private->tx_dma_count_ = count;
+        if( !private->tx_dma_busy_ )
+        {// Channel is idle
+            uart_private_tx_dma_start(module);
         }
+        UART_HW_ENABLE_INTERRUPTS();
     }
 
-    return data_read;
-}
+    private->tx_writing_ = false;
 
-static int uart_private_read_9bit_dma(uart_module_t *module,
-                                      void *buffer,
-                                      unsigned int length)
-{
-    return UART_E_NONE;
+    // A transfer which completed while the ISR was held off leaves the channel idle
+    UART_HW_DISABLE_INTERRUPTS();
+    if( !private->tx_dma_busy_ && private->tx_dma_count_ > 0 )
+    {// Channel is idle with characters waiting
+        uart_private_tx_dma_start(module);
+    }
+    UART_HW_ENABLE_INTERRUPTS();
+
+    return data_written;
 }
 
-static int uart_private_read_9bit_soft(uart_module_t *module,
+/**
+ * @brief The private implementation of the UART write function for 8-bit mode with a software
+ * buffer.
+ *
+ * @details This function defines the private implementation of the UART write function when the
+ * module is initialized in standard (8-bit) mode and uses a software buffer. During initialization
+ * a pointer to this function is supplied in the uart_module_t::write() function pointer of the
+ * initialized #uart_module_t object.
+ *
+ * The #buffer parameter is cast to a "const unsigned char", so the user must also provide the same
+ * type when passing an array. This is explained to the user in uart_module_t::write().
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @param[in]  buffer
+ *             A pointer to the array to write out to the UART hardware.
+ * @param[in]  length
+ *             The length of the #buffer array.
+ * @return If zero or positive, the number of characters written; if negative, an error value
+ * corresponding to one of #uart_error_e.
+ *
+ * @private
+ */
+static int uart_private_write_8bit_soft(uart_module_t *module,
+                                        const void *buffer,
+                                        unsigned int length)
+{
+    unsigned int data_written;
+
+    // Check for a valid module
+    if( !uart_is_valid(module) )
+    {// Invalid module
+        return UART_E_MODULE;
+    }
+
+    // Check if TX enabled
+    if( !uart_is_open(module, UART_DIRECTION_TX) )
+    {// TX is closed
+        return UART_E_CLOSED;
+    }
+
+    // Copy as many characters as fit into the ring buffer
+    UART_GET_PRIVATE(module)->tx_writing_ = true;
+    data_written = ringbuf_write(&UART_GET_PRIVATE(module)->tx_ring_, buffer, length);
+    UART_GET_PRIVATE(module)->tx_writing_ = false;
+
+    // Let the TX ISR move them to the FIFO
+    if( data_written > 0 )
+    {// Characters waiting
+        UART_ENABLE_TX_INTERRUPT(module);
+    }
+
+    return data_written;
+}
+
+/**
+ * @brief The private implementation of the UART write function for 8-bit mode and a hybrid --
+ * software plus DMA -- buffer implementation.
+ *
+ * @details This function defines the private implementation of the UART write function when the
+ * module is initialized in standard (8-bit) mode and uses both a software and DMA buffer. During
+ * initialization a pointer to this function is supplied in the uart_module_t::write() function
+ * pointer of the initialized #uart_module_t object.
+ *
+ * The #buffer parameter is cast to a "const unsigned char", so the user must also provide the same
+ * type when passing an array. This is explained for the user in uart_module_t::write().
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @param[in]  buffer
+ *             A pointer to the array to write out to the UART hardware.
+ * @param[in]  length
+ *             The length of the #buffer array.
+ * @return If zero or positive, the number of characters written; if negative, an error value
+ * corresponding to one of #uart_error_e.
+ *
+ * @private
+ */
+static int uart_private_write_8bit_hybrid(uart_module_t *module,
+                                          const void *buffer,
+                                          unsigned int length)
+{
+    uart_private_t *private;
+    unsigned int data_written;
+
+    // Check for a valid module
+    if( !uart_is_valid(module) )
+    {// Invalid module
+        return UART_E_MODULE;
+    }
+
+    // Check if TX enabled
+    if( !uart_is_open(module, UART_DIRECTION_TX) )
+    {// TX is closed
+        return UART_E_CLOSED;
+    }
+
+    private = UART_GET_PRIVATE(module);
+
+    // Coalesce the characters with those already waiting
+    private->tx_writing_ = true;
+    data_written = ringbuf_write(&private->tx_ring_, buffer, length);
+    private->tx_writing_ = false;
+
+    // A busy channel is fed by the TX DMA ISR, an idle one waits for the watermark or the deadline
+    if( !private->tx_dma_busy_ && ringbuf_count(&private->tx_ring_) >= private->tx_hybrid_watermark_ )
+    {// Enough characters for a transfer
+        UART_HW_DISABLE_INTERRUPTS();
+        uart_private_tx_hybrid_feed(module);
+        UART_HW_ENABLE_INTERRUPTS();
+    }
+
+    return data_written;
+}
+
+/**
+ * @brief The most characters a #uart_writev() frame can hold in a module's TX buffer mode.
+ *
+ * @details A frame must fit in the buffer its buffer mode writes to: the software buffer, the
+ * smaller of the two DMA buffers, or the hardware FIFO.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @return The number of characters.
+ *
+ * @private
+ */
+static unsigned int uart_private_writev_capacity(uart_module_t *module)
+{
+    uart_private_t *private = UART_GET_PRIVATE(module);
+
+    switch( (UART_GET_ATTR(module).tx_buffer_settings & UART_TX_BUFFER_MODE_BITMASK) )
+    {
+    case UART_TX_BUFFER_MODE_DMA:
+        if( private->tx_dma_->buffer_a_size < private->tx_dma_->buffer_b_size )
+        {// Buffer A is the smaller
+            return private->tx_dma_->buffer_a_size;
+        }
+        return private->tx_dma_->buffer_b_size;
+    case UART_TX_BUFFER_MODE_SOFT:
+    case UART_TX_BUFFER_MODE_HYBRID:
+        return private->tx_ring_.mask + 1;
+    case UART_TX_BUFFER_MODE_HWONLY:
+    default:
+        return UART_HW_FIFO_LENGTH;
+    }
+}
+
+/**
+ * @brief The private implementation of #uart_writev() for 8-bit mode and HW buffer only.
+ *
+ * @details The frame is only written if the transmitter is idle, since then the whole FIFO is
+ * known to be free. Must be called with interrupts disabled.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @param[in]  iov
+ *             The array of segments to write.
+ * @param[in]  count
+ *             The number of segments.
+ * @param[in]  length
+ *             The total number of characters in the segments, at most
+ *             uart_private_writev_capacity().
+ * @return If zero or positive, the number of characters written; if negative, an error value
+ * corresponding to one of #uart_error_e.
+ *
+ * @private
+ */
+static int uart_private_writev_8bit_hwonly(uart_module_t *module,
+                                           const struct uart_iovec *iov,
+                                           unsigned int count,
+                                           unsigned int length)
+{
+    volatile unsigned int *txreg = UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxTXREG;
+    const unsigned char *write_ptr;
+    unsigned int segment, index;
+
+    if( (*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxSTA) & UART_SFR_BITMASK_TRMT) == 0 )
+    {// Transmission in progress
+        return UART_E_BUSY;
+    }
+
+    for( segment = 0; segment < count; segment++ )
+    {
+        write_ptr = iov[segment].base;
+        for( index = 0; index < iov[segment].length; index++ )
+        {
+            *txreg = write_ptr[index];
+        }
+    }
+
+    return length;
+}
+
+/**
+ * @brief The private implementation of #uart_writev() for 8-bit mode and DMA buffer.
+ *
+ * @details The segments are copied into the TX DMA buffer being filled, which is sent straight
+ * away if the channel is idle. Must be called with interrupts disabled.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @param[in]  iov
+ *             The array of segments to write.
+ * @param[in]  count
+ *             The number of segments.
+ * @param[in]  length
+ *             The total number of characters in the segments, at most
+ *             uart_private_writev_capacity().
+ * @return If zero or positive, the number of characters written; if negative, an error value
+ * corresponding to one of #uart_error_e.
+ *
+ * @private
+ */
+static int uart_private_writev_8bit_dma(uart_module_t *module,
+                                        const struct uart_iovec *iov,
+                                        unsigned int count,
+                                        unsigned int length)
+{
+    uart_private_t *private = UART_GET_PRIVATE(module);
+    unsigned char *dma_ptr;
+    unsigned int size;
+    unsigned int segment;
+
+    if( private->tx_dma_fill_ == DMA_PINGPONG_BUFFER_A )
+    {// Filling buffer A
+        dma_ptr = (unsigned char *)private->tx_dma_->buffer_a;
+        size = private->tx_dma_->buffer_a_size;
+    }
+    else
+    {// Filling buffer B
+        dma_ptr = (unsigned char *)private->tx_dma_->buffer_b;
+        size = private->tx_dma_->buffer_b_size;
+    }
+
+    if( length > size - private->tx_dma_count_ )
+    {// Not enough room until the transfer in progress completes
+        return UART_E_BUSY;
+    }
+
+    // Copy the segments in after the characters already waiting
+    dma_ptr += private->tx_dma_count_;
+    for( segment = 0; segment < count; segment++ )
+    {
+        memcpy(dma_ptr, iov[segment].base, iov[segment].length);
+        dma_ptr += iov[segment].length;
+    }
+    private->tx_dma_count_ += length;
+
+    if( !private->tx_dma_busy_ )
+    {// Channel is idle
+        uart_private_tx_dma_start(module);
+    }
+
+    return length;
+}
+
+/**
+ * @brief The private implementation of #uart_writev() for 8-bit mode and software or hybrid
+ * buffers.
+ *
+ * @details The segments are copied into the TX software buffer, then sent as for #uart_write().
+ * Must be called with interrupts disabled.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @param[in]  iov
+ *             The array of segments to write.
+ * @param[in]  count
+ *             The number of segments.
+ * @param[in]  length
+ *             The total number of characters in the segments, at most
+ *             uart_private_writev_capacity().
+ * @return If zero or positive, the number of characters written; if negative, an error value
+ * corresponding to one of #uart_error_e.
+ *
+ * @private
+ */
+static int uart_private_writev_8bit_soft(uart_module_t *module,
+                                         const struct uart_iovec *iov,
+                                         unsigned int count,
+                                         unsigned int length)
+{
+    uart_private_t *private = UART_GET_PRIVATE(module);
+    unsigned int segment;
+
+    if( length > ringbuf_space(&private->tx_ring_) )
+    {// Not enough room until more characters are sent
+        return UART_E_BUSY;
+    }
+
+    for( segment = 0; segment < count; segment++ )
+    {
+        ringbuf_write(&private->tx_ring_, iov[segment].base, iov[segment].length);
+    }
+
+    if( (UART_GET_ATTR(module).tx_buffer_settings & UART_TX_BUFFER_MODE_BITMASK) == UART_TX_BUFFER_MODE_HYBRID )
+    {// Start a DMA transfer once past the watermark
+        if( ringbuf_count(&private->tx_ring_) >= private->tx_hybrid_watermark_ )
+        {// Enough characters for a transfer
+            uart_private_tx_hybrid_feed(module);
+        }
+    }
+    else
+    {// Let the TX ISR move them to the FIFO
+        UART_ENABLE_TX_INTERRUPT(module);
+    }
+
+    return length;
+}
+
+/**
+ * @brief The private implementation of the UART read function for 8-bit mode and HW buffer only.
+ *
+ * @details This function defines the private implementation of the UART read function when the
+ * module is initialized in standard (8-bit) mode and uses only the hardware FIFO buffer. During
+ * initialization a pointer to this function is supplied in the uart_module_t::read() function pointer of the
+ * initialized #uart_module_t object.
+ *
+ * The #buffer parameter is cast to a "const unsigned char", so the user must also provide the same
+ * type when passing an array. This is explained for the user in uart_module_t::read().
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @param[in]  buffer
+ *             A pointer to the array to which to write any new data from the UART hardware.
+ * @param[in]  length
+ *             The length of the #buffer array.
+ * @return If zero or positive, the number of characters read in; if negative, an error value
+ * corresponding to one of #uart_error_e.
+ *
+ * @private
+ */
+static int uart_private_read_8bit_hwonly(uart_module_t *module,
+                                         void *buffer,
+                                         unsigned int length)
+{
+    int data_read = 0;
+    unsigned char *read_ptr = buffer;
+
+    // Check for a valid module
+    if( !uart_is_valid(module) )
+    {// Invalid module
+        return UART_E_MODULE;
+    }
+
+    // Check if RX enabled
+    if( !uart_is_open(module, UART_DIRECTION_RX) )
+    {// RX is closed
+        return UART_E_CLOSED;
+    }
+
+    // If data is available in FIFO, read data
+    while( IS_MASK_SET( *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxSTA), UART_SFR_BITMASK_URXDA ) )
+    {// Data available in RX FIFO buffer
+        if( data_read < length )
+        {// More space available in user buffer
+            *(read_ptr) = UART_HW_READ_RXREG(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxRXREG);
+            read_ptr++;
+            data_read++;
+        }
+        else
+        {// No space available in user buffer
+            return data_read;
+        }
+    }
+
+    return data_read;
+}
+
+/**
+ * @brief The private implementation of the UART read function for 8-bit mode and DMA buffer.
+ *
+ * @details This function defines the private implementation of the UART read function when the
+ * module is initialized in standard (8-bit) mode and uses a user supplied DMA buffer. During
+ * initialization a pointer to this function is supplied in the uart_module_t::read() function pointer of the
+ * initialized #uart_module_t object.
+ *
+ * The #buffer parameter is cast to a "const unsigned char", so the user must also provide the same
+ * type when passing an array. This is explained to the user in uart_module_t::read().
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @param[in]  buffer
+ *             A pointer to the array to which to write any new data from the UART hardware.
+ * @param[in]  length
+ *             The length of the #buffer array.
+ * @return If zero or positive, the number of characters read in; if negative, an error value
+ * corresponding to one of #uart_error_e.
+ *
+ * @private
+ */
+static int uart_private_read_8bit_dma(uart_module_t *module,
+                                      void *buffer,
+                                      unsigned int length)
+{
+    uart_private_t *private;
+    volatile unsigned int *dma_buffer;
+    unsigned char *read_ptr = buffer;
+    unsigned int data_read = 0;
+    unsigned int head;
+
+    // Check for a valid module
+    if( !uart_is_valid(module) )
+    {// Invalid module
+        return UART_E_MODULE;
+    }
+
+    // Check if RX enabled
+    if( !uart_is_open(module, UART_DIRECTION_RX) )
+    {// RX is closed
+        return UART_E_CLOSED;
+    }
+
+    private = UART_GET_PRIVATE(module);
+    dma_buffer = private->rx_dma_->buffer_a;
+    head = private->rx_dma_head_;
+
+    // Follow the channel around the buffer until an empty word
+    while( data_read < length && dma_buffer[head] != UART_DMA_RX_EMPTY )
+    {
+        *read_ptr = (unsigned char)dma_buffer[head];
+
+        // Hand the word back to the channel
+        dma_buffer[head] = UART_DMA_RX_EMPTY;
+
+        head++;
+        if( head >= private->rx_dma_->buffer_a_size )
+        {// Wrap around
+            head = 0;
+        }
+
+        read_ptr++;
+        data_read++;
+    }
+
+    private->rx_dma_head_ = head;
+
+    return data_read;
+}
+
+/**
+ * @brief The private implementation of the UART read function for 8-bit mode and software buffer.
+ *
+ * @details This function defines the private implementation of the UART read function when the
+ * module is initialized in standard (8-bit) mode and uses a software buffer. During initialization
+ * a pointer to this function is supplied in the uart_module_t::read() function pointer of the
+ * initialized #uart_module_t object.
+ *
+ * The #buffer parameter is cast to a "const unsigned char", so the user must also provide the same
+ * type when passing an array. This is explained to the user in uart_module_t::read().
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @param[in]  buffer
+ *             A pointer to the array to which to write any new data from the UART hardware.
+ * @param[in]  length
+ *             The length of the #buffer array.
+ * @return If zero or positive, the number of characters read in; if negative, an error value
+ * corresponding to one of #uart_error_e.
+ *
+ * @private
+ */
+static int uart_private_read_8bit_soft(uart_module_t *module,
+                                       void *buffer,
+                                       unsigned int length)
+{
+    // Check for a valid module
+    if( !uart_is_valid(module) )
+    {// Invalid module
+        return UART_E_MODULE;
+    }
+
+    // Check if RX enabled
+    if( !uart_is_open(module, UART_DIRECTION_RX) )
+    {// RX is closed
+        return UART_E_CLOSED;
+    }
+
+    // Copy out as many characters as are waiting
+    return ringbuf_read(&UART_GET_PRIVATE(module)->rx_ring_, buffer, length);
+}
+
+/**
+ * @brief The private implementation of the UART read function for 8-bit mode and a hybrid --
+ * software plus DMA -- buffer.
+ *
+ * @details This function defines the private implementation of the UART read function when the
+ * module is initialized in standard (8-bit) mode and uses a hybrid buffer, which implements both
+ * software and DMA buffers. During initialization a pointer to this function is supplied in the
+ * uart_module_t::read() function pointer of the initialized #uart_module_t object.
+ *
+ * The #buffer parameter is cast to a "const unsigned char", so the user must also provide the same
+ * type when passing an array. This is explained to the user in uart_module_t::read().
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @param[in]  buffer
+ *             A pointer to the array to which to write any new data from the UART hardware.
+ * @param[in]  length
+ *             The length of the #buffer array.
+ * @return If zero or positive, the number of characters read in; if negative, an error value
+ * corresponding to one of #uart_error_e.
+ *
+ * @private
+ */
+static int uart_private_read_8bit_hybrid(uart_module_t *module,
+                                         void *buffer,
+                                         unsigned int length)
+{
+    return UART_E_NONE;
+}
+
+/**
+ * @brief The private implementation of the UART write function for 9-bit mode and HW buffer only.
+ *
+ * @details This function defines the private implementation of the UART write function when the
+ * module is initialized in 9-bit mode and uses only the hardware FIFO buffer. During
+ * initialization a pointer to this function is supplied in the uart_module_t::write() function
+ * pointer of the initialized #uart_module_t object.
+ *
+ * The #buffer parameter is cast to a "const unsigned int", one word per character, with bit 8 set
+ * on address characters.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @param[in]  buffer
+ *             A pointer to the array to write out to the UART hardware.
+ * @param[in]  length
+ *             The length of the #buffer array in characters.
+ * @return If zero or positive, the number of characters written; if negative, an error value
+ * corresponding to one of #uart_error_e.
+ *
+ * @private
+ */
+static int uart_private_write_9bit_hwonly(uart_module_t *module,
+                                          const void *buffer,
+                                          unsigned int length)
+{
+    unsigned int data_written = 0;
+    const unsigned int *write_ptr = buffer;
+    
+    // Check for a valid module
+    if( !uart_is_valid(module) )
+    {// Invalid module
+        return UART_E_MODULE;
+    }
+
+    // Check if TX enabled
+    if( !uart_is_open(module, UART_DIRECTION_TX) )
+    {// TX is closed
+        return UART_E_CLOSED;
+    }
+
+    // If space avaliable in FIFO, write data
+    while( !IS_MASK_SET( *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxSTA), UART_SFR_BITMASK_UTXBF ) )
+    {// Space available in TX FIFO buffer
+        if( data_written < length )
+        {// More data to write
+            *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxTXREG) = *write_ptr;
+            write_ptr++;
+            data_written++;
+        }
+        else
+        {
+            return data_written;
+        }
+    }
+
+    return data_written;
+}
+
+/**
+ * @brief The private implementation of the UART write function for 9-bit mode and DMA buffer.
+ *
+ * @details This function works as #uart_private_write_8bit_dma(), except that each character
+ * takes a word of the DMA buffers, which the channel sends as words.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @param[in]  buffer
+ *             A pointer to the array of words to write out to the UART hardware.
+ * @param[in]  length
+ *             The length of the #buffer array in characters.
+ * @return If zero or positive, the number of characters written; if negative, an error value
+ * corresponding to one of #uart_error_e.
+ *
+ * @private
+ */
+static int uart_private_write_9bit_dma(uart_module_t *module,
+                                       const void *buffer,
+                                       unsigned int length)
+{
+    uart_private_t *private;
+    const unsigned int *write_ptr = buffer;
+    volatile unsigned int *dma_ptr;
+    unsigned int data_written = 0;
+    unsigned int size;
+    unsigned int count;
+
+    // Check for a valid module
+    if( !uart_is_valid(module) )
+    {// Invalid module
+        return UART_E_MODULE;
+    }
+
+    // Check if TX enabled
+    if( !uart_is_open(module, UART_DIRECTION_TX) )
+    {// TX is closed
+        return UART_E_CLOSED;
+    }
+
+    private = UART_GET_PRIVATE(module);
+
+    // Keep the ISR from starting the buffer being filled while characters are copied into it
+    private->tx_writing_ = true;
+
+    while( data_written < length )
+    {
+        // Find the room left in the buffer being filled
+        if( private->tx_dma_fill_ == DMA_PINGPONG_BUFFER_A )
+        {// Filling buffer A
+            dma_ptr = private->tx_dma_->buffer_a;
+            size = private->tx_dma_->buffer_a_size;
+        }
+        else
+        {// Filling buffer B
+            dma_ptr = private->tx_dma_->buffer_b;
+            size = private->tx_dma_->buffer_b_size;
+        }
+
+        count = private->tx_dma_count_;
+        if( count >= size )
+        {// Buffer is full and the other is still being sent
+            break;
+        }
+
+        // Copy as many characters as fit
+        dma_ptr += count;
+        while( count < size && data_written < length )
+        {
+            *dma_ptr = *write_ptr;
+            dma_ptr++;
+            write_ptr++;
+            count++;
+            data_written++;
+        }
+
+        // Publish the characters, and send them now if the channel is idle
+        UART_HW_DISABLE_INTERRUPTS();
+        private->tx_dma_count_ = count;
+        if( !private->tx_dma_busy_ )
+        {// Channel is idle
+            uart_private_tx_dma_start(module);
+        }
+        UART_HW_ENABLE_INTERRUPTS();
+    }
+
+    private->tx_writing_ = false;
+
+    // A transfer which completed while the ISR was held off leaves the channel idle
+    UART_HW_DISABLE_INTERRUPTS();
+    if( !private->tx_dma_busy_ && private->tx_dma_count_ > 0 )
+    {// Channel is idle with characters waiting
+        uart_private_tx_dma_start(module);
+    }
+    UART_HW_ENABLE_INTERRUPTS();
+
+    return data_written;
+}
+
+/**
+ * @brief The private implementation of the UART write function for 9-bit mode with a software
+ * buffer.
+ *
+ * @details Each character takes two bytes of the ring buffer. The ring buffer is an even number
+ * of bytes long and only ever moves whole words, so a character is never split.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @param[in]  buffer
+ *             A pointer to the array of words to write out to the UART hardware.
+ * @param[in]  length
+ *             The length of the #buffer array in characters.
+ * @return If zero or positive, the number of characters written; if negative, an error value
+ * corresponding to one of #uart_error_e.
+ *
+ * @private
+ */
+static int uart_private_write_9bit_soft(uart_module_t *module,
+                                        const void *buffer,
+                                        unsigned int length)
+{
+    unsigned int data_written;
+
+    // Check for a valid module
+    if( !uart_is_valid(module) )
+    {// Invalid module
+        return UART_E_MODULE;
+    }
+
+    // Check if TX enabled
+    if( !uart_is_open(module, UART_DIRECTION_TX) )
+    {// TX is closed
+        return UART_E_CLOSED;
+    }
+
+    // Copy as many characters as fit into the ring buffer
+    UART_GET_PRIVATE(module)->tx_writing_ = true;
+    data_written = ringbuf_write(&UART_GET_PRIVATE(module)->tx_ring_, buffer, length*sizeof(int))
+        / sizeof(int);
+    UART_GET_PRIVATE(module)->tx_writing_ = false;
+
+    // Let the TX ISR move them to the FIFO
+    if( data_written > 0 )
+    {// Characters waiting
+        UART_ENABLE_TX_INTERRUPT(module);
+    }
+
+    return data_written;
+}
+
+/**
+ * @brief The private implementation of the UART write function for 9-bit mode and a hybrid --
+ * software plus DMA -- buffer implementation.
+ *
+ * @details This function works as #uart_private_write_8bit_hybrid(), except that each character
+ * takes two bytes of the ring buffer and a word of the DMA buffers.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @param[in]  buffer
+ *             A pointer to the array of words to write out to the UART hardware.
+ * @param[in]  length
+ *             The length of the #buffer array in characters.
+ * @return If zero or positive, the number of characters written; if negative, an error value
+ * corresponding to one of #uart_error_e.
+ *
+ * @private
+ */
+static int uart_private_write_9bit_hybrid(uart_module_t *module,
+                                          const void *buffer,
+                                          unsigned int length)
+{
+    uart_private_t *private;
+    unsigned int data_written;
+
+    // Check for a valid module
+    if( !uart_is_valid(module) )
+    {// Invalid module
+        return UART_E_MODULE;
+    }
+
+    // Check if TX enabled
+    if( !uart_is_open(module, UART_DIRECTION_TX) )
+    {// TX is closed
+        return UART_E_CLOSED;
+    }
+
+    private = UART_GET_PRIVATE(module);
+
+    // Coalesce the characters with those already waiting
+    private->tx_writing_ = true;
+    data_written = ringbuf_write(&private->tx_ring_, buffer, length*sizeof(int)) / sizeof(int);
+    private->tx_writing_ = false;
+
+    // A busy channel is fed by the TX DMA ISR, an idle one waits for the watermark or the deadline
+    if( !private->tx_dma_busy_ && ringbuf_count(&private->tx_ring_) >= private->tx_hybrid_watermark_ )
+    {// Enough characters for a transfer
+        UART_HW_DISABLE_INTERRUPTS();
+        uart_private_tx_hybrid_feed(module);
+        UART_HW_ENABLE_INTERRUPTS();
+    }
+
+    return data_written;
+}
+
+/**
+ * @brief The private implementation of the UART read function for 9-bit mode and HW buffer only.
+ *
+ * @details This function defines the private implementation of the UART read function when the
+ * module is initialized in 9-bit mode and uses only the hardware FIFO buffer. In masked address
+ * mode the characters of frames for other devices are read out of the FIFO and dropped, so the
+ * hardware never overruns on them.
+ *
+ * The #buffer parameter is cast to an "unsigned int", one word per character, with bit 8 set on
+ * address characters.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @param[in]  buffer
+ *             A pointer to the array to which to write any new data from the UART hardware.
+ * @param[in]  length
+ *             The length of the #buffer array in characters.
+ * @return If zero or positive, the number of characters read in; if negative, an error value
+ * corresponding to one of #uart_error_e.
+ *
+ * @private
+ */
+static int uart_private_read_9bit_hwonly(uart_module_t *module,
+                                         void *buffer,
+                                         unsigned int length)
+{
+    volatile unsigned int *sta;
+    unsigned int *read_ptr = buffer;
+    unsigned int data_read = 0;
+    unsigned int character;
+
+    // Check for a valid module
+    if( !uart_is_valid(module) )
+    {// Invalid module
+        return UART_E_MODULE;
+    }
+
+    // Check if RX enabled
+    if( !uart_is_open(module, UART_DIRECTION_RX) )
+    {// RX is closed
+        return UART_E_CLOSED;
+    }
+
+    sta = UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxSTA;
+
+    // Only take a character out of the FIFO while there is room for it
+    while( data_read < length && (*sta & UART_SFR_BITMASK_URXDA) != 0 )
+    {// Data available in RX FIFO buffer
+        character = UART_HW_READ_RXREG(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxRXREG);
+        if( uart_private_rx_9bit_accept(module, character) )
+        {// Character is for this device
+            *read_ptr = character;
+            read_ptr++;
+            data_read++;
+        }
+    }
+
+    return data_read;
+}
+
+/**
+ * @brief The private implementation of the UART read function for 9-bit mode and DMA buffer.
+ *
+ * @details The channel receives every character, since it cannot wait for the filter to clear
+ * ADDEN after an address. In masked address mode the characters of frames for other devices are
+ * therefore dropped here, as they are read out of the DMA buffer.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @param[in]  buffer
+ *             A pointer to the array of words to which to write any new data.
+ * @param[in]  length
+ *             The length of the #buffer array in characters.
+ * @return If zero or positive, the number of characters read in; if negative, an error value
+ * corresponding to one of #uart_error_e.
+ *
+ * @private
+ */
+static int uart_private_read_9bit_dma(uart_module_t *module,
+                                      void *buffer,
+                                      unsigned int length)
+{
+    uart_private_t *private;
+    volatile unsigned int *dma_buffer;
+    unsigned int *read_ptr = buffer;
+    unsigned int data_read = 0;
+    unsigned int character;
+    unsigned int head;
+
+    // Check for a valid module
+    if( !uart_is_valid(module) )
+    {// Invalid module
+        return UART_E_MODULE;
+    }
+
+    // Check if RX enabled
+    if( !uart_is_open(module, UART_DIRECTION_RX) )
+    {// RX is closed
+        return UART_E_CLOSED;
+    }
+
+    private = UART_GET_PRIVATE(module);
+    dma_buffer = private->rx_dma_->buffer_a;
+    head = private->rx_dma_head_;
+
+    // Follow the channel around the buffer until an empty word
+    while( data_read < length && dma_buffer[head] != UART_DMA_RX_EMPTY )
+    {
+        character = dma_buffer[head];
+
+        // Hand the word back to the channel
+        dma_buffer[head] = UART_DMA_RX_EMPTY;
+
+        head++;
+        if( head >= private->rx_dma_->buffer_a_size )
+        {// Wrap around
+            head = 0;
+        }
+
+        if( uart_private_rx_9bit_accept(module, character) )
+        {// Character is for this device
+            *read_ptr = character;
+            read_ptr++;
+            data_read++;
+        }
+    }
+
+    private->rx_dma_head_ = head;
+
+    return data_read;
+}
+
+/**
+ * @brief The private implementation of the UART read function for 9-bit mode and software buffer.
+ *
+ * @details The RX ISR has already dropped the characters of frames for other devices, so the
+ * words in the ring buffer are copied out as they are.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @param[in]  buffer
+ *             A pointer to the array of words to which to write any new data.
+ * @param[in]  length
+ *             The length of the #buffer array in characters.
+ * @return If zero or positive, the number of characters read in; if negative, an error value
+ * corresponding to one of #uart_error_e.
+ *
+ * @private
+ */
+static int uart_private_read_9bit_soft(uart_module_t *module,
                                        void *buffer,
                                        unsigned int length)
 {
+    // Check for a valid module
+    if( !uart_is_valid(module) )
+    {// Invalid module
+        return UART_E_MODULE;
+    }
+
+    // Check if RX enabled
+    if( !uart_is_open(module, UART_DIRECTION_RX) )
+    {// RX is closed
+        return UART_E_CLOSED;
+    }
+
+    // Copy out as many whole characters as are waiting
+    return ringbuf_read(&UART_GET_PRIVATE(module)->rx_ring_, buffer, length*sizeof(int)) / sizeof(int);
+}
+
+/**
+ * @brief The private implementation of the UART read function for 9-bit mode and a hybrid --
+ * software plus DMA -- buffer.
+ *
+ * @note The hybrid RX buffer mode is not implemented yet in any major mode, see
+ * #uart_private_read_8bit_hybrid().
+ *
+ * @private
+ */
+static int uart_private_read_9bit_hybrid(uart_module_t *module,
+                                         void *buffer,
+                                         unsigned int length)
+{
+    return UART_E_NONE;
+}
+
+/**
+ * @brief The private implementations of the UART write and read functions for LIN mode.
+ *
+ * @details LIN traffic is only exchanged through the frames given to #uart_lin_set_frames() and
+ * #uart_lin_set_schedule(), whose responses the RX ISR sends and receives, so plain writes and
+ * reads are refused whatever the buffer modes.
+ *
+ * @return #UART_E_CONFIG
+ *
+ * @private
+ */
+static int uart_private_write_lin_hwonly(uart_module_t *module,
+                                         const void *buffer,
+                                         unsigned int length)
+{
+    return UART_E_CONFIG;
+}
+
+static int uart_private_write_lin_dma(uart_module_t *module,
+                                      const void *buffer,
+                                      unsigned int length)
+{
+    return UART_E_CONFIG;
+}
+
+static int uart_private_write_lin_soft(uart_module_t *module,
+                                       const void *buffer,
+                                       unsigned int length)
+{
+    return UART_E_CONFIG;
+}
+
+static int uart_private_write_lin_hybrid(uart_module_t *module,
+                                         const void *buffer,
+                                         unsigned int length)
+{
+    return UART_E_CONFIG;
+}
+
+static int uart_private_read_lin_hwonly(uart_module_t *module,
+                                        void *buffer,
+                                        unsigned int length)
+{
+    return UART_E_CONFIG;
+}
+
+static int uart_private_read_lin_dma(uart_module_t *module,
+                                     void *buffer,
+                                     unsigned int length)
+{
+    return UART_E_CONFIG;
+}
+
+static int uart_private_read_lin_soft(uart_module_t *module,
+                                      void *buffer,
+                                      unsigned int length)
+{
+    return UART_E_CONFIG;
+}
+
+static int uart_private_read_lin_hybrid(uart_module_t *module,
+                                        void *buffer,
+                                        unsigned int length)
+{
+    return UART_E_CONFIG;
+}
+
+/**
+ * @brief Flushes any data in the TX buffer.
+ *
+ * @details The flush function forces any data in the TX buffers to be sent. However, in the
+ * hardware only buffer mode any data that is in the FIFO buffer will automatically be sent, so
+ * there is nothing for the flush function to do.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @return A value corresponding to one of #uart_error_e.
+ * @private
+ */
+static int uart_private_flush_tx_hwonly(uart_module_t *module)
+{
+    // Check for a valid module
+    if( !uart_is_valid(module) )
+    {// Invalid module
+        return UART_E_MODULE;
+    }
+
+    // Check if TX is enabled
+    if( !uart_is_open(module, UART_DIRECTION_TX) )
+    {// TX is closed
+        return UART_E_CLOSED;
+    }
+
+    return UART_E_NONE;
+}
+
+/**
+ * @brief Flushes any data in the RX buffer.
+ *
+ * @details The flush function forces any data in the RX hardware buffers to be made available via
+ * the uart_module_t::read() function. However, in the hardware only buffer mode all data in the
+ * FIFO buffer is already accessible, so there is nothing for the flush function to do.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @return A value corresponding to one of #uart_error_e.
+ * @private
+ */
+static int uart_private_flush_rx_hwonly(uart_module_t *module)
+{
+    // Check for a valid module
+    if( !uart_is_valid(module) )
+    {// Invalid module
+        return UART_E_MODULE;
+    }
+
+    // Check if RX is enabled
+    if( !uart_is_open(module, UART_DIRECTION_RX) )
+    {// RX is closed
+        return UART_E_CLOSED;
+    }
+
     return UART_E_NONE;
 }
 
-static int uart_private_read_9bit_hybrid(uart_module_t *module,
-                                         void *buffer,
-                                         unsigned int length)
+/**
+ * @brief Flushes any data in the TX DMA buffers.
+ *
+ * @details Writes start a transfer as soon as the channel is idle, and the TX ISR starts the
+ * buffer filled meanwhile when a transfer completes, so this only starts a transfer if characters
+ * are somehow left waiting on an idle channel.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @return A value corresponding to one of #uart_error_e.
+ * @private
+ */
+static int uart_private_flush_tx_dma(uart_module_t *module)
 {
+    // Check for a valid module
+    if( !uart_is_valid(module) )
+    {// Invalid module
+        return UART_E_MODULE;
+    }
+
+    // Check if TX is enabled
+    if( !uart_is_open(module, UART_DIRECTION_TX) )
+    {// TX is closed
+        return UART_E_CLOSED;
+    }
+
+    UART_HW_DISABLE_INTERRUPTS();
+    if( !UART_GET_PRIVATE(module)->tx_dma_busy_ && UART_GET_PRIVATE(module)->tx_dma_count_ > 0 )
+    {// Channel is idle with characters waiting
+        uart_private_tx_dma_start(module);
+    }
+    UART_HW_ENABLE_INTERRUPTS();
+
     return UART_E_NONE;
 }
 
-static int uart_private_write_lin_hwonly(uart_module_t *module,
-                                         const void *buffer,
-                                         unsigned int length)
+/**
+ * @brief Flushes any data in the RX DMA buffer.
+ *
+ * @details Every character received is readable as soon as the channel has moved it, so this only
+ * notifies the user through rx_callback if characters are waiting which no interrupt or
+ * #uart_tick() has announced yet.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @return A value corresponding to one of #uart_error_e.
+ * @private
+ */
+static int uart_private_flush_rx_dma(uart_module_t *module)
 {
+    // Check for a valid module
+    if( !uart_is_valid(module) )
+    {// Invalid module
+        return UART_E_MODULE;
+    }
+
+    // Check if RX enabled
+    if( !uart_is_open(module, UART_DIRECTION_RX) )
+    {// RX is closed
+        return UART_E_CLOSED;
+    }
+
+    if( !UART_GET_PRIVATE(module)->rx_dma_notified_ && uart_private_rx_dma_available(module) > 0 )
+    {// Characters waiting unannounced
+        UART_GET_PRIVATE(module)->rx_dma_notified_ = true;
+
+        // Notify user by calling rx_callback
+        if( module->rx_callback != NULL )
+        {// Callback is valid
+            module->rx_callback(module);
+        }
+    }
+
     return UART_E_NONE;
 }
 
-static int uart_private_write_lin_dma(uart_module_t *module,
-                                      const void *buffer,
-                                      unsigned int length)
+/**
+ * @brief Flushes any data in the TX software buffer.
+ *
+ * @details The TX ISR moves characters to the FIFO while its interrupt is enabled, so this only
+ * makes sure the interrupt is enabled while characters are waiting.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @return A value corresponding to one of #uart_error_e.
+ * @private
+ */
+static int uart_private_flush_tx_soft(uart_module_t *module)
 {
+    // Check for a valid module
+    if( !uart_is_valid(module) )
+    {// Invalid module
+        return UART_E_MODULE;
+    }
+
+    // Check if TX is enabled
+    if( !uart_is_open(module, UART_DIRECTION_TX) )
+    {// TX is closed
+        return UART_E_CLOSED;
+    }
+
+    if( ringbuf_count(&UART_GET_PRIVATE(module)->tx_ring_) > 0 )
+    {// Characters waiting
+        UART_ENABLE_TX_INTERRUPT(module);
+    }
+
     return UART_E_NONE;
 }
 
-static int uart_private_write_lin_soft(uart_module_t *module,
-                                       const void *buffer,
-                                       unsigned int length)
+/**
+ * @brief Flushes any data in the RX software buffer.
+ *
+ * @details The RX ISR moves every character into the ring buffer as it arrives, so there is
+ * nothing to flush.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @return A value corresponding to one of #uart_error_e.
+ * @private
+ */
+static int uart_private_flush_rx_soft(uart_module_t *module)
 {
+    // Check for a valid module
+    if( !uart_is_valid(module) )
+    {// Invalid module
+        return UART_E_MODULE;
+    }
+
+    // Check if RX is enabled
+    if( !uart_is_open(module, UART_DIRECTION_RX) )
+    {// RX is closed
+        return UART_E_CLOSED;
+    }
+
     return UART_E_NONE;
 }
 
-static int uart_private_write_lin_hybrid(uart_module_t * module,
-                                         const void *buffer,
-                                         unsigned int length)
+/**
+ * @brief Flushes any data in the TX software buffer to the TX DMA channel.
+ *
+ * @details If the DMA channel is idle a transfer of the waiting characters starts without waiting
+ * for the watermark or the deadline. The rest are sent by the TX DMA ISR as transfers complete.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @return A value corresponding to one of #uart_error_e.
+ * @private
+ */
+static int uart_private_flush_tx_hybrid(uart_module_t *module)
 {
+    // Check for a valid module
+    if( !uart_is_valid(module) )
+    {// Invalid module
+        return UART_E_MODULE;
+    }
+
+    // Check if TX is enabled
+    if( !uart_is_open(module, UART_DIRECTION_TX) )
+    {// TX is closed
+        return UART_E_CLOSED;
+    }
+
+    UART_HW_DISABLE_INTERRUPTS();
+    uart_private_tx_hybrid_feed(module);
+    UART_HW_ENABLE_INTERRUPTS();
+
     return UART_E_NONE;
 }
 
-static int uart_private_read_lin_hwonly(uart_module_t *module,
-                                        void *buffer,
-                                        unsigned int length)
+static int uart_private_flush_rx_hybrid(uart_module_t *module)
 {
     return UART_E_NONE;
 }
 
-static int uart_private_read_lin_dma(uart_module_t *module,
-                                     void *buffer,
-                                     unsigned int length)
-{
-    return UART_E_NONE;
-}
+static void uart_private_tx_isr_hwonly(uart_module_t *module)
+{
+    // Check for a valid module
+    if( !uart_is_valid(module) )
+    {// Invalid module
+        return;
+    }
+
+    // Check if TX enabled
+    if( !uart_is_open(module, UART_DIRECTION_TX) )
+    {// TX is closed
+        return;
+    }
+
+    // Notify user by calling tx_callback
+    if( module->tx_callback != NULL )
+    {// Callback is valid
+        module->tx_callback(module);
+    }
+}
+
+/**
+ * @brief The TX ISR for DMA buffer mode, called when a TX DMA transfer completes.
+ *
+ * @details The buffer filled while the transfer was in progress is started straight away, so
+ * back to back writes leave the line idle only for the time this ISR takes. The buffer which was
+ * sent is then free, so the user is notified through tx_callback.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @private
+ */
+static void uart_private_tx_isr_dma(uart_module_t *module)
+{
+    uart_private_t *private;
+
+    // Check for a valid module
+    if( !uart_is_valid(module) )
+    {// Invalid module
+        return;
+    }
+
+    // Check if TX enabled
+    if( !uart_is_open(module, UART_DIRECTION_TX) )
+    {// TX is closed
+        return;
+    }
+
+    private = UART_GET_PRIVATE(module);
+
+    // Transfer complete, start the next buffer unless a write is still filling it
+    private->tx_dma_busy_ = false;
+    if( !private->tx_writing_ && private->tx_dma_count_ > 0 )
+    {// Characters waiting
+        uart_private_tx_dma_start(module);
+    }
+
+    // Notify user by calling tx_callback
+    if( module->tx_callback != NULL )
+    {// Callback is valid
+        module->tx_callback(module);
+    }
+}
+
+/**
+ * @brief The TX ISR for software buffer mode, called when the hardware FIFO has room.
+ *
+ * @details The interrupt flag is only cleared when characters are moved, and moving them sets it
+ * again once they leave the FIFO. With the ring buffer empty the interrupt is disabled and the
+ * flag left set, so the next write, which enables the interrupt, enters this ISR straight away.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @private
+ */
+static void uart_private_tx_isr_soft(uart_module_t *module)
+{
+    // Check for a valid module
+    if( !uart_is_valid(module) )
+    {// Invalid module
+        return;
+    }
+
+    // Check if TX enabled
+    if( !uart_is_open(module, UART_DIRECTION_TX) )
+    {// TX is closed
+        return;
+    }
+
+    if( ringbuf_count(&UART_GET_PRIVATE(module)->tx_ring_) == 0 )
+    {// Nothing to send, wait for the next write
+        UART_DISABLE_TX_INTERRUPT(module);
+
+        // A write may have filled the ring buffer and enabled the interrupt since the check
+        if( ringbuf_count(&UART_GET_PRIVATE(module)->tx_ring_) > 0 )
+        {// Characters waiting
+            UART_ENABLE_TX_INTERRUPT(module);
+        }
+        return;
+    }
+
+    UART_CLEAR_TX_FLAG(module);
+    uart_private_tx_fill_fifo(module);
+
+    // Notify user by calling tx_callback
+    if( module->tx_callback != NULL )
+    {// Callback is valid
+        module->tx_callback(module);
+    }
+}
+
+/**
+ * @brief The TX ISR for hybrid buffer mode, called when a TX DMA transfer completes.
+ *
+ * @details The channel is fed the next block of characters from the software buffer straight
+ * away, whatever the watermark, so a backlog is sent at line rate with one interrupt per DMA
+ * buffer.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @private
+ */
+static void uart_private_tx_isr_hybrid(uart_module_t *module)
+{
+    // Check for a valid module
+    if( !uart_is_valid(module) )
+    {// Invalid module
+        return;
+    }
+
+    // Check if TX enabled
+    if( !uart_is_open(module, UART_DIRECTION_TX) )
+    {// TX is closed
+        return;
+    }
+
+    // Transfer complete, keep the channel fed
+    UART_GET_PRIVATE(module)->tx_dma_busy_ = false;
+    uart_private_tx_hybrid_feed(module);
 
-static int uart_private_read_lin_soft(uart_module_t *module,
-                                      void *buffer,
-                                      unsigned int length)
-{
-    return UART_E_NONE;
+    // Notify user by calling tx_callback
+    if( module->tx_callback != NULL )
+    {// Callback is valid
+        module->tx_callback(module);
+    }
 }
 
-static int uart_private_read_lin_hybrid(uart_module_t *module,
-                                        void *buffer,
-                                        unsigned int length)
+static void uart_private_rx_isr_hwonly(uart_module_t *module)
 {
-    return UART_E_NONE;
+    // Check for a valid module
+    if( !uart_is_valid(module) )
+    {// Invalid module
+        return;
+    }
+
+    // Check if RX enabled
+    if( !uart_is_open(module, UART_DIRECTION_RX) )
+    {// RX is closed
+        return;
+    }
+
+    // Notify user by calling rx_callback
+    if( module->rx_callback != NULL )
+    {// Callback is valid
+        module->rx_callback(module);
+    }   
 }
 
 /**
- * @brief Flushes any data in the TX buffer.
+ * @brief The RX ISR for DMA buffer mode, called when the RX DMA channel has filled half of its
+ * buffer.
  *
- * @details The flush function forces any data in the TX buffers to be sent. However, in the
- * hardware only buffer mode any data that is in the FIFO buffer will automatically be sent, so
- * there is nothing for the flush function to do.
+ * @details The channel only raises one interrupt per block, at either its half or its end, so the
+ * ISR alternates between the two. Every half buffer of characters therefore costs one interrupt,
+ * after which the user is notified through rx_callback.
  *
  * @param[in]  module
  *             The UART module to work on.
- * @return A value corresponding to one of #uart_error_e.
  * @private
  */
-static int uart_private_flush_tx_hwonly(uart_module_t *module)
+static void uart_private_rx_isr_dma(uart_module_t *module)
 {
+    uart_private_t *private;
+
     // Check for a valid module
     if( !uart_is_valid(module) )
     {// Invalid module
-        return UART_E_MODULE;
+        return;
     }
 
-    // Check if TX is enabled
-    if( !uart_is_open(module, UART_DIRECTION_TX) )
-    {// TX is closed
-        return UART_E_CLOSED;
+    // Check if RX enabled
+    if( !uart_is_open(module, UART_DIRECTION_RX) )
+    {// RX is closed
+        return;
     }
 
-    return UART_E_NONE;
+    private = UART_GET_PRIVATE(module);
+
+    // Interrupt on the other end of the half just filled
+    if( private->rx_dma_half_ == DMA_INTERRUPT_ON_HALF )
+    {// First half filled, interrupt when the block completes
+        private->rx_dma_half_ = DMA_INTERRUPT_ON_FULL;
+    }
+    else
+    {// Second half filled, interrupt half way through the next block
+        private->rx_dma_half_ = DMA_INTERRUPT_ON_HALF;
+    }
+    dma_set_interrupt_on(private->rx_dma_, private->rx_dma_half_);
+
+    private->rx_dma_notified_ = true;
+
+    // Notify user by calling rx_callback
+    if( module->rx_callback != NULL )
+    {// Callback is valid
+        module->rx_callback(module);
+    }
 }
 
 /**
- * @brief Flushes any data in the RX buffer.
+ * @brief The RX ISR for software buffer mode, called when a character is received.
  *
- * @details The flush function forces any data in the RX hardware buffers to be made available via
- * the uart_module_t::read() function. However, in the hardware only buffer mode all data in the
- * FIFO buffer is already accessible, so there is nothing for the flush function to do.
+ * @details Every character in the hardware FIFO is moved to the ring buffer, except in 9-bit masked
+ * address mode those of frames for other devices. Characters which do not fit are dropped. An
+ * overrun stops reception until its flag is cleared, so it is cleared here, losing the characters
+ * which did not fit in the FIFO.
  *
  * @param[in]  module
  *             The UART module to work on.
- * @return A value corresponding to one of #uart_error_e.
  * @private
  */
-static int uart_private_flush_rx_hwonly(uart_module_t *module)
+static void uart_private_rx_isr_soft(uart_module_t *module)
 {
+    volatile unsigned int *sta;
+    unsigned char character;
+    unsigned int word;
+
     // Check for a valid module
     if( !uart_is_valid(module) )
     {// Invalid module
-        return UART_E_MODULE;
+        return;
     }
 
-    // Check if RX is enabled
+    // Check if RX enabled
     if( !uart_is_open(module, UART_DIRECTION_RX) )
     {// RX is closed
-        return UART_E_CLOSED;
+        return;
     }
 
-    return UART_E_NONE;
+    sta = UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxSTA;
+
+    UART_CLEAR_RX_FLAG(module);
+
+    if( uart_private_character_size(module) == sizeof(int) )
+    {// 9-bit characters take a word of the ring buffer, those for other devices are dropped
+        while( (*sta & UART_SFR_BITMASK_URXDA) != 0 )
+        {// Data available in RX FIFO buffer
+            word = UART_HW_READ_RXREG(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxRXREG);
+            if( uart_private_rx_9bit_accept(module, word) )
+            {// Character is for this device
+                ringbuf_write(&UART_GET_PRIVATE(module)->rx_ring_, &word, sizeof(word));
+            }
+        }
+    }
+    else
+    {// Standard characters take a byte
+        while( (*sta & UART_SFR_BITMASK_URXDA) != 0 )
+        {// Data available in RX FIFO buffer
+            character = UART_HW_READ_RXREG(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxRXREG);
+            ringbuf_put(&UART_GET_PRIVATE(module)->rx_ring_, character);
+        }
+    }
+
+    if( (*sta & UART_SFR_BITMASK_OERR) != 0 )
+    {// Overrun, restart reception
+        WRITE_MASK_CLEAR(*sta, UART_SFR_BITMASK_OERR);
+    }
+
+    // Notify user by calling rx_callback
+    if( module->rx_callback != NULL )
+    {// Callback is valid
+        module->rx_callback(module);
+    }
 }
 
-static int uart_private_flush_tx_dma(uart_module_t *module)
+static void uart_private_rx_isr_hybrid(uart_module_t *module)
 {
-    return UART_E_NONE;
 }
 
-static int uart_private_flush_rx_dma(uart_module_t *module)
+/**
+ * @brief End the LIN frame in progress and wait for the next break.
+ *
+ * @details The status is set on the frame whose response was in progress, if any, and the user
+ * is notified through tx_callback for a published frame or rx_callback for a subscribed one. Must
+ * be called with interrupts disabled, or from the RX ISR.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @param[in]  status
+ *             The #uart_lin_status_t value to end the frame with.
+ *
+ * @private
+ */
+static void uart_private_lin_finish(uart_module_t *module,
+                                    unsigned char status)
 {
-    return UART_E_NONE;
+    uart_private_t *private = UART_GET_PRIVATE(module);
+    uart_lin_frame_t *frame = private->lin_frame_;
+
+    private->lin_state_ = UART_LIN_STATE_IDLE;
+    private->lin_frame_ = NULL;
+    private->lin_header_frame_ = NULL;
+
+    if( frame == NULL )
+    {// Only a header was in progress
+        return;
+    }
+
+    frame->status = status;
+
+    // Notify user by calling the callback of the frame's direction
+    if( frame->direction == UART_LIN_DIRECTION_PUBLISH )
+    {// Response sent
+        if( module->tx_callback != NULL )
+        {// Callback is valid
+            module->tx_callback(module);
+        }
+    }
+    else if( module->rx_callback != NULL )
+    {// Response received, callback is valid
+        module->rx_callback(module);
+    }
 }
 
-static int uart_private_flush_tx_soft(uart_module_t *module)
+/**
+ * @brief Find the LIN frame this node takes part in for a frame identifier.
+ *
+ * @details The frame whose header this master sent is checked first, then the frame table.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @param[in]  id
+ *             The frame identifier received.
+ * @return The frame, or NULL if this node does not take part in it.
+ *
+ * @private
+ */
+static uart_lin_frame_t * uart_private_lin_lookup(uart_module_t *module,
+                                                  unsigned char id)
 {
-    return UART_E_NONE;
+    uart_private_t *private = UART_GET_PRIVATE(module);
+    unsigned int index;
+
+    if( private->lin_header_frame_ != NULL && private->lin_header_frame_->id == id )
+    {// Frame of the master's own slot
+        return private->lin_header_frame_;
+    }
+
+    for( index = 0; index < private->lin_frames_count_; index++ )
+    {
+        if( private->lin_frames_[index].id == id )
+        {// Frame in the table
+            return &private->lin_frames_[index];
+        }
+    }
+
+    return NULL;
 }
 
-static int uart_private_flush_rx_soft(uart_module_t *module)
+/**
+ * @brief Send a LIN response through the TX buffer.
+ *
+ * @details With a TX DMA channel the whole response goes out as one transfer. With a software
+ * buffer it is queued for the TX ISR or, in hybrid mode, handed to the DMA channel. Must be
+ * called with interrupts disabled, or from an ISR.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @param[in]  data
+ *             The data bytes followed by the checksum.
+ * @param[in]  length
+ *             The number of bytes to send.
+ * @return True if the response was queued, false if the TX buffer was still busy.
+ *
+ * @private
+ */
+static bool uart_private_lin_send(uart_module_t *module,
+                                  const unsigned char *data,
+                                  unsigned int length)
 {
-    return UART_E_NONE;
+    uart_private_t *private = UART_GET_PRIVATE(module);
+    volatile unsigned char *dma_ptr;
+    unsigned int index;
+
+    switch( (UART_GET_ATTR(module).tx_buffer_settings & UART_TX_BUFFER_MODE_BITMASK) )
+    {
+    case UART_TX_BUFFER_MODE_DMA:
+        if( private->tx_dma_busy_ || private->tx_writing_ )
+        {// Channel still sending
+            return false;
+        }
+
+        if( private->tx_dma_fill_ == DMA_PINGPONG_BUFFER_A )
+        {// Filling buffer A
+            dma_ptr = (volatile unsigned char *)private->tx_dma_->buffer_a;
+        }
+        else
+        {// Filling buffer B
+            dma_ptr = (volatile unsigned char *)private->tx_dma_->buffer_b;
+        }
+
+        for( index = 0; index < length; index++ )
+        {
+            dma_ptr[index] = data[index];
+        }
+        private->tx_dma_count_ = length;
+        uart_private_tx_dma_start(module);
+        return true;
+
+    case UART_TX_BUFFER_MODE_SOFT:
+        if( ringbuf_space(&private->tx_ring_) < length )
+        {// Software buffer too full
+            return false;
+        }
+
+        ringbuf_write(&private->tx_ring_, data, length);
+        UART_ENABLE_TX_INTERRUPT(module);
+        return true;
+
+    case UART_TX_BUFFER_MODE_HYBRID:
+        if( ringbuf_space(&private->tx_ring_) < length )
+        {// Software buffer too full
+            return false;
+        }
+
+        ringbuf_write(&private->tx_ring_, data, length);
+        uart_private_tx_hybrid_feed(module);
+        return true;
+
+    default:
+        // The FIFO cannot hold a whole response
+        return false;
+    }
 }
 
-static int uart_private_flush_tx_hybrid(uart_module_t *module)
+/**
+ * @brief Handle a valid PID received in LIN mode.
+ *
+ * @details For a frame this node publishes the response is sent straight away, and is then read
+ * back from the bus. For a frame it subscribes the response is received. Other frames are skipped
+ * up to the next break. Only called from the RX ISR.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @param[in]  pid
+ *             The protected identifier received.
+ *
+ * @private
+ */
+static void uart_private_lin_pid(uart_module_t *module,
+                                 unsigned char pid)
 {
-    return UART_E_NONE;
+    uart_private_t *private = UART_GET_PRIVATE(module);
+    uart_lin_frame_t *frame = uart_private_lin_lookup(module, pid & UART_LIN_ID_MASK);
+    bool enhanced;
+
+    if( frame == NULL || frame->direction == UART_LIN_DIRECTION_IGNORE )
+    {// Not for this node, wait for the next break
+        uart_private_lin_finish(module, UART_LIN_STATUS_NONE);
+        return;
+    }
+
+    private->lin_frame_ = frame;
+    private->lin_pid_ = pid;
+    private->lin_count_ = 0;
+    private->lin_length_ = frame->length + 1;
+    private->lin_state_ = UART_LIN_STATE_RESPONSE;
+    frame->status = UART_LIN_STATUS_BUSY;
+
+    if( frame->direction == UART_LIN_DIRECTION_PUBLISH )
+    {// Send the response, it is checked as it reads back
+        enhanced = frame->checksum == UART_LIN_CHECKSUM_ENHANCED && frame->id < UART_LIN_ID_DIAGNOSTIC;
+        memcpy(private->lin_response_, frame->data, frame->length);
+        private->lin_response_[frame->length] = uart_lin_checksum(pid, frame->data, frame->length, enhanced);
+
+        if( !uart_private_lin_send(module, private->lin_response_, private->lin_length_) )
+        {// Previous response still going out, the slot is too short
+            uart_private_lin_finish(module, UART_LIN_STATUS_E_NO_RESPONSE);
+        }
+    }
 }
 
-static int uart_private_flush_rx_hybrid(uart_module_t *module)
+/**
+ * @brief Handle a response character received in LIN mode.
+ *
+ * @details A published response is compared with what was sent, so a collision with another node
+ * ends the frame. A subscribed response is copied into the frame once the checksum is good. Only
+ * called from the RX ISR.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @param[in]  character
+ *             The character received.
+ *
+ * @private
+ */
+static void uart_private_lin_response(uart_module_t *module,
+                                      unsigned char character)
 {
-    return UART_E_NONE;
+    uart_private_t *private = UART_GET_PRIVATE(module);
+    uart_lin_frame_t *frame = private->lin_frame_;
+    unsigned int length = frame->length;
+    bool enhanced;
+
+    if( frame->direction == UART_LIN_DIRECTION_PUBLISH )
+    {// Reading back our own response
+        if( character != private->lin_response_[private->lin_count_] )
+        {// Another node was sending too
+            uart_private_lin_finish(module, UART_LIN_STATUS_E_BIT);
+            return;
+        }
+    }
+    else
+    {// Receiving another node's response
+        private->lin_response_[private->lin_count_] = character;
+    }
+
+    private->lin_count_++;
+    if( private->lin_count_ < private->lin_length_ )
+    {// More to come
+        return;
+    }
+
+    if( frame->direction == UART_LIN_DIRECTION_PUBLISH )
+    {// Whole response went out intact
+        uart_private_lin_finish(module, UART_LIN_STATUS_OK);
+        return;
+    }
+
+    enhanced = frame->checksum == UART_LIN_CHECKSUM_ENHANCED && frame->id < UART_LIN_ID_DIAGNOSTIC;
+    if( uart_lin_checksum(private->lin_pid_, private->lin_response_, length, enhanced)
+        != private->lin_response_[length] )
+    {// Corrupted response, keep the previous data
+        uart_private_lin_finish(module, UART_LIN_STATUS_E_CHECKSUM);
+        return;
+    }
+
+    memcpy(frame->data, private->lin_response_, length);
+    uart_private_lin_finish(module, UART_LIN_STATUS_OK);
 }
 
-static void uart_private_tx_isr_hwonly(uart_module_t *module)
+/**
+ * @brief The RX ISR for LIN mode, called when a character is received.
+ *
+ * @details Every character in the hardware FIFO goes through the frame state machine. A break
+ * reads as a zero character with a framing error and starts a new frame from any state, ending a
+ * response which was cut short. The master reads back its own header the same way as a slave
+ * receives it, so both follow the same path. An overrun is cleared so reception carries on.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @private
+ */
+static void uart_private_rx_isr_lin(uart_module_t *module)
 {
+    uart_private_t *private;
+    volatile unsigned int *sta;
+    unsigned char character;
+    bool framing;
+
     // Check for a valid module
     if( !uart_is_valid(module) )
     {// Invalid module
         return;
     }
 
-    // Check if TX enabled
-    if( !uart_is_open(module, UART_DIRECTION_TX) )
-    {// TX is closed
+    // Check if RX enabled
+    if( !uart_is_open(module, UART_DIRECTION_RX) )
+    {// RX is closed
         return;
     }
 
-    // Notify user by calling tx_callback
-    if( module->tx_callback != NULL )
-    {// Callback is valid
-        module->tx_callback(module);
-    }
-}
+    private = UART_GET_PRIVATE(module);
+    sta = UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxSTA;
 
-static void uart_private_tx_isr_dma(uart_module_t *module)
-{
-}
+    UART_CLEAR_RX_FLAG(module);
 
-static void uart_private_tx_isr_soft(uart_module_t *module)
-{
-}
+    while( (*sta & UART_SFR_BITMASK_URXDA) != 0 )
+    {// Data available in RX FIFO buffer
+        // The error flags describe the character at the top of the FIFO, so read them first
+        framing = (*sta & UART_SFR_BITMASK_FERR) != 0;
+        character = UART_HW_READ_RXREG(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxRXREG);
+
+        if( framing && character == 0x00 )
+        {// Break, a new frame starts
+            if( private->lin_state_ == UART_LIN_STATE_RESPONSE )
+            {// Response cut short
+                uart_private_lin_finish(module, UART_LIN_STATUS_E_NO_RESPONSE);
+            }
+            private->lin_state_ = UART_LIN_STATE_SYNC;
+            private->lin_age_ = 0;
+            continue;
+        }
+
+        if( framing )
+        {// Corrupted character, drop the frame
+            uart_private_lin_finish(module, UART_LIN_STATUS_E_FRAMING);
+            continue;
+        }
+
+        switch( private->lin_state_ )
+        {
+        case UART_LIN_STATE_SYNC:
+            // Expect the sync character
+            private->lin_state_ = (character == UART_LIN_SYNC) ? UART_LIN_STATE_PID : UART_LIN_STATE_IDLE;
+            break;
+        case UART_LIN_STATE_PID:
+            if( uart_lin_pid_is_valid(character) )
+            {// Header complete
+                uart_private_lin_pid(module, character);
+            }
+            else
+            {// Corrupted header, wait for the next break
+                uart_private_lin_finish(module, UART_LIN_STATUS_NONE);
+            }
+            break;
+        case UART_LIN_STATE_RESPONSE:
+            uart_private_lin_response(module, character);
+            break;
+        case UART_LIN_STATE_IDLE:
+        default:
+            // Not part of a frame for this node
+            break;
+        }
+    }
 
-static void uart_private_tx_isr_hybrid(uart_module_t *module)
-{
+    if( (*sta & UART_SFR_BITMASK_OERR) != 0 )
+    {// Overrun, restart reception
+        WRITE_MASK_CLEAR(*sta, UART_SFR_BITMASK_OERR);
+    }
 }
 
-static void uart_private_rx_isr_hwonly(uart_module_t *module)
+/**
+ * @brief Run the LIN frame timeout and master schedule table on each #uart_tick().
+ *
+ * @details A frame still in progress UART_DEF_LIN_FRAME_TICKS ticks after its break is ended, as
+ * is one still in progress when the next slot starts. A slot starts by sending its header through
+ * the hardware FIFO, the break as a dummy character with UTXBRK set, then the sync character and
+ * the PID. If the transmitter is still busy with a previous response the header is skipped and
+ * the frame ended, through the same callback as a frame which completes.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ *
+ * @private
+ */
+static void uart_private_tick_lin(uart_module_t *module)
 {
-    // Check for a valid module
-    if( !uart_is_valid(module) )
-    {// Invalid module
-        return;
+    uart_private_t *private = UART_GET_PRIVATE(module);
+    volatile unsigned int *sta = UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxSTA;
+    volatile unsigned int *txreg = UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxTXREG;
+    const uart_lin_slot_t *slot;
+
+    UART_HW_DISABLE_INTERRUPTS();
+
+    if( private->lin_state_ != UART_LIN_STATE_IDLE && ++private->lin_age_ > UART_DEF_LIN_FRAME_TICKS )
+    {// Frame overran its time
+        uart_private_lin_finish(module, UART_LIN_STATUS_E_NO_RESPONSE);
     }
 
-    // Check if RX enabled
-    if( !uart_is_open(module, UART_DIRECTION_RX) )
-    {// RX is closed
+    if( private->lin_schedule_count_ == 0 || --private->lin_slot_ticks_ > 0 )
+    {// No schedule, or the slot carries on
+        UART_HW_ENABLE_INTERRUPTS();
         return;
     }
 
-    // Notify user by calling rx_callback
-    if( module->rx_callback != NULL )
-    {// Callback is valid
-        module->rx_callback(module);
-    }   
-}
+    // End whatever is left of the previous slot
+    if( private->lin_state_ != UART_LIN_STATE_IDLE )
+    {// Response did not fit in its slot
+        uart_private_lin_finish(module, UART_LIN_STATUS_E_NO_RESPONSE);
+    }
 
-static void uart_private_rx_isr_dma(uart_module_t *module)
-{
-}
+    // Move on to the next slot
+    slot = &private->lin_schedule_[private->lin_slot_];
+    private->lin_slot_ticks_ = slot->ticks;
+    private->lin_slot_++;
+    if( private->lin_slot_ >= private->lin_schedule_count_ )
+    {// Wrap around to the first slot
+        private->lin_slot_ = 0;
+    }
 
-static void uart_private_rx_isr_soft(uart_module_t *module)
-{
-}
+    if( slot->frame != NULL )
+    {// Send the header
+        if( (*sta & UART_SFR_BITMASK_TRMT) == 0 || private->tx_dma_busy_
+            || ringbuf_count(&private->tx_ring_) > 0 )
+        {// Transmitter still busy, skip the slot and notify the user as for any other ended frame
+            private->lin_frame_ = slot->frame;
+            uart_private_lin_finish(module, UART_LIN_STATUS_E_NO_RESPONSE);
+        }
+        else
+        {
+            private->lin_header_frame_ = slot->frame;
+            WRITE_MASK_SET(*sta, UART_SFR_BITMASK_UTXBRK);
+            *txreg = 0x00;
+            *txreg = UART_LIN_SYNC;
+            *txreg = uart_lin_pid(slot->frame->id);
+        }
+    }
 
-static void uart_private_rx_isr_hybrid(uart_module_t *module)
-{
+    UART_HW_ENABLE_INTERRUPTS();
 }
 
 
@@ -892,6 +3066,7 @@ int uart_init(uart_module_t *module,
               dma_channel_t *rx_dma)
 {
     unsigned int buffer_size = 0;
+    int result;
     
     // Check for a valid module pointer and module number
     if( module == NULL \
@@ -956,6 +3131,8 @@ expecting a number between 1 and 4."
 
     // Set baudrate_ to valid value
     ((uart_private_t *)module->private)->baudrate_ = UART_BAUDRATE_UNKNOWN;
+    ((uart_private_t *)module->private)->baudrate_hz_ = 0;
+    ((uart_private_t *)module->private)->autobaud_callback_ = NULL;
 
 
     
@@ -1024,34 +3201,27 @@ expecting a number between 1 and 4."
         WRITE_MASK_SET(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE), UART_SFR_BITMASK_PDSEL0);
 
         // Select minor mode (bit format)
-        if( (UART_GET_ATTR(module).mode_settings & UART_MINOR_MODE_BITMASK) == UART_MINOR_MODE_9BIT_9N2 )
+        if( (UART_GET_ATTR(module).mode_settings & UART_MINOR_MODE_9BIT_FORMAT_BITMASK) == UART_MINOR_MODE_9BIT_9N2 )
         {// 9-bit mode, no parity, 2 stop bits
             WRITE_MASK_SET(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE), UART_SFR_BITMASK_STSEL);
         }
         // Otherwise 9-bit mode, no parity, 1 stop bit (default)
 
         // Select minor mode (addressing)
-        if( (UART_GET_ATTR(module).mode_settings & UART_MINOR_MODE_BITMASK) == UART_MINOR_MODE_9BIT_ADDR_MASK )
-        {// 9-bit mode, 9th bit marks address byte, mask data according to local_addr_ array
-            // Enable address character detection
-            WRITE_MASK_SET(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxSTA), UART_SFR_BITMASK_ADDEN);
-
-            // Allocate UART_DEF_LOCAL_ADDRESS_MAX number addresses
-            ((uart_private_t *)module->private)->local_addr_ = malloc(sizeof(char)*UART_DEF_LOCAL_ADDR_SIZE);
-            if( ((uart_private_t *)(module->private))->local_addr_ == NULL )
-            {// Allocation failed
-                // Return to an uninitialized state, free memory, and return an error code
-                uart_cleanup(module);
-                return UART_E_ALLOC;
+        if( (UART_GET_ATTR(module).mode_settings & UART_MINOR_MODE_9BIT_ADDR_BITMASK) == UART_MINOR_MODE_9BIT_ADDR_MASK )
+        {// 9-bit mode, 9th bit marks address byte, mask data according to the local_addr_ bitmap
+            // The bitmap starts empty, calloc() cleared it
+            ((uart_private_t *)module->private)->rx_addr_filter_ = true;
+
+            // Only an ISR per character can clear ADDEN in time for the data after an address, so
+            // only the software buffer lets the hardware drop characters, which it does from open
+            if( (UART_GET_ATTR(module).rx_buffer_settings & UART_RX_BUFFER_MODE_BITMASK) == UART_RX_BUFFER_MODE_SOFT )
+            {// RX ISR on every character
+                ((uart_private_t *)module->private)->rx_addr_adden_ = true;
             }
-            
-            ((uart_private_t *)module->private)->local_addr_length_ = 0;
         }
-        else if( (UART_GET_ATTR(module).mode_settings & UART_MINOR_MODE_BITMASK) == UART_MINOR_MODE_9BIT_ADDR_PROM )
-        {// 9-bit mode, 9th bit marks address byte, promiscuous mode
-            // Enable address character detection
-            WRITE_MASK_SET(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxSTA), UART_SFR_BITMASK_ADDEN);
-        }// Otherwise 9-bit mode, treat all characters as data
+        // Otherwise 9-bit mode, pass all characters on, promiscuous mode with address characters
+        // marked by bit 8
             
         break;
     case UART_MAJOR_MODE_IRDA:
@@ -1070,10 +3240,18 @@ expecting a number between 1 and 4."
 
         break;
     case UART_MAJOR_MODE_LIN:
-        // LIN mode
-        /**
-         * @todo Fill in LIN mode code.
-         */
+        // LIN mode, 8N1 characters as in standard mode with the default settings
+        
+        // Frames are followed character by character in the RX ISR, and responses need a TX
+        // buffer which holds a whole response
+        if( (UART_GET_ATTR(module).rx_buffer_settings & UART_RX_BUFFER_MODE_BITMASK) != UART_RX_BUFFER_MODE_HWONLY
+            || (UART_GET_ATTR(module).tx_buffer_settings & UART_TX_BUFFER_MODE_BITMASK) == UART_TX_BUFFER_MODE_HWONLY )
+        {// Unsupported buffer modes
+            uart_cleanup(module);
+            return UART_E_CONFIG;
+        }
+
+        ((uart_private_t *)module->private)->lin_state_ = UART_LIN_STATE_IDLE;
 
         break;
     case UART_MAJOR_MODE_STD:
@@ -1138,19 +3316,13 @@ expecting a number between 1 and 4."
     case UART_TX_BUFFER_MODE_DMA:
         // Use DMA buffer for TX
 
-        // Check for a valid DMA channel
-        if( !dma_is_valid(tx_dma) )
+        // Initialize the DMA channel
+        result = uart_private_init_tx_dma(module, tx_dma);
+        if( result != UART_E_NONE )
         {// DMA channel is invalid
             uart_cleanup(module);
-            return UART_E_INPUT;
+            return result;
         }
-
-        // Copy DMA channel to private object
-        ((uart_private_t *)module->private)->tx_dma_ = tx_dma;
-
-        /**
-         * @todo Set up TX DMA buffer.
-         */
         
         break;
     case UART_TX_BUFFER_MODE_SOFT:
@@ -1194,6 +3366,9 @@ expecting a number between 1 and 4."
             break;
         }
 
+        // Ring buffers must be a power of two long
+        buffer_size = uart_private_ring_size(buffer_size);
+
         // Check what character size to use
         if( (UART_GET_ATTR(module).mode_settings & UART_MAJOR_MODE_BITMASK) == UART_MAJOR_MODE_9BIT )
         {// Using 9-bit mode, allocate a word for each character
@@ -1202,14 +3377,8 @@ expecting a number between 1 and 4."
             ((uart_private_t *)module->private)->tx_buffer_ \
                 = malloc(sizeof(int)*buffer_size);
         }
-        else if( (UART_GET_ATTR(module).mode_settings & UART_MAJOR_MODE_BITMASK) == UART_MAJOR_MODE_LIN )
-        {// Using LIN mode
-            /**
-             * @todo Fill in LIN code for buffer allocation.
-             */
-        }
         else
-        {// Default to using standard (8-bit) mode, allocate a byte for each character
+        {// Default to using standard (8-bit) or LIN mode, allocate a byte for each character
             
             // Allocate TX buffer
             ((uart_private_t *)module->private)->tx_buffer_ \
@@ -1223,30 +3392,23 @@ expecting a number between 1 and 4."
             return UART_E_ALLOC;
         }
         
-        // Set read and write pointers
-        ((uart_private_t *)module->private)->tx_head_ \
-            = ((uart_private_t *)module->private)->tx_buffer_;
-        ((uart_private_t *)module->private)->tx_tail_ \
-            = ((uart_private_t *)module->private)->tx_buffer_;
+        // Set up ring buffer over the software buffer
+        ringbuf_init(&((uart_private_t *)module->private)->tx_ring_,
+                     ((uart_private_t *)module->private)->tx_buffer_,
+                     uart_private_character_size(module)*buffer_size);
                 
         break;
     case UART_TX_BUFFER_MODE_HYBRID:
         // Use both DMA and software buffers
 
-        // Check for a valid DMA channel
-        if( !dma_is_valid(tx_dma) )
+        // Initialize the DMA channel
+        result = uart_private_init_tx_dma(module, tx_dma);
+        if( result != UART_E_NONE )
         {// DMA channel is invalid
             uart_cleanup(module);
-            return UART_E_INPUT;
+            return result;
         }
 
-        // Copy pointer to DMA channel to private object
-        ((uart_private_t *)module->private)->tx_dma_ = tx_dma;
-
-        /**
-         * @todo Set up TX DMA buffer.
-         */
-
         // Determine size of software buffer
         switch( (UART_GET_ATTR(module).tx_buffer_settings & UART_TX_BUFFER_SIZE_BITMASK) )
         {
@@ -1285,6 +3447,9 @@ expecting a number between 1 and 4."
             break;
         }
 
+        // Ring buffers must be a power of two long
+        buffer_size = uart_private_ring_size(buffer_size);
+
         // Check what character size to use
         if( (UART_GET_ATTR(module).mode_settings & UART_MAJOR_MODE_BITMASK) == UART_MAJOR_MODE_9BIT )
         {// Using 9-bit mode, allocate a word for each character
@@ -1293,14 +3458,8 @@ expecting a number between 1 and 4."
             ((uart_private_t *)module->private)->tx_buffer_ \
                 = malloc(sizeof(int)*buffer_size);
         }
-        else if( (UART_GET_ATTR(module).mode_settings & UART_MAJOR_MODE_BITMASK) == UART_MAJOR_MODE_LIN )
-        {// Using LIN mode
-            /**
-             * @todo Fill in LIN code for buffer allocation.
-             */
-        }
         else
-        {// Default to using standard (8-bit) mode, allocate a byte for each character
+        {// Default to using standard (8-bit) or LIN mode, allocate a byte for each character
             
             // Allocate TX buffer
             ((uart_private_t *)module->private)->tx_buffer_ \
@@ -1314,11 +3473,27 @@ expecting a number between 1 and 4."
             return UART_E_ALLOC;
         }
         
-        // Set read and write pointers
-        ((uart_private_t *)module->private)->tx_head_ \
-            = ((uart_private_t *)module->private)->tx_buffer_;
-        ((uart_private_t *)module->private)->tx_tail_ \
-            = ((uart_private_t *)module->private)->tx_buffer_;
+        // Set up ring buffer over the software buffer
+        ringbuf_init(&((uart_private_t *)module->private)->tx_ring_,
+                     ((uart_private_t *)module->private)->tx_buffer_,
+                     uart_private_character_size(module)*buffer_size);
+
+        // Start transfers at the watermark, but no later than when a DMA buffer or the software
+        // buffer, still buffer_size characters long, is full
+        if( tx_dma->buffer_a_size < buffer_size )
+        {
+            buffer_size = tx_dma->buffer_a_size;
+        }
+        if( tx_dma->buffer_b_size < buffer_size )
+        {
+            buffer_size = tx_dma->buffer_b_size;
+        }
+        if( UART_DEF_HYBRID_TX_WATERMARK > 0 && UART_DEF_HYBRID_TX_WATERMARK < buffer_size )
+        {
+            buffer_size = UART_DEF_HYBRID_TX_WATERMARK;
+        }
+        ((uart_private_t *)module->private)->tx_hybrid_watermark_ = uart_private_character_size(module)*buffer_size;
+        ((uart_private_t *)module->private)->tx_hybrid_age_ = 0;
         
         break;
     case UART_TX_BUFFER_MODE_HWONLY:
@@ -1337,19 +3512,13 @@ expecting a number between 1 and 4."
     case UART_RX_BUFFER_MODE_DMA:
         // Use DMA buffer for RX
 
-        // Check for a valid DMA channel
-        if( !dma_is_valid(rx_dma) )
+        // Initialize the DMA channel
+        result = uart_private_init_rx_dma(module, rx_dma);
+        if( result != UART_E_NONE )
         {// DMA channel is invalid
             uart_cleanup(module);
-            return UART_E_INPUT;
+            return result;
         }
-
-        // Copy DMA channel to private object
-        ((uart_private_t *)module->private)->rx_dma_ = rx_dma;
-
-        /**
-         * @todo Set up RX DMA buffer.
-         */
         
         break;
     case UART_RX_BUFFER_MODE_SOFT:
@@ -1393,6 +3562,9 @@ expecting a number between 1 and 4."
             break;
         }
 
+        // Ring buffers must be a power of two long
+        buffer_size = uart_private_ring_size(buffer_size);
+
         // Check what character size to use
         if( (UART_GET_ATTR(module).mode_settings & UART_MAJOR_MODE_BITMASK) == UART_MAJOR_MODE_9BIT )
         {// Using 9-bit mode, allocate a word for each character
@@ -1401,14 +3573,8 @@ expecting a number between 1 and 4."
             ((uart_private_t *)module->private)->rx_buffer_ \
                 = malloc(sizeof(int)*buffer_size);
         }
-        else if( (UART_GET_ATTR(module).mode_settings & UART_MAJOR_MODE_BITMASK) == UART_MAJOR_MODE_LIN )
-        {// Using LIN mode
-            /**
-             * @todo Fill in LIN code for buffer allocation.
-             */
-        }
         else
-        {// Default to using standard (8-bit) mode, allocate a byte for each character
+        {// Default to using standard (8-bit) or LIN mode, allocate a byte for each character
             
             // Allocate RX buffer
             ((uart_private_t *)module->private)->rx_buffer_ \
@@ -1422,30 +3588,23 @@ expecting a number between 1 and 4."
             return UART_E_ALLOC;
         }
         
-        // Set read and write pointers
-        ((uart_private_t *)module->private)->rx_head_ \
-            = ((uart_private_t *)module->private)->rx_buffer_;
-        ((uart_private_t *)module->private)->rx_tail_ \
-            = ((uart_private_t *)module->private)->rx_buffer_;
+        // Set up ring buffer over the software buffer
+        ringbuf_init(&((uart_private_t *)module->private)->rx_ring_,
+                     ((uart_private_t *)module->private)->rx_buffer_,
+                     uart_private_character_size(module)*buffer_size);
                 
         break;
     case UART_RX_BUFFER_MODE_HYBRID:
         // Use both DMA and software buffers
 
-        // Check for a valid DMA channel
-        if( !dma_is_valid(rx_dma) )
+        // Initialize the DMA channel
+        result = uart_private_init_rx_dma(module, rx_dma);
+        if( result != UART_E_NONE )
         {// DMA channel is invalid
             uart_cleanup(module);
-            return UART_E_INPUT;
+            return result;
         }
 
-        // Copy pointer to DMA channel to private object
-        ((uart_private_t *)module->private)->rx_dma_ = rx_dma;
-
-        /**
-         * @todo Set up RX DMA buffer.
-         */
-
         // Determine size of software buffer
         switch( (UART_GET_ATTR(module).rx_buffer_settings & UART_RX_BUFFER_SIZE_BITMASK) )
         {
@@ -1484,6 +3643,9 @@ expecting a number between 1 and 4."
             break;
         }
 
+        // Ring buffers must be a power of two long
+        buffer_size = uart_private_ring_size(buffer_size);
+
         // Check what character size to use
         if( (UART_GET_ATTR(module).mode_settings & UART_MAJOR_MODE_BITMASK) == UART_MAJOR_MODE_9BIT )
         {// Using 9-bit mode, allocate a word for each character
@@ -1492,14 +3654,8 @@ expecting a number between 1 and 4."
             ((uart_private_t *)module->private)->rx_buffer_ \
                 = malloc(sizeof(int)*buffer_size);
         }
-        else if( (UART_GET_ATTR(module).mode_settings & UART_MAJOR_MODE_BITMASK) == UART_MAJOR_MODE_LIN )
-        {// Using LIN mode
-            /**
-             * @todo Fill in LIN code for buffer allocation.
-             */
-        }
         else
-        {// Default to using standard (8-bit) mode, allocate a byte for each character
+        {// Default to using standard (8-bit) or LIN mode, allocate a byte for each character
             
             // Allocate RX buffer
             ((uart_private_t *)module->private)->rx_buffer_ \
@@ -1513,11 +3669,10 @@ expecting a number between 1 and 4."
             return UART_E_ALLOC;
         }
         
-        // Set read and write pointers
-        ((uart_private_t *)module->private)->rx_head_ \
-            = ((uart_private_t *)module->private)->rx_buffer_;
-        ((uart_private_t *)module->private)->rx_tail_ \
-            = ((uart_private_t *)module->private)->rx_buffer_;
+        // Set up ring buffer over the software buffer
+        ringbuf_init(&((uart_private_t *)module->private)->rx_ring_,
+                     ((uart_private_t *)module->private)->rx_buffer_,
+                     uart_private_character_size(module)*buffer_size);
         
         break;
     case UART_RX_BUFFER_MODE_HWONLY:
@@ -1708,28 +3863,72 @@ expecting a number between 1 and 4."
         return UART_E_ASSERT;
     }
 
+    // LIN frames are followed by their own RX ISR
+    if( (UART_GET_ATTR(module).mode_settings & UART_MAJOR_MODE_BITMASK) == UART_MAJOR_MODE_LIN )
+    {// Using LIN mode
+        ((uart_private_t *)module->private)->rx_isr_ = &uart_private_rx_isr_lin;
+    }
+
     return UART_E_NONE;
 }
 
+#if !defined(UART_DEF_MANUAL_BAUDRATE)
 /**
- * @note This function makes use of uart_hw.h defined constants for BRG. Be sure to double check
- * that the Fcy you are using is able to adequetly generate the selected baudrate!
+ * @brief Writes the BRGH and BRG settings of a baud rate to the module.
  *
- * @todo Set BRGH bit according to uart_hw.h.
+ * @details Also cancels any autobaud in progress and records the rate the settings generate.
+ *
+ * @private
+ */
+static void uart_private_write_brg(uart_module_t *module,
+                                   unsigned int brgh,
+                                   unsigned int brg)
+{
+    // Cancel any autobaud in progress
+    WRITE_MASK_CLEAR(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE), UART_SFR_BITMASK_ABAUD);
+
+    if( brgh )
+    {// Set BRGH bit
+        WRITE_MASK_SET(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE), UART_SFR_BITMASK_BRGH);
+    }
+    else
+    {// Clear BRGH bit
+        WRITE_MASK_CLEAR(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE), UART_SFR_BITMASK_BRGH);
+    }
+
+    // Set UxBRG register
+    *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxBRG) = brg;
+
+    // Record the rate actually generated
+    ((uart_private_t *)module->private)->baudrate_hz_ =
+        _FCY_/((brgh ? UART_HW_DIV_BRGH : UART_HW_DIV_BRGL)*((unsigned long)brg + 1));
+}
+#endif
+
+/**
+ * @note The BRGH and BRG values are worked out from _FCY_ at compile time by uart_hw.h, picking
+ * whichever BRGH setting gives the lower error. A rate which Fcy cannot generate within
+ * UART_DEF_BAUD_ERROR_PPM is refused with #UART_E_CONFIG and the module is left unchanged.
  */
 int uart_set_baudrate(uart_module_t *module,
                       uart_baudrate_t baudrate)
 {
+#if !defined(UART_DEF_MANUAL_BAUDRATE)
+    unsigned int brgh;
+    unsigned int brg;
+    unsigned long error;
+#endif
+
     // Check for valid module
     if( !uart_is_valid(module) )
     {// Invalid module
         return UART_E_MODULE;
     }
 
+#if defined(UART_DEF_MANUAL_BAUDRATE) // Set BRGH and BRG manually through uart.def
+
     // Cancel any autobaud in progress
     WRITE_MASK_CLEAR(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE), UART_SFR_BITMASK_ABAUD);
-
-#if defined(UART_DEF_MANUAL_BAUDRATE) // Set BRGH and BRG manually through uart.def
     
 #if defined(UART_DEF_SET_BRGH)
     // Set BRGH bit
@@ -1745,187 +3944,314 @@ int uart_set_baudrate(uart_module_t *module,
 #else // Can't set BRG value
 #error "UART: Can't set baudrate manually, no BRG value defined!"
 #endif
+
+    // The rate is only known to the user
+    ((uart_private_t *)module->private)->baudrate_ = UART_BAUDRATE_UNKNOWN;
+    ((uart_private_t *)module->private)->baudrate_hz_ = 0;
     
 #else // Set BRGH and BRG according to uart_hw.h constants
 
     switch( baudrate )
     {
     case UART_BAUDRATE_1200:
-        // Set baudrate to 1,200bps
-        ((uart_private_t *)module->private)->baudrate_ = baudrate;
-        
-        // Set BRGH bit
-        WRITE_MASK_SET(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE), UART_SFR_BITMASK_BRGH);
+        brgh = UART_HW_BRGH_1200;
+        brg = UART_HW_BRG_1200;
+        error = UART_HW_BAUD_ERROR_FOR(_FCY_, 1200UL);
 
-        // Set UxBRG register to precomputed value
-        *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxBRG) = UART_HW_BRG_1200;
-        
         break;
     case UART_BAUDRATE_2400:
-        // Set baudrate to 2,400bps
-        ((uart_private_t *)module->private)->baudrate_ = baudrate;
-        
-        // Set BRGH bit
-        WRITE_MASK_SET(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE), UART_SFR_BITMASK_BRGH);
+        brgh = UART_HW_BRGH_2400;
+        brg = UART_HW_BRG_2400;
+        error = UART_HW_BAUD_ERROR_FOR(_FCY_, 2400UL);
 
-        // Set UxBRG register to precomputed value
-        *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxBRG) = UART_HW_BRG_2400;
-        
         break;
     case UART_BAUDRATE_4800:
-        // Set baudrate to 4,800bps
-        ((uart_private_t *)module->private)->baudrate_ = baudrate;
+        brgh = UART_HW_BRGH_4800;
+        brg = UART_HW_BRG_4800;
+        error = UART_HW_BAUD_ERROR_FOR(_FCY_, 4800UL);
 
-        // Set BRGH bit
-        WRITE_MASK_SET(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE), UART_SFR_BITMASK_BRGH);
-
-        // Set UxBRG register to precomputed value
-        *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxBRG) = UART_HW_BRG_4800;
-        
         break;
     case UART_BAUDRATE_9600:
-        // Set baudrate to 9,600bps
-        ((uart_private_t *)module->private)->baudrate_ = UART_BAUDRATE_9600;
-
-        // Set BRGH bit
-        WRITE_MASK_SET(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE), UART_SFR_BITMASK_BRGH);
+        brgh = UART_HW_BRGH_9600;
+        brg = UART_HW_BRG_9600;
+        error = UART_HW_BAUD_ERROR_FOR(_FCY_, 9600UL);
 
-        // Set UxBRG register to precomputed value
-        *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxBRG) = UART_HW_BRG_9600;
-        
         break;
     case UART_BAUDRATE_19200:
-        // Set baudrate to 19,200bps
-        ((uart_private_t *)module->private)->baudrate_ = baudrate;
-
-        // Set BRGH bit
-        WRITE_MASK_SET(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE), UART_SFR_BITMASK_BRGH);
+        brgh = UART_HW_BRGH_19200;
+        brg = UART_HW_BRG_19200;
+        error = UART_HW_BAUD_ERROR_FOR(_FCY_, 19200UL);
 
-        // Set UxBRG register to precomputed value
-        *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxBRG) = UART_HW_BRG_19200;
-        
         break;
     case UART_BAUDRATE_38400:
-        // Set baudrate to 38,400bps
-        ((uart_private_t *)module->private)->baudrate_ = baudrate;
-
-        // Set BRGH bit
-        WRITE_MASK_SET(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE), UART_SFR_BITMASK_BRGH);
+        brgh = UART_HW_BRGH_38400;
+        brg = UART_HW_BRG_38400;
+        error = UART_HW_BAUD_ERROR_FOR(_FCY_, 38400UL);
 
-        // Set UxBRG register to precomputed value
-        *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxBRG) = UART_HW_BRG_38400;
-        
         break;
     case UART_BAUDRATE_57600:
-        // Set baudrate to 57,600bps
-        ((uart_private_t *)module->private)->baudrate_ = baudrate;
+        brgh = UART_HW_BRGH_57600;
+        brg = UART_HW_BRG_57600;
+        error = UART_HW_BAUD_ERROR_FOR(_FCY_, 57600UL);
 
-        // Set BRGH bit
-        WRITE_MASK_SET(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE), UART_SFR_BITMASK_BRGH);
-
-        // Set UxBRG register to precomputed value
-        *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxBRG) = UART_HW_BRG_57600;
-        
         break;
     case UART_BAUDRATE_115200:
-        // Set baudrate to 115,200bps
-        ((uart_private_t *)module->private)->baudrate_ = baudrate;
-
-        // Set BRGH bit
-        WRITE_MASK_SET(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE), UART_SFR_BITMASK_BRGH);
+        brgh = UART_HW_BRGH_115200;
+        brg = UART_HW_BRG_115200;
+        error = UART_HW_BAUD_ERROR_FOR(_FCY_, 115200UL);
 
-        // Set UxBRG register to precomputed value
-        *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxBRG) = UART_HW_BRG_115200;
-        
         break;
     case UART_BAUDRATE_230400:
-        // Set baudrate to 230,400bps
-        ((uart_private_t *)module->private)->baudrate_ = baudrate;
-
-        // Set BRGH bit
-        WRITE_MASK_SET(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE), UART_SFR_BITMASK_BRGH);
+        brgh = UART_HW_BRGH_230400;
+        brg = UART_HW_BRG_230400;
+        error = UART_HW_BAUD_ERROR_FOR(_FCY_, 230400UL);
 
-        // Set UxBRG register to precomputed value
-        *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxBRG) = UART_HW_BRG_230400;
-        
         break;
     case UART_BAUDRATE_460800:
-        // Set baudrate to 460,800bps
-        ((uart_private_t *)module->private)->baudrate_ = baudrate;
-
-        // Set BRGH bit
-        WRITE_MASK_SET(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE), UART_SFR_BITMASK_BRGH);
+        brgh = UART_HW_BRGH_460800;
+        brg = UART_HW_BRG_460800;
+        error = UART_HW_BAUD_ERROR_FOR(_FCY_, 460800UL);
 
-        // Set UxBRG register to precomputed value
-        *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxBRG) = UART_HW_BRG_460800;
-        
         break;
     case UART_BAUDRATE_921600:
-        // Set baudrate to 921,600bps
-        ((uart_private_t *)module->private)->baudrate_ = baudrate;
+        brgh = UART_HW_BRGH_921600;
+        brg = UART_HW_BRG_921600;
+        error = UART_HW_BAUD_ERROR_FOR(_FCY_, 921600UL);
 
-        // Set BRGH bit
-        WRITE_MASK_SET(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE), UART_SFR_BITMASK_BRGH);
-
-        // Set UxBRG register to precomputed value
-        *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxBRG) = UART_HW_BRG_921600;
-        
         break;
     case UART_BAUDRATE_1000000:
-        // Set baudrate to 1,000,000bps
-        ((uart_private_t *)module->private)->baudrate_ = baudrate;
-
-        // Set BRGH bit
-        WRITE_MASK_SET(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE), UART_SFR_BITMASK_BRGH);
+        brgh = UART_HW_BRGH_1000000;
+        brg = UART_HW_BRG_1000000;
+        error = UART_HW_BAUD_ERROR_FOR(_FCY_, 1000000UL);
 
-        // Set UxBRG register to precomputed value
-        *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxBRG) = UART_HW_BRG_1000000;
-        
         break;
     case UART_BAUDRATE_1843200:
-        // Set baudrate to 1,843,200bps
-        ((uart_private_t *)module->private)->baudrate_ = baudrate;
-
-        // Set BRGH bit
-        WRITE_MASK_SET(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE), UART_SFR_BITMASK_BRGH);
+        brgh = UART_HW_BRGH_1843200;
+        brg = UART_HW_BRG_1843200;
+        error = UART_HW_BAUD_ERROR_FOR(_FCY_, 1843200UL);
 
-        // Set UxBRG register to precomputed value
-        *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxBRG) = UART_HW_BRG_1843200;
-        
         break;
     case UART_BAUDRATE_2000000:
-        // Set baudrate to 2,000,000bps
-        ((uart_private_t *)module->private)->baudrate_ = baudrate;
-
-        // Set BRGH bit
-        WRITE_MASK_SET(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE), UART_SFR_BITMASK_BRGH);
+        brgh = UART_HW_BRGH_2000000;
+        brg = UART_HW_BRG_2000000;
+        error = UART_HW_BAUD_ERROR_FOR(_FCY_, 2000000UL);
 
-        // Set UxBRG register to precomputed value
-        *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxBRG) = UART_HW_BRG_2000000;
-        
         break;
     case UART_BAUDRATE_3686400:
-        // Set baudrate to 3,686,400bps
-        ((uart_private_t *)module->private)->baudrate_ = baudrate;
+        brgh = UART_HW_BRGH_3686400;
+        brg = UART_HW_BRG_3686400;
+        error = UART_HW_BAUD_ERROR_FOR(_FCY_, 3686400UL);
 
-        // Set BRGH bit
-        WRITE_MASK_SET(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE), UART_SFR_BITMASK_BRGH);
-
-        // Set UxBRG register to precomputed value
-        *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxBRG) = UART_HW_BRG_3686400;
-        
         break;
     default:
         return UART_E_INPUT;
 
-        break;
+        break;
+    }
+
+    if( error > UART_DEF_BAUD_ERROR_PPM )
+    {// Fcy cannot generate this rate closely enough
+        return UART_E_CONFIG;
+    }
+
+    uart_private_write_brg(module, brgh, brg);
+    ((uart_private_t *)module->private)->baudrate_ = baudrate;
+#endif // defined(UART_DEF_MANUAL_BAUDRATE)
+
+    return UART_E_NONE;
+}
+
+/**
+ * @note The BRGH and BRG values are worked out at run time, which costs a few long divisions.
+ * Prefer #uart_set_baudrate() for the standard rates, which are worked out at compile time.
+ */
+int uart_set_baudrate_hz(uart_module_t *module,
+                         unsigned long baudrate)
+{
+#if !defined(UART_DEF_MANUAL_BAUDRATE)
+    unsigned int brgh;
+    unsigned int brg;
+#endif
+
+    // Check for valid module
+    if( !uart_is_valid(module) )
+    {// Invalid module
+        return UART_E_MODULE;
+    }
+
+#if defined(UART_DEF_MANUAL_BAUDRATE)
+    // BRGH and BRG are fixed by uart.def
+    (void)baudrate;
+    return UART_E_CONFIG;
+#else
+    if( uart_hw_brg_calc(_FCY_, baudrate, &brgh, &brg) > UART_DEF_BAUD_ERROR_PPM )
+    {// Fcy cannot generate this rate closely enough
+        return UART_E_CONFIG;
+    }
+
+    uart_private_write_brg(module, brgh, brg);
+    ((uart_private_t *)module->private)->baudrate_ = UART_BAUDRATE_UNKNOWN;
+
+    return UART_E_NONE;
+#endif
+}
+
+int uart_get_baudrate(uart_module_t *module)
+{
+    // Check for valid module
+    if( !uart_is_valid(module) )
+    {// Module is invalid
+        return UART_E_MODULE;
+    }
+
+    // Return current baudrate setting
+    return ((uart_private_t *)module->private)->baudrate_;
+}
+
+unsigned long uart_get_baudrate_hz(uart_module_t *module)
+{
+    // Check for valid module
+    if( !uart_is_valid(module) )
+    {// Module is invalid
+        return 0;
+    }
+
+    // Return the rate actually generated
+    return ((uart_private_t *)module->private)->baudrate_hz_;
+}
+
+int uart_autobaud(uart_module_t *module,
+                  void (*callback)(uart_module_t *module))
+{
+    // Check for valid module
+    if( !uart_is_valid(module) )
+    {// Module is invalid
+        return UART_E_MODULE;
+    }
+
+    // Set baudrate to UART_BAUDRATE_AUTO before the RX ISR may see the result
+    UART_HW_DISABLE_INTERRUPTS();
+    ((uart_private_t *)(module->private))->autobaud_callback_ = callback;
+    ((uart_private_t *)(module->private))->baudrate_ = UART_BAUDRATE_AUTO;
+    ((uart_private_t *)(module->private))->baudrate_hz_ = 0;
+
+    // Start autobaud
+    WRITE_MASK_SET(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE), UART_SFR_BITMASK_ABAUD);
+    UART_HW_ENABLE_INTERRUPTS();
+
+    return UART_E_NONE;
+}
+
+/**
+ * @brief Claims the result of an autobaud once the hardware has measured the sync character.
+ *
+ * @details The hardware clears ABAUD and leaves the measured value in UxBRG, for the BRGH setting
+ * in force. The module is marked #UART_BAUDRATE_UNKNOWN, so that the result is claimed only once,
+ * and the measurement and autobaud callback are handed to #uart_private_autobaud_finish(). Only
+ * register reads and a multiplication are done here, the rest is left to the finish.
+ *
+ * Must be called with interrupts disabled, or from the RX ISR.
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @param[out] callback
+ *             Set to the autobaud callback, which is cleared, if an autobaud has completed.
+ * @return The measured bit time in Fcy cycles, or zero if no autobaud has completed.
+ *
+ * @private
+ */
+static unsigned long uart_private_autobaud_claim(uart_module_t *module,
+                                                 void (**callback)(uart_module_t *module))
+{
+    uart_private_t *private = UART_GET_PRIVATE(module);
+
+    if( private->baudrate_ != UART_BAUDRATE_AUTO
+        || (*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE) & UART_SFR_BITMASK_ABAUD) != 0 )
+    {// No autobaud has completed
+        return 0;
+    }
+
+    private->baudrate_ = UART_BAUDRATE_UNKNOWN;
+    private->baudrate_hz_ = 0;
+    *callback = private->autobaud_callback_;
+    private->autobaud_callback_ = NULL;
+
+    // Each bit lasts div*(BRG+1) Fcy cycles
+    return ((*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE) & UART_SFR_BITMASK_BRGH) != 0
+            ? UART_HW_DIV_BRGH : UART_HW_DIV_BRGL)
+           *((unsigned long)*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxBRG) + 1);
+}
+
+/**
+ * @brief Finishes an autobaud claimed by #uart_private_autobaud_claim().
+ *
+ * @details The measured rate is worked out from Fcy. If it lies within
+ * UART_DEF_AUTOBAUD_SNAP_PPM of a standard rate the module is set to that rate instead, since
+ * the measurement is only accurate to a few percent at high rates. Otherwise the measured rate is
+ * kept and #uart_get_baudrate() returns #UART_BAUDRATE_UNKNOWN. The autobaud callback is then
+ * called. The snap search costs a long division per standard rate, so this is called with
+ * interrupts enabled from #uart_tick().
+ *
+ * @param[in]  module
+ *             The UART module to work on.
+ * @param[in]  cycles
+ *             The measured bit time in Fcy cycles.
+ * @param[in]  callback
+ *             The autobaud callback, or NULL.
+ *
+ * @private
+ */
+static void uart_private_autobaud_finish(uart_module_t *module,
+                                         unsigned long cycles,
+                                         void (*callback)(uart_module_t *module))
+{
+#if defined(_FCY_)
+    unsigned long measured;
+#endif
+#if defined(_FCY_) && !defined(UART_DEF_MANUAL_BAUDRATE)
+    static const unsigned long rates[] = {1200UL, 2400UL, 4800UL, 9600UL, 19200UL, 38400UL,
+                                          57600UL, 115200UL, 230400UL, 460800UL, 921600UL,
+                                          1000000UL, 1843200UL, 2000000UL, 3686400UL};
+    unsigned long difference, best = UART_DEF_AUTOBAUD_SNAP_PPM + 1;
+    unsigned int index, snap = 0;
+#endif
+
+#if defined(_FCY_)
+    // Convert the measured bit time to a rate
+    measured = _FCY_/cycles;
+    UART_GET_PRIVATE(module)->baudrate_hz_ = measured;
+#else
+    (void)cycles;
+#endif
+
+#if defined(_FCY_) && !defined(UART_DEF_MANUAL_BAUDRATE)
+    // Find the closest standard rate
+    for( index = 0; index < sizeof(rates)/sizeof(rates[0]); ++index )
+    {
+        difference = (measured > rates[index] ? measured - rates[index] : rates[index] - measured);
+        difference = (unsigned long)((unsigned long long)difference*1000000ULL/rates[index]);
+        if( difference < best )
+        {
+            best = difference;
+            snap = index + 1;
+        }
+    }
+
+    if( snap != 0 )
+    {// Close enough, use the exact settings of the standard rate if Fcy can generate it
+        uart_set_baudrate(module, (uart_baudrate_t)(UART_BAUDRATE_1200 + snap - 1));
     }
-#endif // defined(UART_DEF_MANUAL_BAUDRATE)
+#endif
 
-    return UART_E_NONE;
+    // Notify user by calling the autobaud callback
+    if( callback != NULL )
+    {
+        callback(module);
+    }
 }
 
-int uart_get_baudrate(uart_module_t *module)
+int uart_add_local_addr(uart_module_t *module,
+                        char addr)
 {
     // Check for valid module
     if( !uart_is_valid(module) )
@@ -1933,11 +4259,21 @@ int uart_get_baudrate(uart_module_t *module)
         return UART_E_MODULE;
     }
 
-    // Return current baudrate setting
-    return ((uart_private_t *)module->private)->baudrate_;
+    // Check for 9-bit mode
+    if( (UART_GET_ATTR(module).mode_settings & UART_MAJOR_MODE_BITMASK) != UART_MAJOR_MODE_9BIT )
+    {// Addresses only exist in 9-bit mode
+        return UART_E_CONFIG;
+    }
+
+    // Set the address bit, the RX path only reads the bitmap so no critical section is needed
+    UART_GET_PRIVATE(module)->local_addr_[(unsigned char)addr/UART_LOCAL_ADDR_BITS]
+        |= 1U << ((unsigned char)addr % UART_LOCAL_ADDR_BITS);
+    
+    return UART_E_NONE;
 }
 
-int uart_autobaud(uart_module_t *module)
+int uart_remove_local_addr(uart_module_t *module,
+                           char addr)
 {
     // Check for valid module
     if( !uart_is_valid(module) )
@@ -1945,43 +4281,107 @@ int uart_autobaud(uart_module_t *module)
         return UART_E_MODULE;
     }
 
-    // Start autobaud
-    WRITE_MASK_SET(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE), UART_SFR_BITMASK_ABAUD);
+    // Check for 9-bit mode
+    if( (UART_GET_ATTR(module).mode_settings & UART_MAJOR_MODE_BITMASK) != UART_MAJOR_MODE_9BIT )
+    {// Addresses only exist in 9-bit mode
+        return UART_E_CONFIG;
+    }
 
-    // Set baudrate to UART_BAUDRATE_AUTO
-    ((uart_private_t *)(module->private))->baudrate_ = UART_BAUDRATE_AUTO;
+    // Clear the address bit, a frame already accepted for it carries on to the next address
+    UART_GET_PRIVATE(module)->local_addr_[(unsigned char)addr/UART_LOCAL_ADDR_BITS]
+        &= ~(1U << ((unsigned char)addr % UART_LOCAL_ADDR_BITS));
 
     return UART_E_NONE;
 }
 
-int uart_add_local_addr(uart_module_t *module,
-                        char addr)
+int uart_lin_set_frames(uart_module_t *module,
+                        uart_lin_frame_t *frames,
+                        unsigned int count)
 {
+    unsigned int index;
+
     // Check for valid module
     if( !uart_is_valid(module) )
     {// Module is invalid
         return UART_E_MODULE;
     }
 
-    /**
-     * @todo Fill in uart_add_local_addr() code.
-     */
-    
+    // Check for LIN mode
+    if( (UART_GET_ATTR(module).mode_settings & UART_MAJOR_MODE_BITMASK) != UART_MAJOR_MODE_LIN )
+    {// Frames only exist in LIN mode
+        return UART_E_CONFIG;
+    }
+
+    // Check the frames
+    if( frames == NULL && count > 0 )
+    {// Invalid frame array
+        return UART_E_INPUT;
+    }
+    for( index = 0; index < count; index++ )
+    {
+        if( frames[index].id > UART_LIN_ID_MASK
+            || frames[index].length == 0 || frames[index].length > UART_LIN_MAX_DATA )
+        {// Invalid frame
+            return UART_E_INPUT;
+        }
+    }
+
+    // Swap the table, ending any frame of the old one in progress
+    UART_HW_DISABLE_INTERRUPTS();
+    if( UART_GET_PRIVATE(module)->lin_state_ != UART_LIN_STATE_IDLE )
+    {// Frame in progress
+        uart_private_lin_finish(module, UART_LIN_STATUS_E_NO_RESPONSE);
+    }
+    UART_GET_PRIVATE(module)->lin_frames_ = frames;
+    UART_GET_PRIVATE(module)->lin_frames_count_ = count;
+    UART_HW_ENABLE_INTERRUPTS();
+
     return UART_E_NONE;
 }
 
-int uart_remove_local_addr(uart_module_t *module,
-                           char addr)
+int uart_lin_set_schedule(uart_module_t *module,
+                          const uart_lin_slot_t *schedule,
+                          unsigned int count)
 {
+    unsigned int index;
+
     // Check for valid module
     if( !uart_is_valid(module) )
     {// Module is invalid
         return UART_E_MODULE;
     }
 
-    /**
-     * @todo Fill in uart_remove_local_addr() code.
-     */
+    // Check for LIN master mode
+    if( (UART_GET_ATTR(module).mode_settings & UART_MAJOR_MODE_BITMASK) != UART_MAJOR_MODE_LIN
+        || (UART_GET_ATTR(module).mode_settings & UART_MINOR_MODE_BITMASK) != UART_MINOR_MODE_LIN_MASTER )
+    {// Only a master sends headers
+        return UART_E_CONFIG;
+    }
+
+    // Check the slots
+    if( schedule == NULL && count > 0 )
+    {// Invalid slot array
+        return UART_E_INPUT;
+    }
+    for( index = 0; index < count; index++ )
+    {
+        if( schedule[index].ticks == 0
+            || (schedule[index].frame != NULL
+                && (schedule[index].frame->id > UART_LIN_ID_MASK
+                    || schedule[index].frame->length == 0
+                    || schedule[index].frame->length > UART_LIN_MAX_DATA)) )
+        {// Invalid slot
+            return UART_E_INPUT;
+        }
+    }
+
+    // Start the first slot on the next tick
+    UART_HW_DISABLE_INTERRUPTS();
+    UART_GET_PRIVATE(module)->lin_schedule_ = schedule;
+    UART_GET_PRIVATE(module)->lin_schedule_count_ = count;
+    UART_GET_PRIVATE(module)->lin_slot_ = 0;
+    UART_GET_PRIVATE(module)->lin_slot_ticks_ = 1;
+    UART_HW_ENABLE_INTERRUPTS();
 
     return UART_E_NONE;
 }
@@ -2006,6 +4406,13 @@ int uart_open(uart_module_t *module,
     if( direction == UART_DIRECTION_RX || direction == UART_DIRECTION_TXRX )
     {// Set up RX functionality
         
+        // Start outside any addressed frame, with the hardware dropping characters if it may
+        UART_GET_PRIVATE(module)->rx_addressed_ = false;
+        if( UART_GET_PRIVATE(module)->rx_addr_adden_ )
+        {// Wait for an address character
+            WRITE_MASK_SET(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxSTA), UART_SFR_BITMASK_ADDEN);
+        }
+
         // Enable UART module (RX)
         WRITE_MASK_SET(*(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE), UART_SFR_BITMASK_UARTEN);
 
@@ -2014,13 +4421,21 @@ int uart_open(uart_module_t *module,
         {
         case UART_RX_BUFFER_MODE_HWONLY:
             // Set up interrupts
+            if( (UART_GET_ATTR(module).mode_settings & UART_MAJOR_MODE_BITMASK) == UART_MAJOR_MODE_LIN )
+            {// LIN frames are followed character by character
+                UART_CLEAR_RX_FLAG(module);
+                UART_ENABLE_RX_INTERRUPT(module);
+            }
             break;
         case UART_RX_BUFFER_MODE_DMA:
-            // Enable DMA channel
+            // Enable DMA channel on an empty buffer
+            uart_private_rx_dma_start(module);
             // Set up interrupts
             break;
         case UART_RX_BUFFER_MODE_SOFT:
-            // Set up interrupts
+            // Interrupt on every character received
+            UART_CLEAR_RX_FLAG(module);
+            UART_ENABLE_RX_INTERRUPT(module);
             break;
         case UART_RX_BUFFER_MODE_HYBRID:
             // Enable DMA channel
@@ -2049,14 +4464,15 @@ int uart_open(uart_module_t *module,
             // Enable interrupts
             break;
         case UART_TX_BUFFER_MODE_DMA:
-            // Enable DMA channel
+            // The DMA channel is enabled by each transfer
             // Enable interrupts
             break;
         case UART_TX_BUFFER_MODE_SOFT:
-            // Enable interrupts
+            // The FIFO is empty, so the first write must enter the TX ISR as soon as it enables it
+            UART_SET_TX_FLAG(module);
             break;
         case UART_TX_BUFFER_MODE_HYBRID:
-            // Enable DMA channel
+            // The DMA channel is enabled by each transfer
             // Enable interrupts
             break;
         default:
@@ -2085,6 +4501,80 @@ int uart_write(uart_module_t *module,
     return ((uart_private_t *)module->private)->write_(module, buffer, length);
 }
 
+int uart_writev(uart_module_t *module,
+                const struct uart_iovec *iov,
+                unsigned int count)
+{
+    unsigned int length = 0;
+    unsigned int capacity;
+    unsigned int segment;
+    int result;
+
+    // Check for valid module
+    if( !uart_is_valid(module) )
+    {// Module is invalid
+        return UART_E_MODULE;
+    }
+
+    // Check if TX enabled
+    if( !uart_is_open(module, UART_DIRECTION_TX) )
+    {// TX is closed
+        return UART_E_CLOSED;
+    }
+
+    // Only standard characters are supported
+    if( (UART_GET_ATTR(module).mode_settings & UART_MAJOR_MODE_BITMASK) == UART_MAJOR_MODE_9BIT
+        || (UART_GET_ATTR(module).mode_settings & UART_MAJOR_MODE_BITMASK) == UART_MAJOR_MODE_LIN )
+    {// Not in standard (8-bit) mode
+        return UART_E_CONFIG;
+    }
+
+    // Total the frame, which must fit in the buffer it is written to. The total never exceeds the
+    // capacity, so it cannot wrap
+    if( iov == NULL && count > 0 )
+    {// Invalid segment array
+        return UART_E_INPUT;
+    }
+    capacity = uart_private_writev_capacity(module);
+    for( segment = 0; segment < count; segment++ )
+    {
+        if( iov[segment].base == NULL && iov[segment].length > 0 )
+        {// Invalid segment
+            return UART_E_INPUT;
+        }
+        if( iov[segment].length > capacity - length )
+        {// Frame can never fit
+            return UART_E_INPUT;
+        }
+        length += iov[segment].length;
+    }
+
+    // Queue the whole frame without letting another writer in
+    UART_HW_DISABLE_INTERRUPTS();
+    if( UART_GET_PRIVATE(module)->tx_writing_ )
+    {// Called from an ISR which interrupted a write
+        UART_HW_ENABLE_INTERRUPTS();
+        return UART_E_BUSY;
+    }
+    switch( (UART_GET_ATTR(module).tx_buffer_settings & UART_TX_BUFFER_MODE_BITMASK) )
+    {
+    case UART_TX_BUFFER_MODE_DMA:
+        result = uart_private_writev_8bit_dma(module, iov, count, length);
+        break;
+    case UART_TX_BUFFER_MODE_SOFT:
+    case UART_TX_BUFFER_MODE_HYBRID:
+        result = uart_private_writev_8bit_soft(module, iov, count, length);
+        break;
+    case UART_TX_BUFFER_MODE_HWONLY:
+    default:
+        result = uart_private_writev_8bit_hwonly(module, iov, count, length);
+        break;
+    }
+    UART_HW_ENABLE_INTERRUPTS();
+
+    return result;
+}
+
 int uart_read(uart_module_t *module,
               void *buffer,
               unsigned int length)
@@ -2099,6 +4589,260 @@ int uart_read(uart_module_t *module,
     return ((uart_private_t *)module->private)->read_(module, buffer, length);
 }
 
+int uart_rx_acquire(uart_module_t *module,
+                    const void **ptr,
+                    unsigned int *len)
+{
+    uart_private_t *private;
+    unsigned int index;
+    unsigned int count = 0;
+
+    // Check for valid module
+    if( !uart_is_valid(module) )
+    {// Module is invalid
+        return UART_E_MODULE;
+    }
+
+    // Check if RX enabled
+    if( !uart_is_open(module, UART_DIRECTION_RX) )
+    {// RX is closed
+        return UART_E_CLOSED;
+    }
+
+    if( ptr == NULL || len == NULL )
+    {// Invalid output pointers
+        return UART_E_OUTPUT;
+    }
+
+    private = UART_GET_PRIVATE(module);
+
+    switch( (UART_GET_ATTR(module).rx_buffer_settings & UART_RX_BUFFER_MODE_BITMASK) )
+    {
+    case UART_RX_BUFFER_MODE_DMA:
+        if( private->rx_addr_filter_ )
+        {// Characters for other devices are only dropped by uart_read()
+            return UART_E_CONFIG;
+        }
+
+        // Span the received words up to the first empty one or the end of the buffer
+        index = private->rx_dma_head_;
+        *ptr = (const void *)&private->rx_dma_->buffer_a[index];
+        while( index < private->rx_dma_->buffer_a_size
+               && private->rx_dma_->buffer_a[index] != UART_DMA_RX_EMPTY )
+        {
+            count++;
+            index++;
+        }
+        *len = count;
+        return sizeof(int);
+
+    case UART_RX_BUFFER_MODE_SOFT:
+        // Span the ring buffer up to its end
+        *len = ringbuf_peek(&private->rx_ring_, ptr) / uart_private_character_size(module);
+        return uart_private_character_size(module);
+
+    default:
+        // No buffer to lend out
+        return UART_E_CONFIG;
+    }
+}
+
+int uart_rx_release(uart_module_t *module,
+                    unsigned int n)
+{
+    uart_private_t *private;
+    volatile unsigned int *dma_buffer;
+    unsigned int index;
+    unsigned int count;
+
+    // Check for valid module
+    if( !uart_is_valid(module) )
+    {// Module is invalid
+        return UART_E_MODULE;
+    }
+
+    // Check if RX enabled
+    if( !uart_is_open(module, UART_DIRECTION_RX) )
+    {// RX is closed
+        return UART_E_CLOSED;
+    }
+
+    private = UART_GET_PRIVATE(module);
+
+    switch( (UART_GET_ATTR(module).rx_buffer_settings & UART_RX_BUFFER_MODE_BITMASK) )
+    {
+    case UART_RX_BUFFER_MODE_DMA:
+        dma_buffer = private->rx_dma_->buffer_a;
+
+        // Check the characters were all received before handing any back
+        index = private->rx_dma_head_;
+        for( count = 0; count < n; count++ )
+        {
+            if( dma_buffer[index] == UART_DMA_RX_EMPTY )
+            {// Fewer characters waiting
+                return UART_E_INPUT;
+            }
+            index++;
+            if( index >= private->rx_dma_->buffer_a_size )
+            {// Wrap around
+                index = 0;
+            }
+        }
+
+        // Hand the words back to the channel
+        index = private->rx_dma_head_;
+        for( count = 0; count < n; count++ )
+        {
+            dma_buffer[index] = UART_DMA_RX_EMPTY;
+            index++;
+            if( index >= private->rx_dma_->buffer_a_size )
+            {// Wrap around
+                index = 0;
+            }
+        }
+        private->rx_dma_head_ = index;
+        return UART_E_NONE;
+
+    case UART_RX_BUFFER_MODE_SOFT:
+        if( !ringbuf_skip(&private->rx_ring_, n*uart_private_character_size(module)) )
+        {// Fewer characters waiting
+            return UART_E_INPUT;
+        }
+        return UART_E_NONE;
+
+    default:
+        // No buffer to lend out
+        return UART_E_CONFIG;
+    }
+}
+
+int uart_flush(uart_module_t *module,
+               uart_direction_t direction)
+{
+    int result = UART_E_NONE;
+
+    // Check for valid module
+    if( !uart_is_valid(module) )
+    {// Module is invalid
+        return UART_E_MODULE;
+    }
+
+    if( direction == UART_DIRECTION_TX || direction == UART_DIRECTION_TXRX )
+    {// Flush TX buffers
+        result = ((uart_private_t *)module->private)->flush_tx_(module);
+        if( result != UART_E_NONE )
+        {// Flush failed
+            return result;
+        }
+    }
+
+    if( direction == UART_DIRECTION_RX || direction == UART_DIRECTION_TXRX )
+    {// Flush RX buffers
+        result = ((uart_private_t *)module->private)->flush_rx_(module);
+    }
+
+    return result;
+}
+
+void uart_tick(uart_module_t *module)
+{
+    uart_private_t *private;
+    void (*callback)(uart_module_t *module);
+    unsigned long cycles;
+
+    // Check for valid module
+    if( !uart_is_valid(module) )
+    {// Module is invalid
+        return;
+    }
+
+    private = UART_GET_PRIVATE(module);
+
+    // Check if an autobaud completed without an RX interrupt reaching uart_rx_isr()
+    if( private->baudrate_ == UART_BAUDRATE_AUTO )
+    {// Autobaud in progress, only claiming its result holds off interrupts
+        UART_HW_DISABLE_INTERRUPTS();
+        cycles = uart_private_autobaud_claim(module, &callback);
+        UART_HW_ENABLE_INTERRUPTS();
+        if( cycles != 0 )
+        {// Autobaud completed
+            uart_private_autobaud_finish(module, cycles, callback);
+        }
+    }
+
+    // Check if TX enabled
+    if( uart_is_open(module, UART_DIRECTION_TX)
+        && (UART_GET_ATTR(module).tx_buffer_settings & UART_TX_BUFFER_MODE_BITMASK) == UART_TX_BUFFER_MODE_HYBRID )
+    {// Hybrid TX is open
+        if( private->tx_dma_busy_ || ringbuf_count(&private->tx_ring_) == 0 )
+        {// Characters are not waiting on an idle channel
+            private->tx_hybrid_age_ = 0;
+        }
+        else if( ++private->tx_hybrid_age_ >= UART_DEF_HYBRID_TX_DEADLINE )
+        {// Deadline passed below the watermark
+            UART_HW_DISABLE_INTERRUPTS();
+            uart_private_tx_hybrid_feed(module);
+            UART_HW_ENABLE_INTERRUPTS();
+        }
+    }
+
+    // Check if LIN is running
+    if( uart_is_open(module, UART_DIRECTION_RX)
+        && (UART_GET_ATTR(module).mode_settings & UART_MAJOR_MODE_BITMASK) == UART_MAJOR_MODE_LIN )
+    {// LIN frames are open
+        uart_private_tick_lin(module);
+    }
+
+    // Check if RX enabled
+    if( uart_is_open(module, UART_DIRECTION_RX) )
+    {// RX is open
+        switch( (UART_GET_ATTR(module).rx_buffer_settings & UART_RX_BUFFER_MODE_BITMASK) )
+        {
+        case UART_RX_BUFFER_MODE_DMA:
+            // Announce the tail of a block once the line goes idle
+            uart_private_tick_rx_dma(module);
+            break;
+        default:
+            // Nothing to do
+            break;
+        }
+    }
+}
+
+void uart_tx_isr(uart_module_t *module)
+{
+    // Check for valid module
+    if( !uart_is_valid(module) )
+    {// Module is invalid
+        return;
+    }
+
+    // Call correct TX ISR
+    ((uart_private_t *)module->private)->tx_isr_(module);
+}
+
+void uart_rx_isr(uart_module_t *module)
+{
+    void (*callback)(uart_module_t *module);
+    unsigned long cycles;
+
+    // Check for valid module
+    if( !uart_is_valid(module) )
+    {// Module is invalid
+        return;
+    }
+
+    // Finish an autobaud, the hardware raises the RX interrupt once the sync character is measured
+    cycles = uart_private_autobaud_claim(module, &callback);
+    if( cycles != 0 )
+    {// Autobaud completed
+        uart_private_autobaud_finish(module, cycles, callback);
+    }
+
+    // Call correct RX ISR
+    ((uart_private_t *)module->private)->rx_isr_(module);
+}
+
 int uart_close(uart_module_t *module,
                uart_direction_t direction)
 {
@@ -2127,13 +4871,16 @@ int uart_close(uart_module_t *module,
         {
         case UART_RX_BUFFER_MODE_HWONLY:
             // Disable interrupts
+            UART_DISABLE_RX_INTERRUPT(module);
             break;
         case UART_RX_BUFFER_MODE_DMA:
-            // Disable DMA channel
+            // Disable DMA channel, any characters left unread are dropped on the next open
+            dma_disable(UART_GET_PRIVATE(module)->rx_dma_);
             // Disable interrupts
             break;
         case UART_RX_BUFFER_MODE_SOFT:
             // Disable interrupts
+            UART_DISABLE_RX_INTERRUPT(module);
             break;
         case UART_RX_BUFFER_MODE_HYBRID:
             // Disable DMA channel
@@ -2162,14 +4909,21 @@ int uart_close(uart_module_t *module,
             // Disable interrupts
             break;
         case UART_TX_BUFFER_MODE_DMA:
-            // Disable DMA channel
+            // Disable DMA channel, dropping any transfer in progress
+            dma_disable(UART_GET_PRIVATE(module)->tx_dma_);
+            UART_GET_PRIVATE(module)->tx_dma_busy_ = false;
+            UART_GET_PRIVATE(module)->tx_dma_count_ = 0;
             // Disable interrupts
             break;
         case UART_TX_BUFFER_MODE_SOFT:
-            // Disable interrupts
+            // Disable interrupts, any characters left unsent stay in the ring buffer
+            UART_DISABLE_TX_INTERRUPT(module);
             break;
         case UART_TX_BUFFER_MODE_HYBRID:
-            // Disable DMA channel
+            // Disable DMA channel, any characters left unsent stay in the software buffer
+            dma_disable(UART_GET_PRIVATE(module)->tx_dma_);
+            UART_GET_PRIVATE(module)->tx_dma_busy_ = false;
+            UART_GET_PRIVATE(module)->tx_dma_count_ = 0;
             // Disable interrupts
             break;
         default:
@@ -2190,22 +4944,26 @@ void uart_cleanup(uart_module_t *module)
     // Close the module
     uart_close(module, UART_DIRECTION_TXRX);
 
-    // Deal with DMA channels
-    /**
-     * @todo Deal with DMA channels.
-     */
+    // Return the DMA channels to their uninitialized state
+    if( ((uart_private_t *)(module->private))->tx_dma_ != NULL )
+    {// TX DMA channel was initialized
+        dma_cleanup( ((uart_private_t *)(module->private))->tx_dma_ );
+    }
+    if( ((uart_private_t *)(module->private))->rx_dma_ != NULL )
+    {// RX DMA channel was initialized
+        dma_cleanup( ((uart_private_t *)(module->private))->rx_dma_ );
+    }
+
+    // Set all SFRs to default values, while the base address is still held in the private object
+    *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE) = UART_SFR_DEFAULT_UxMODE;
+    *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxSTA)  = UART_SFR_DEFAULT_UxSTA;
+    *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxBRG)  = UART_SFR_DEFAULT_UxBRG;
 
     // Free all allocated memory
     free( ((uart_private_t *)(module->private))->tx_buffer_ );
     free( ((uart_private_t *)(module->private))->rx_buffer_ );
-    free( ((uart_private_t *)(module->private))->local_addr_ );
     free( module->private );
     module->private = NULL;
-    
-    // Set all SFRs to default values
-    *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxMODE) = UART_SFR_DEFAULT_UxMODE;
-    *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxSTA)  = UART_SFR_DEFAULT_UxSTA;
-    *(UART_GET_BASE_ADDRESS(module) + UART_SFR_OFFSET_UxBRG)  = UART_SFR_DEFAULT_UxBRG;
 }
 
 
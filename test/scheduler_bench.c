@@ -0,0 +1,455 @@
+/* -*- mode: C; tab-width: 4 -*- */
+/**
+ * @file scheduler_bench.c
+ *
+ * @brief Host benchmark for the scheduler.
+ *
+ * @details The scheduler source is included directly so that its private functions can be timed.
+ * The schedule is made long enough to measure dispatch latency with 256 queued processes. Time is
+ * the host build's simulated Timer1, so the tick ISR is timed by counting the timer forward. Build
+ * and run from the repository root with:
+ *
+ * <tt>gcc -std=gnu99 -O2 -DSCHEDULER_HOST -o scheduler_bench test/scheduler_bench.c && ./scheduler_bench</tt>
+ *
+ * @date 10/15/2026
+ * @carlnumber FIRM-0004
+ * @version 0.3.0
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#define SCHEDULE_LIST_LENGTH 256 /**< Room for the deepest dispatch latency measurement */
+
+#include "../source/scheduler_xc16.c"
+
+#define BENCH_ITERATIONS 1000000UL /**< Number of timed operations per measurement */
+#define BENCH_DEPTH_ITERATIONS 100000UL /**< Number of timed dispatches per queue depth */
+#define BENCH_TICKS 100000UL /**< Number of timed ticks per queue depth */
+#define BENCH_MAX_DELAY (4*SCHEDULE_WHEEL_LENGTH) /**< Longest delay of a delayed process, in ticks */
+
+
+/**
+ * Return a monotonic timestamp in nanoseconds.
+ */
+static unsigned long long bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (unsigned long long)ts.tv_sec*1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * The process run by every benchmark.
+ */
+static void bench_process(void *params)
+{
+    ++*(volatile unsigned long *)params;
+}
+
+
+/**
+ * Return a pseudo-random priority between -31 and 0.
+ */
+static int bench_priority(void)
+{
+    static unsigned long seed = 12345;
+
+    seed = seed*1103515245UL + 12345UL;
+
+    return -(int)((seed >> 16) & 0x1F);
+}
+
+/**
+ * Return a pseudo-random delay between 1 and BENCH_MAX_DELAY ticks.
+ */
+static int bench_delay(void)
+{
+    static unsigned long seed = 54321;
+
+    seed = seed*1103515245UL + 12345UL;
+
+    return 1 + (int)((seed >> 16) % BENCH_MAX_DELAY);
+}
+
+/**
+ * A delayed process which schedules itself again with a new delay, keeping the timing wheel at the
+ * same depth.
+ */
+static void bench_delayed_process(void *params)
+{
+    ++*(volatile unsigned long *)params;
+    schedule(&bench_delayed_process, bench_delay(), params);
+}
+
+
+/* Reference implementation
+ * This is the malloc() based list, with its reverse bubble sort, which the static process pool and
+ * the schedule heap replaced. It is kept here only so the two can be compared.
+ */
+typedef struct
+{
+    void (*func)(void *params);
+    void *params;
+    int priority;
+} malloc_process_t;
+
+static malloc_process_t *malloc_list[SCHEDULE_LIST_LENGTH];
+
+static bool malloc_schedule(void (*func)(void *), int priority, void *params)
+{
+    unsigned int iterator;
+
+    for( iterator = 0; iterator < SCHEDULE_LIST_LENGTH; ++iterator )
+    {
+        if( malloc_list[iterator] == NULL )
+        {
+            malloc_list[iterator] = malloc(sizeof(malloc_process_t));
+            malloc_list[iterator]->func = func;
+            malloc_list[iterator]->params = params;
+            malloc_list[iterator]->priority = priority;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void malloc_prioritize(void)
+{
+    unsigned int iterator;
+    malloc_process_t *tmp_ptr;
+    bool swap;
+
+    if( malloc_list[0] == NULL || malloc_list[1] == NULL )
+    {
+        return;
+    }
+
+    do
+    {
+        swap = false;
+        for( iterator = SCHEDULE_LIST_LENGTH-1; iterator > 0; --iterator )
+        {
+            if( malloc_list[iterator] != NULL
+                && malloc_list[iterator]->priority < malloc_list[iterator-1]->priority )
+            {
+                tmp_ptr = malloc_list[iterator];
+                malloc_list[iterator] = malloc_list[iterator-1];
+                malloc_list[iterator-1] = tmp_ptr;
+                swap = true;
+            }
+        }
+    } while(swap);
+}
+
+static bool malloc_dispatch(void)
+{
+    malloc_process_t *current_process;
+    unsigned int iterator;
+
+    malloc_prioritize();
+
+    current_process = malloc_list[0];
+
+    if( current_process == NULL )
+    {
+        return false;
+    }
+
+    for( iterator = 0; iterator < SCHEDULE_LIST_LENGTH-1; ++iterator )
+    {
+        malloc_list[iterator] = malloc_list[iterator+1];
+    }
+    malloc_list[iterator] = NULL;
+
+    current_process->func(current_process->params);
+    free(current_process);
+
+    return true;
+}
+
+
+/* Benchmarks */
+
+/**
+ * Time a schedule()/dispatch() round trip through the static process pool.
+ */
+static double bench_pool_dispatch(void)
+{
+    volatile unsigned long runs = 0;
+    unsigned long long start;
+    unsigned long iterator;
+
+    start = bench_now_ns();
+    for( iterator = 0; iterator < BENCH_ITERATIONS; ++iterator )
+    {
+        schedule(&bench_process, 0, (void *)&runs);
+        dispatch();
+    }
+
+    return (double)(bench_now_ns() - start) / BENCH_ITERATIONS;
+}
+
+/**
+ * Time the same round trip using the malloc() based reference.
+ */
+static double bench_malloc_dispatch(void)
+{
+    volatile unsigned long runs = 0;
+    unsigned long long start;
+    unsigned long iterator;
+
+    start = bench_now_ns();
+    for( iterator = 0; iterator < BENCH_ITERATIONS; ++iterator )
+    {
+        malloc_schedule(&bench_process, 0, (void *)&runs);
+        malloc_dispatch();
+    }
+
+    return (double)(bench_now_ns() - start) / BENCH_ITERATIONS;
+}
+
+/**
+ * Time only the process allocation and release through the static process pool.
+ */
+static double bench_pool_alloc(void)
+{
+    process_t *process;
+    unsigned long long start;
+    unsigned long iterator;
+
+    start = bench_now_ns();
+    for( iterator = 0; iterator < BENCH_ITERATIONS; ++iterator )
+    {
+        process = process_alloc();
+        __asm__ volatile ("" : : "r"(process) : "memory");
+        process_free(process);
+    }
+
+    return (double)(bench_now_ns() - start) / BENCH_ITERATIONS;
+}
+
+/**
+ * Time only the process allocation and release through malloc()/free().
+ */
+static double bench_malloc_alloc(void)
+{
+    process_t *process;
+    unsigned long long start;
+    unsigned long iterator;
+
+    start = bench_now_ns();
+    for( iterator = 0; iterator < BENCH_ITERATIONS; ++iterator )
+    {
+        process = malloc(sizeof(process_t));
+        __asm__ volatile ("" : : "r"(process) : "memory");
+        free(process);
+    }
+
+    return (double)(bench_now_ns() - start) / BENCH_ITERATIONS;
+}
+
+
+/**
+ * Time a dispatch, plus the schedule() which replaces the dispatched process, with @em depth
+ * processes queued in the schedule heap.
+ */
+static double bench_heap_depth(unsigned int depth)
+{
+    volatile unsigned long runs = 0;
+    unsigned long long start, elapsed;
+    unsigned long iterator;
+
+    while( schedule_length < depth )
+    {
+        schedule(&bench_process, bench_priority(), (void *)&runs);
+    }
+
+    start = bench_now_ns();
+    for( iterator = 0; iterator < BENCH_DEPTH_ITERATIONS; ++iterator )
+    {
+        dispatch();
+        schedule(&bench_process, bench_priority(), (void *)&runs);
+    }
+
+    elapsed = bench_now_ns() - start;
+
+    while( dispatch() );
+
+    return (double)elapsed / BENCH_DEPTH_ITERATIONS;
+}
+
+/**
+ * Time the same dispatch and schedule() pair using the bubble sorted reference list.
+ */
+static double bench_list_depth(unsigned int depth)
+{
+    volatile unsigned long runs = 0;
+    unsigned long long start, elapsed;
+    unsigned long iterator;
+    unsigned int queued;
+
+    for( queued = 0; queued < depth; ++queued )
+    {
+        malloc_schedule(&bench_process, bench_priority(), (void *)&runs);
+    }
+
+    start = bench_now_ns();
+    for( iterator = 0; iterator < BENCH_DEPTH_ITERATIONS; ++iterator )
+    {
+        malloc_dispatch();
+        malloc_schedule(&bench_process, bench_priority(), (void *)&runs);
+    }
+
+    elapsed = bench_now_ns() - start;
+
+    while( malloc_dispatch() );
+
+    return (double)elapsed / BENCH_DEPTH_ITERATIONS;
+}
+
+/**
+ * Time schedule() and dispatch() in bursts: @em depth processes are scheduled, then all of them are
+ * dispatched.
+ *
+ * @return      Processes per second through the scheduler.
+ */
+static double bench_throughput(unsigned int depth)
+{
+    volatile unsigned long runs = 0;
+    unsigned long long start, elapsed;
+    unsigned long rounds = BENCH_DEPTH_ITERATIONS / depth;
+    unsigned long round;
+    unsigned int queued;
+
+    start = bench_now_ns();
+    for( round = 0; round < rounds; ++round )
+    {
+        for( queued = 0; queued < depth; ++queued )
+        {
+            schedule(&bench_process, bench_priority(), (void *)&runs);
+        }
+        while( dispatch() );
+    }
+
+    elapsed = bench_now_ns() - start;
+
+    return (double)(rounds*depth) * 1e9 / elapsed;
+}
+
+
+/**
+ * Time the tick ISR alone, and the tick ISR together with the main loop moving the processes which
+ * expired on that tick from the timing wheel to the schedule, with @em depth delayed processes in
+ * the wheel. Expired processes are run and delayed again outside the timed part.
+ *
+ * @param[in]  depth
+ *             Number of delayed processes kept in the timing wheel.
+ *
+ * @param[out] isr
+ *             Nanoseconds per tick ISR.
+ *
+ * @param[out] expire
+ *             Nanoseconds per tick ISR and wheel expiry.
+ */
+static void bench_tick_depth(unsigned int depth, double *isr, double *expire)
+{
+    volatile unsigned long runs = 0;
+    unsigned long long start, elapsed = 0, overhead;
+    unsigned long iterator;
+    unsigned int queued;
+
+    for( queued = 0; queued < depth; ++queued )
+    {
+        schedule(&bench_delayed_process, bench_delay(), (void *)&runs);
+    }
+
+    // Cost of a pair of timestamps, taken off each timed tick below
+    start = bench_now_ns();
+    for( iterator = 0; iterator < BENCH_TICKS; ++iterator )
+    {
+        overhead = bench_now_ns();
+        __asm__ volatile ("" : : "r"(overhead) : "memory");
+    }
+    overhead = (bench_now_ns() - start) / BENCH_TICKS;
+
+    // The ISR does constant work, whatever is queued
+    start = bench_now_ns();
+    for( iterator = 0; iterator < BENCH_TICKS; ++iterator )
+    {
+        scheduler_hw_host_advance(TICK_CYCLES);
+    }
+    *isr = (double)(bench_now_ns() - start) / BENCH_TICKS;
+    while( dispatch() );
+
+    for( iterator = 0; iterator < BENCH_TICKS; ++iterator )
+    {
+        start = bench_now_ns();
+        scheduler_hw_host_advance(TICK_CYCLES);
+        advance_wheel();
+        elapsed += bench_now_ns() - start;
+
+        while( dispatch() );
+    }
+    *expire = (double)elapsed / BENCH_TICKS - overhead;
+
+    // Cancel the delayed processes
+    for( queued = 0; queued < SCHEDULE_WHEEL_LENGTH; ++queued )
+    {
+        while( schedule_wheel[queued] != NULL )
+        {
+            unschedule(process_handle(schedule_wheel[queued]));
+        }
+    }
+}
+
+
+int main(void)
+{
+    static const unsigned int depths[] = {16, 64, 256};
+    // Delayed processes schedule themselves again while they still hold their place in the pool
+    static const unsigned int tick_depths[] = {16, 64, 192};
+    unsigned int iterator;
+    double isr, expire;
+
+    printf("Scheduler benchmark, SCHEDULE_LIST_LENGTH = %u\n", SCHEDULE_LIST_LENGTH);
+    printf("  %-28s %8s %8s\n", "", "pool", "malloc");
+    printf("  %-28s %8.1f %8.1f ns\n", "process alloc + release",
+           bench_pool_alloc(), bench_malloc_alloc());
+    printf("  %-28s %8.1f %8.1f ns\n", "schedule + dispatch",
+           bench_pool_dispatch(), bench_malloc_dispatch());
+
+    printf("\nDispatch latency by queue depth\n");
+    printf("  %-28s %8s %8s\n", "", "heap", "list");
+    for( iterator = 0; iterator < sizeof(depths)/sizeof(depths[0]); ++iterator )
+    {
+        printf("  %-28u %8.1f %8.1f ns\n", depths[iterator],
+               bench_heap_depth(depths[iterator]), bench_list_depth(depths[iterator]));
+    }
+
+    printf("\nThroughput by queue depth, schedule then dispatch in bursts\n");
+    for( iterator = 0; iterator < sizeof(depths)/sizeof(depths[0]); ++iterator )
+    {
+        printf("  %-28u %8.2f M processes/s\n", depths[iterator],
+               bench_throughput(depths[iterator]) / 1e6);
+    }
+
+    // Start the simulated Timer1 for the tick measurements
+    init_scheduler();
+    T1CON |= (1<<15);
+    IEC0bits.T1IE = 1;
+
+    printf("\nTick cost by delayed processes queued\n");
+    printf("  %-28s %8s %8s\n", "", "isr", "+expiry");
+    for( iterator = 0; iterator < sizeof(tick_depths)/sizeof(tick_depths[0]); ++iterator )
+    {
+        bench_tick_depth(tick_depths[iterator], &isr, &expire);
+        printf("  %-28u %8.1f %8.1f ns\n", tick_depths[iterator], isr, expire);
+    }
+
+    return 0;
+}
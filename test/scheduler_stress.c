@@ -0,0 +1,321 @@
+/* -*- mode: C; tab-width: 4 -*- */
+/**
+ * @file scheduler_stress.c
+ *
+ * @brief Host stress test of the scheduler's ISR queues and preemptive bands.
+ *
+ * @details One thread for each interrupt priority level stands in for the ISRs of that level and
+ * schedules processes as fast as it can, while the main thread runs the scheduler loop. Every
+ * process must run exactly once, and the processes of each level must run in the order they were
+ * scheduled. Then the main thread queues processes to both preemptive bands, which must run them in
+ * order at the band's level, while band 1 waits on work it queues to band 2 and both bands forward
+ * work to the main loop. Build and run from the repository root with:
+ *
+ * <tt>gcc -std=gnu99 -O2 -Wall -Wextra -pthread -DSCHEDULER_HOST -o scheduler_stress test/scheduler_stress.c && ./scheduler_stress</tt>
+ *
+ * @date 10/15/2026
+ * @carlnumber FIRM-0004
+ * @version 0.3.0
+ */
+
+#include <stdio.h>
+#include <pthread.h>
+
+#define SCHEDULE_BANDS 2
+
+#include "../source/scheduler_xc16.c"
+
+#define STRESS_PROCESSES 5000UL /**< Processes scheduled by each producer */
+
+#define STRESS_LEVEL_SHIFT 24 /**< Position of the level in a process' parameter */
+#define STRESS_COUNT_MASK ((1UL << STRESS_LEVEL_SHIFT) - 1) /**< Count in a process' parameter */
+
+#define STRESS_BAND_PROCESSES 2000UL /**< Processes queued to each band */
+#define STRESS_BAND_FORWARD 4 /**< Every this many band processes forward one to the main loop */
+#define STRESS_BAND_NEST 16 /**< Every this many band 1 processes wait on one in band 2 */
+
+
+/**
+ * Give up the CPU for a moment. A bare yield can leave other threads starved on a single core.
+ */
+static void stress_pause(void)
+{
+    static const struct timespec pause = {0, 1000};
+
+    nanosleep(&pause, NULL);
+}
+
+
+/**
+ * Number of processes of each level which have run.
+ */
+static unsigned long stress_runs[SCHEDULER_HW_IPL_LEVELS+1];
+
+/**
+ * Number of processes of each level which ran out of order.
+ */
+static unsigned long stress_out_of_order[SCHEDULER_HW_IPL_LEVELS+1];
+
+/**
+ * Number of times each producer found its queue full and had to retry.
+ */
+static unsigned long stress_retries[SCHEDULER_HW_IPL_LEVELS+1];
+
+
+/**
+ * The process scheduled by the producers. Its parameter holds the producer's level and the count
+ * of processes the producer scheduled before it.
+ */
+static void stress_process(void *params)
+{
+    uintptr_t value = (uintptr_t)params;
+    unsigned int level = value >> STRESS_LEVEL_SHIFT;
+
+    if( (value & STRESS_COUNT_MASK) != stress_runs[level] )
+    {
+        stress_out_of_order[level]++;
+    }
+    stress_runs[level]++;
+}
+
+/**
+ * Producer thread, standing in for the ISRs of one interrupt priority level.
+ */
+static void * stress_producer(void *arg)
+{
+    unsigned int level = (unsigned int)(uintptr_t)arg;
+    unsigned long count;
+
+    scheduler_hw_host_ipl = level;
+
+    for( count = 0; count < STRESS_PROCESSES; ++count )
+    {
+        // Every other process goes through schedule(), which forwards to the queue
+        while( !((count & 1) ? schedule(&stress_process, -(int)level,
+                                        (void *)(((uintptr_t)level << STRESS_LEVEL_SHIFT) | count)) != 0
+                             : schedule_from_isr(&stress_process, -(int)level,
+                                        (void *)(((uintptr_t)level << STRESS_LEVEL_SHIFT) | count)) != 0) )
+        {
+            stress_retries[level]++;
+        }
+    }
+
+    return NULL;
+}
+
+
+/**
+ * Number of processes of each band which have run.
+ */
+static unsigned long stress_band_runs[SCHEDULE_BANDS+1];
+
+/**
+ * Number of processes of each band which ran out of order or at the wrong level.
+ */
+static unsigned long stress_band_errors[SCHEDULE_BANDS+1];
+
+/**
+ * Number of times the main thread found a band's queue full and had to retry.
+ */
+static unsigned long stress_band_retries[SCHEDULE_BANDS+1];
+
+/**
+ * Number of processes forwarded by the bands which the main loop has run.
+ */
+static unsigned long stress_band_forwarded;
+
+/**
+ * Set by the band 2 process which band 1 waits on.
+ */
+static unsigned int stress_band_nested;
+
+
+/**
+ * Interrupt priority level of each band.
+ */
+static const unsigned int stress_band_ipl[SCHEDULE_BANDS+1] =
+    {0, SCHEDULER_HW_BAND1_IPL, SCHEDULER_HW_BAND2_IPL};
+
+/**
+ * The process forwarded to the main loop by the bands.
+ */
+static void stress_band_forward(void *params)
+{
+    (void)params;
+
+    stress_band_forwarded++;
+}
+
+/**
+ * The process band 1 queues to band 2 and waits on, as band 1 would be preempted on hardware.
+ */
+static void stress_band_nest(void *params)
+{
+    (void)params;
+
+    if( SCHEDULER_HW_CURRENT_IPL() != SCHEDULER_HW_BAND2_IPL )
+    {
+        stress_band_errors[2]++;
+    }
+    SCHEDULER_HW_STORE_RELEASE(stress_band_nested, 1);
+}
+
+/**
+ * The process queued to the bands. Its parameter holds the band and the count of processes queued
+ * to the band before it.
+ */
+static void stress_band_process(void *params)
+{
+    uintptr_t value = (uintptr_t)params;
+    unsigned int band = value >> STRESS_LEVEL_SHIFT;
+    unsigned long count = value & STRESS_COUNT_MASK;
+
+    if( count != stress_band_runs[band] || SCHEDULER_HW_CURRENT_IPL() != stress_band_ipl[band] )
+    {
+        stress_band_errors[band]++;
+    }
+
+    if( count % STRESS_BAND_FORWARD == 0 )
+    {// Forward work to the main loop through the band's ISR queue
+        while( schedule(&stress_band_forward, 0, NULL) == 0 )
+        {
+            stress_pause();
+        }
+    }
+
+    if( band == 1 && count % STRESS_BAND_NEST == 0 )
+    {// Queue work to the higher band and wait for it
+        SCHEDULER_HW_STORE_RELEASE(stress_band_nested, 0);
+        while( !schedule_band(2, &stress_band_nest, NULL) )
+        {
+            stress_pause();
+        }
+        while( !SCHEDULER_HW_LOAD_ACQUIRE(stress_band_nested) )
+        {
+            stress_pause();
+        }
+    }
+
+    SCHEDULER_HW_STORE_RELEASE(stress_band_runs[band], stress_band_runs[band]+1);
+}
+
+/**
+ * Queue processes to both bands and run the main loop until every band process and every process
+ * the bands forwarded has run.
+ *
+ * @return      Number of failures.
+ */
+static unsigned int stress_bands(void)
+{
+    const unsigned long forwarded = SCHEDULE_BANDS
+        * ((STRESS_BAND_PROCESSES + STRESS_BAND_FORWARD - 1) / STRESS_BAND_FORWARD);
+    unsigned int failures = 0;
+    unsigned long count;
+    unsigned int band;
+
+    init_scheduler();
+
+    // Invalid bands and functions are refused
+    if( schedule_band(0, &stress_band_process, NULL) || schedule_band(SCHEDULE_BANDS+1,
+        &stress_band_process, NULL) || schedule_band(1, NULL, NULL) )
+    {
+        ++failures;
+    }
+
+    for( count = 0; count < STRESS_BAND_PROCESSES; ++count )
+    {
+        for( band = 1; band <= SCHEDULE_BANDS; ++band )
+        {
+            while( !schedule_band(band, &stress_band_process,
+                                  (void *)(((uintptr_t)band << STRESS_LEVEL_SHIFT) | count)) )
+            {// Band is full, let it run
+                stress_band_retries[band]++;
+                dispatch();
+                stress_pause();
+            }
+        }
+        dispatch();
+    }
+
+    // Run the main loop until everything has run
+    while( SCHEDULER_HW_LOAD_ACQUIRE(stress_band_runs[1]) < STRESS_BAND_PROCESSES
+           || SCHEDULER_HW_LOAD_ACQUIRE(stress_band_runs[2]) < STRESS_BAND_PROCESSES
+           || stress_band_forwarded < forwarded )
+    {
+        if( !dispatch() )
+        {
+            stress_pause();
+        }
+    }
+
+    for( band = 1; band <= SCHEDULE_BANDS; ++band )
+    {
+        printf("  band %u: %lu runs, %lu errors, %lu retries\n", band, stress_band_runs[band],
+               stress_band_errors[band], stress_band_retries[band]);
+        if( stress_band_runs[band] != STRESS_BAND_PROCESSES || stress_band_errors[band] != 0 )
+        {
+            ++failures;
+        }
+    }
+    printf("  forwarded: %lu runs\n", stress_band_forwarded);
+
+    // Nothing may be left behind
+    if( dispatch() || schedule_length != 0 || stress_band_forwarded != forwarded )
+    {
+        ++failures;
+    }
+
+    return failures;
+}
+
+
+int main(void)
+{
+    pthread_t producers[SCHEDULER_HW_IPL_LEVELS+1];
+    unsigned long total = 0;
+    unsigned int failures = 0;
+    unsigned int level;
+
+    for( level = 1; level <= SCHEDULER_HW_IPL_LEVELS; ++level )
+    {
+        pthread_create(&producers[level], NULL, &stress_producer, (void *)(uintptr_t)level);
+    }
+
+    // Run the scheduler loop until every process has run
+    while( total < SCHEDULER_HW_IPL_LEVELS*STRESS_PROCESSES )
+    {
+        if( dispatch() )
+        {
+            ++total;
+        }
+        else
+        {// Nothing to run, let the producers run
+            stress_pause();
+        }
+    }
+
+    for( level = 1; level <= SCHEDULER_HW_IPL_LEVELS; ++level )
+    {
+        pthread_join(producers[level], NULL);
+
+        printf("  level %u: %lu runs, %lu out of order, %lu retries\n", level, stress_runs[level],
+               stress_out_of_order[level], stress_retries[level]);
+        if( stress_runs[level] != STRESS_PROCESSES || stress_out_of_order[level] != 0 )
+        {
+            ++failures;
+        }
+    }
+
+    // Nothing may be left behind
+    if( dispatch() || schedule_length != 0 )
+    {
+        ++failures;
+    }
+
+    // The bands are exercised once the producers are done, as band processes share their queues
+    failures += stress_bands();
+
+    printf("scheduler_stress: %s\n", failures ? "FAILED" : "passed");
+
+    return failures ? 1 : 0;
+}
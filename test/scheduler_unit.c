@@ -0,0 +1,1249 @@
+/* -*- mode: C; tab-width: 4 -*- */
+/**
+ * @file scheduler_unit.c
+ *
+ * @brief This file contains the host unit tests for the scheduler.
+ *
+ * @details The scheduler source is included directly so that the tests can drive its main loop one
+ * pass at a time against the simulated Timer1 in scheduler_hw.h. Build and run from the repository
+ * root with:
+ *
+ * <tt>gcc -std=gnu99 -DSCHEDULER_HOST -o scheduler_unit test/scheduler_unit.c && ./scheduler_unit</tt>
+ *
+ * @date 10/15/2026
+ * @carlnumber FIRM-0004
+ * @version 0.3.0
+ */
+
+#include <stdio.h>
+
+#define SCHEDULE_TICKLESS
+#define SCHEDULE_PROFILE
+#define SCHEDULE_BUDGET
+
+// Build with -DSCHEDULE_POLICY=0 to test the FIFO policy instead
+#ifndef SCHEDULE_POLICY
+#define SCHEDULE_POLICY SCHEDULE_POLICY_EDF
+#endif
+
+#include "../source/scheduler_xc16.c"
+
+/** Check a condition, reporting and counting it on failure */
+#define UNIT_CHECK(cond) \
+    do { if( !(cond) ) { printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); ++failures; } } while(0)
+
+/** Cycles Timer1 counts per kernel tick */
+#define UNIT_TICK_CYCLES (SCHEDULER_HW_TICK_PERIOD+1UL)
+
+static unsigned int failures = 0;
+
+
+/**
+ * A process which records the tick it ran on.
+ */
+static void unit_record_tick(void *params)
+{
+    *(unsigned long *)params = ticks;
+}
+
+/**
+ * Tick recorded by unit_wake_process().
+ */
+static unsigned long unit_wake_tick = 0;
+
+/**
+ * Kernel time in Timer1 counts recorded by unit_wake_process(), and the simulated time it ran at.
+ */
+static unsigned long unit_wake_cycles = 0;
+static unsigned long unit_wake_host_cycles = 0;
+
+static void unit_wake_process(void *params)
+{
+    (void)params;
+    unit_wake_tick = ticks;
+    unit_wake_cycles = get_cycles();
+    unit_wake_host_cycles = (unsigned long)scheduler_hw_host_cycles;
+}
+
+/**
+ * Simulated peripheral interrupt which schedules a process while the scheduler idles.
+ */
+static void unit_wake_isr(void)
+{
+    scheduler_hw_host_ipl = 4;
+    schedule(&unit_wake_process, 0, NULL);
+    scheduler_hw_host_ipl = 0;
+}
+
+
+/**
+ * Start the scheduler without entering its endless loop.
+ */
+static void unit_start(void)
+{
+    init_scheduler();
+    T1CON |= (1<<15);
+    IEC0bits.T1IE = 1;
+}
+
+/**
+ * Run passes of the main loop, exactly as start_scheduler() does, until @em done is nonzero.
+ */
+static void unit_run_until(volatile unsigned long *done)
+{
+    unsigned int passes;
+
+    for( passes = 0; *done == 0 && passes < 10000; ++passes )
+    {
+        if( !dispatch() )
+        {
+            idle();
+        }
+    }
+}
+
+
+/**
+ * A delayed process runs on exactly its due tick, and the idle periods in between are stretched
+ * instead of waking on every tick.
+ */
+static void test_tickless_delay(void)
+{
+    volatile unsigned long ran = 0;
+    unsigned long start = ticks;
+    unsigned long idles = scheduler_hw_host_idles;
+
+    schedule(&unit_record_tick, 40, (void *)&ran);
+    unit_run_until(&ran);
+
+    UNIT_CHECK(ran == start+40);
+    UNIT_CHECK(ticks == scheduler_hw_host_cycles / UNIT_TICK_CYCLES);
+    UNIT_CHECK(scheduler_hw_host_idles - idles <= (40+TICKLESS_MAX_TICKS-1)/TICKLESS_MAX_TICKS);
+}
+
+/**
+ * Delays longer than the timing wheel and shorter than one idle period both run on time.
+ */
+static void test_tickless_mixed_delays(void)
+{
+    static const int delays[] = {100, 3, 13, 14, 1, 64, 27};
+    volatile unsigned long ran[sizeof(delays)/sizeof(delays[0])] = {0};
+    unsigned long start = ticks;
+    unsigned int iterator;
+
+    for( iterator = 0; iterator < sizeof(delays)/sizeof(delays[0]); ++iterator )
+    {
+        schedule(&unit_record_tick, delays[iterator], (void *)&ran[iterator]);
+    }
+    unit_run_until(&ran[0]);
+
+    for( iterator = 0; iterator < sizeof(delays)/sizeof(delays[0]); ++iterator )
+    {
+        UNIT_CHECK(ran[iterator] == start+delays[iterator]);
+    }
+    UNIT_CHECK(ticks == scheduler_hw_host_cycles / UNIT_TICK_CYCLES);
+}
+
+/**
+ * An interrupt partway through a stretched period wakes the scheduler, the ticks already passed
+ * are counted, and the delayed process still runs on its due tick.
+ */
+static void test_tickless_early_wake(void)
+{
+    volatile unsigned long ran = 0;
+    unsigned long start = ticks;
+
+    unit_wake_tick = 0;
+    scheduler_hw_host_wake_isr = &unit_wake_isr;
+    scheduler_hw_host_wake_after = 3*UNIT_TICK_CYCLES + UNIT_TICK_CYCLES/2;
+
+    schedule(&unit_record_tick, 40, (void *)&ran);
+    unit_run_until(&ran);
+
+    UNIT_CHECK(unit_wake_tick == start+3);
+    UNIT_CHECK(unit_wake_cycles == unit_wake_host_cycles);
+    UNIT_CHECK(ran == start+40);
+    UNIT_CHECK(ticks == scheduler_hw_host_cycles / UNIT_TICK_CYCLES);
+    UNIT_CHECK(PR1 == SCHEDULER_HW_TICK_PERIOD);
+}
+
+/**
+ * With nothing scheduled the scheduler idles for the longest period Timer1 can count.
+ */
+static void test_tickless_empty(void)
+{
+    unsigned long start = ticks;
+
+    UNIT_CHECK(!dispatch());
+    idle();
+
+    UNIT_CHECK(ticks == start+TICKLESS_MAX_TICKS);
+    UNIT_CHECK(tick_step == 1);
+}
+
+/**
+ * The tick counter stays exact as it wraps around.
+ */
+static void test_tickless_wrap(void)
+{
+    volatile unsigned long ran = 0;
+    unsigned long long start_cycles;
+    unsigned long start;
+
+    ticks = (unsigned long)-16;
+    wheel_ticks = ticks;
+    start = ticks;
+    start_cycles = scheduler_hw_host_cycles - TMR1;
+
+    schedule(&unit_record_tick, 37, (void *)&ran);
+    unit_run_until(&ran);
+
+    UNIT_CHECK(ran == start+37);
+    UNIT_CHECK(ticks - start == (scheduler_hw_host_cycles - start_cycles) / UNIT_TICK_CYCLES);
+}
+
+/**
+ * A process which takes the number of Timer1 counts pointed to by @em params to run.
+ */
+static void unit_busy_process(void *params)
+{
+    scheduler_hw_host_advance(*(unsigned long *)params);
+}
+
+/**
+ * A second busy process, profiled separately.
+ */
+static void unit_busy_process_2(void *params)
+{
+    unit_busy_process(params);
+}
+
+
+/**
+ * Execution time and latency are measured in Timer1 counts. A process scheduled behind another
+ * waits for it to run, and a delayed process is ready on the first count of its due tick.
+ */
+static void test_profile_times(void)
+{
+    static unsigned long long_run = 5*UNIT_TICK_CYCLES/2;
+    static unsigned long short_run = 100;
+    volatile unsigned long ran = 0;
+    scheduler_profile_t profile;
+
+    scheduler_profile_reset();
+
+    schedule(&unit_busy_process, 0, &long_run);
+    schedule(&unit_busy_process_2, 0, &short_run);
+    schedule(&unit_busy_process_2, 0, &short_run);
+    schedule(&unit_record_tick, 7, (void *)&ran);
+    unit_run_until(&ran);
+
+    UNIT_CHECK(scheduler_profile_get(&unit_busy_process, &profile));
+    UNIT_CHECK(profile.runs == 1);
+    UNIT_CHECK(profile.total == long_run);
+    UNIT_CHECK(profile.min == long_run && profile.max == long_run);
+    UNIT_CHECK(profile.latency_max == 0);
+
+    UNIT_CHECK(scheduler_profile_get(&unit_busy_process_2, &profile));
+    UNIT_CHECK(profile.runs == 2);
+    UNIT_CHECK(profile.total == 2*short_run);
+    UNIT_CHECK(profile.latency_total == long_run + (long_run+short_run));
+    UNIT_CHECK(profile.latency_max == long_run+short_run);
+
+    UNIT_CHECK(scheduler_profile_get(&unit_record_tick, &profile));
+    UNIT_CHECK(profile.runs == 1);
+    UNIT_CHECK(profile.latency_max == 0);
+
+    UNIT_CHECK(!scheduler_profile_get(&unit_wake_process, &profile));
+}
+
+/**
+ * The binary dump holds a header and as many whole records as fit.
+ */
+static void test_profile_dump(void)
+{
+    unsigned char buffer[SCHEDULE_PROFILE_DUMP_HEADER_SIZE + 3*SCHEDULE_PROFILE_DUMP_RECORD_SIZE];
+    unsigned long runs;
+
+    // Profiles are left by test_profile_times()
+    UNIT_CHECK(scheduler_profile_dump(buffer, sizeof(buffer))
+               == SCHEDULE_PROFILE_DUMP_HEADER_SIZE + 3*SCHEDULE_PROFILE_DUMP_RECORD_SIZE);
+    UNIT_CHECK(buffer[0] == 'S' && buffer[1] == 'P');
+    UNIT_CHECK(buffer[3] == 3);
+    UNIT_CHECK((buffer[4] | buffer[5]<<8) == UNIT_TICK_CYCLES);
+
+    // Runs of the second record, unit_busy_process_2()
+    runs = buffer[SCHEDULE_PROFILE_DUMP_HEADER_SIZE + SCHEDULE_PROFILE_DUMP_RECORD_SIZE + 4];
+    UNIT_CHECK(runs == 2);
+
+    UNIT_CHECK(scheduler_profile_dump(buffer, sizeof(buffer)-1)
+               == SCHEDULE_PROFILE_DUMP_HEADER_SIZE + 2*SCHEDULE_PROFILE_DUMP_RECORD_SIZE);
+    UNIT_CHECK(buffer[3] == 2);
+    UNIT_CHECK(scheduler_profile_dump(buffer, SCHEDULE_PROFILE_DUMP_HEADER_SIZE-1) == 0);
+}
+
+
+/**
+ * Event posted by unit_post_isr().
+ */
+static scheduler_event_t unit_event;
+
+/**
+ * Simulated peripheral interrupt which posts bit 0 of unit_event.
+ */
+static void unit_post_isr(void)
+{
+    scheduler_hw_host_ipl = 5;
+    scheduler_event_post(&unit_event, 0x0001);
+    scheduler_hw_host_ipl = 0;
+}
+
+/**
+ * What a process woken by an event saw when it ran.
+ */
+struct unit_wake_s
+{
+    unsigned long runs;     /**< Number of times it ran */
+    unsigned long tick;     /**< Tick it last ran on */
+    unsigned int bits;      /**< Wake bits it last saw */
+};
+
+/**
+ * A process which records when it was woken and by which bits.
+ */
+static void unit_event_process(void *params)
+{
+    struct unit_wake_s *wake = params;
+
+    wake->runs++;
+    wake->tick = ticks;
+    wake->bits = scheduler_wake_bits();
+}
+
+/**
+ * Run passes of the main loop until @em wake has run, or @em ticks_limit ticks pass.
+ */
+static void unit_run_wake(struct unit_wake_s *wake, unsigned long ticks_limit)
+{
+    unsigned long start = ticks;
+
+    while( wake->runs == 0 && ticks - start < ticks_limit )
+    {
+        if( !dispatch() )
+        {
+            idle();
+        }
+    }
+}
+
+/**
+ * Check that no process is left in the timing wheel.
+ */
+static bool unit_wheel_empty(void)
+{
+    unsigned int bucket;
+
+    for( bucket = 0; bucket < SCHEDULE_WHEEL_LENGTH; ++bucket )
+    {
+        if( schedule_wheel[bucket] != NULL )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/**
+ * A waiting process stays parked until an ISR posts its event, even while the scheduler idles, and
+ * its timeout is cancelled when it is woken.
+ */
+static void test_event_post(void)
+{
+    struct unit_wake_s wake = {0};
+    unsigned long start = ticks;
+
+    UNIT_CHECK(schedule_on_event(&unit_event_process, &unit_event, 0x0001, 100, &wake));
+
+    // Nothing is ready, the post arrives while idling
+    UNIT_CHECK(!dispatch());
+    scheduler_hw_host_wake_isr = &unit_post_isr;
+    scheduler_hw_host_wake_after = 5*UNIT_TICK_CYCLES + 10;
+    unit_run_wake(&wake, 200);
+
+    UNIT_CHECK(wake.runs == 1);
+    UNIT_CHECK(wake.tick == start+5);
+    UNIT_CHECK(wake.bits == 0x0001);
+    UNIT_CHECK(unit_event.bits == 0);
+    UNIT_CHECK(unit_wheel_empty());
+    UNIT_CHECK(scheduler_wake_bits() == 0);
+}
+
+/**
+ * A waiting process which is not posted to is woken by its timeout.
+ */
+static void test_event_timeout(void)
+{
+    struct unit_wake_s wake = {0};
+    unsigned long start = ticks;
+
+    UNIT_CHECK(schedule_on_event(&unit_event_process, &unit_event, 0x0001, 20, &wake));
+    unit_run_wake(&wake, 200);
+
+    UNIT_CHECK(wake.runs == 1);
+    UNIT_CHECK(wake.tick == start+20);
+    UNIT_CHECK(wake.bits == 0);
+    UNIT_CHECK(unit_event.waiters == NULL);
+}
+
+/**
+ * Only the bits a process waits on wake it. Other bits stay posted, wake a later waiter
+ * immediately, and can be cleared.
+ */
+static void test_event_mask(void)
+{
+    struct unit_wake_s wake_a = {0};
+    struct unit_wake_s wake_b = {0};
+    struct unit_wake_s wake_c = {0};
+
+    UNIT_CHECK(schedule_on_event(&unit_event_process, &unit_event, 0x0002, 0, &wake_a));
+
+    scheduler_event_post(&unit_event, 0x0005);
+    dispatch();
+    UNIT_CHECK(wake_a.runs == 0);
+    UNIT_CHECK(unit_event.bits == 0x0005);
+
+    // Already posted bits wake immediately, and only the waited on bits are consumed
+    UNIT_CHECK(schedule_on_event(&unit_event_process, &unit_event, 0x0006, 0, &wake_b));
+    dispatch();
+    UNIT_CHECK(wake_b.runs == 1 && wake_b.bits == 0x0004);
+    UNIT_CHECK(unit_event.bits == 0x0001);
+
+    scheduler_event_clear(&unit_event, 0x0001);
+    UNIT_CHECK(unit_event.bits == 0);
+
+    // Every waiter on a posted bit wakes
+    UNIT_CHECK(schedule_on_event(&unit_event_process, &unit_event, 0x0002, 0, &wake_c));
+    scheduler_event_post(&unit_event, 0x0002);
+    while( dispatch() );
+    UNIT_CHECK(wake_a.runs == 1 && wake_a.bits == 0x0002);
+    UNIT_CHECK(wake_c.runs == 1 && wake_c.bits == 0x0002);
+    UNIT_CHECK(unit_event.bits == 0);
+
+    // Invalid waits are rejected
+    UNIT_CHECK(!schedule_on_event(&unit_event_process, &unit_event, 0, 0, &wake_a));
+    UNIT_CHECK(!schedule_on_event(&unit_event_process, NULL, 1, 0, &wake_a));
+}
+
+
+/**
+ * What the coroutine run by unit_coroutine() saw at each of its steps.
+ */
+struct unit_co_s
+{
+    unsigned int steps;         /**< Number of steps taken */
+    unsigned long tick[6];      /**< Tick each step was taken on */
+    unsigned int bits[6];       /**< Wake bits seen at each step */
+    unsigned long order;        /**< Value of unit_wake_tick when the coroutine resumed from its
+                                   yield */
+};
+
+/**
+ * Context kept by unit_coroutine() between its runs.
+ */
+struct unit_co_context_s
+{
+    unsigned int count;         /**< Number of times the coroutine has resumed */
+};
+
+/**
+ * A coroutine which yields, sleeps, waits on unit_event until it is posted, and waits on it again
+ * until it times out, recording each step.
+ */
+static void unit_coroutine(void *params)
+{
+    struct unit_co_s *co = params;
+    struct unit_co_context_s *context = SCHEDULER_CO_CONTEXT(struct unit_co_context_s);
+
+    SCHEDULER_CO_BEGIN();
+
+    co->tick[co->steps++] = ticks;
+    SCHEDULER_CO_YIELD();
+
+    co->order = unit_wake_tick;
+    co->tick[co->steps++] = ticks;
+    context->count++;
+    SCHEDULER_CO_SLEEP(10);
+
+    co->tick[co->steps++] = ticks;
+    context->count++;
+    SCHEDULER_CO_AWAIT(&unit_event, 0x0001, 50);
+
+    co->bits[co->steps] = scheduler_wake_bits();
+    co->tick[co->steps++] = ticks;
+    context->count++;
+    SCHEDULER_CO_AWAIT(&unit_event, 0x0001, 5);
+
+    co->bits[co->steps] = scheduler_wake_bits();
+    co->tick[co->steps++] = ticks;
+    context->count++;
+    co->bits[co->steps] = context->count;
+    co->tick[co->steps++] = ticks;
+
+    SCHEDULER_CO_END();
+}
+
+/**
+ * A coroutine resumes after each suspension on the right tick, with its context intact, and its
+ * place in the pool is released when it ends.
+ */
+static void test_coroutine_steps(void)
+{
+    struct unit_co_s co = {0};
+    unsigned long start = ticks;
+    unsigned int passes;
+    bool armed = false;
+
+    unit_wake_tick = 0;
+    UNIT_CHECK(!schedule_coroutine(NULL, 0, &co));
+    UNIT_CHECK(schedule_coroutine(&unit_coroutine, 0, &co));
+    UNIT_CHECK(schedule(&unit_wake_process, 0, NULL));
+
+    // The process scheduled after the coroutine runs before it resumes from its yield
+    UNIT_CHECK(dispatch());
+    UNIT_CHECK(co.steps == 1);
+    UNIT_CHECK(dispatch());
+    UNIT_CHECK(dispatch());
+    UNIT_CHECK(co.steps == 2);
+    UNIT_CHECK(co.order == start);
+
+    // The sleep ends, then the post arrives while the coroutine waits and the second wait times out
+    for( passes = 0; co.steps < 6 && passes < 10000; ++passes )
+    {
+        if( co.steps == 3 && unit_event.waiters != NULL && !armed )
+        {
+            armed = true;
+            scheduler_hw_host_wake_isr = &unit_post_isr;
+            scheduler_hw_host_wake_after = 5*UNIT_TICK_CYCLES + 10;
+        }
+        if( !dispatch() )
+        {
+            idle();
+        }
+    }
+    UNIT_CHECK(co.steps == 6);
+    UNIT_CHECK(co.tick[2] == start+10);
+    UNIT_CHECK(co.tick[3] == start+15);
+    UNIT_CHECK(co.bits[3] == 0x0001);
+    UNIT_CHECK(co.tick[4] == start+20);
+    UNIT_CHECK(co.bits[4] == 0);
+    UNIT_CHECK(co.bits[5] == 4);
+    UNIT_CHECK(schedule_length == 0);
+    UNIT_CHECK(unit_wheel_empty());
+    UNIT_CHECK(unit_event.waiters == NULL);
+
+    // The coroutine's place was returned to the pool
+    UNIT_CHECK(free_list != NULL && free_list->coroutine);
+}
+
+/**
+ * A coroutine awaiting a bit which is already posted carries on without suspending, and plain
+ * processes cannot suspend.
+ */
+static void unit_coroutine_posted(void *params)
+{
+    struct unit_wake_s *wake = params;
+
+    SCHEDULER_CO_BEGIN();
+
+    SCHEDULER_CO_AWAIT(&unit_event, 0x0004, 0);
+    wake->runs++;
+    wake->tick = ticks;
+    wake->bits = scheduler_wake_bits();
+
+    SCHEDULER_CO_END();
+}
+
+static void unit_plain_sleep(void *params)
+{
+    *(int *)params = scheduler_co_sleep(1);
+}
+
+static void test_coroutine_posted(void)
+{
+    struct unit_wake_s wake = {0};
+    int slept = true;
+
+    scheduler_event_post(&unit_event, 0x0004);
+    UNIT_CHECK(schedule_coroutine(&unit_coroutine_posted, 0, &wake));
+    UNIT_CHECK(dispatch());
+    UNIT_CHECK(wake.runs == 1);
+    UNIT_CHECK(wake.bits == 0x0004);
+    UNIT_CHECK(unit_event.bits == 0);
+
+    UNIT_CHECK(schedule(&unit_plain_sleep, 0, &slept));
+    UNIT_CHECK(dispatch());
+    UNIT_CHECK(!slept);
+    UNIT_CHECK(!dispatch());
+}
+
+
+/**
+ * Order in which unit_order_process() ran, one character per run.
+ */
+static char unit_order[8];
+static unsigned int unit_order_length = 0;
+
+/**
+ * A process which appends the character pointed to by @em params to unit_order.
+ */
+static void unit_order_process(void *params)
+{
+    unit_order[unit_order_length++] = *(const char *)params;
+}
+
+/**
+ * Ready processes run earliest deadline first under the EDF policy, and in the order they were
+ * scheduled under the FIFO policy. A process without a deadline is due by the tick it is scheduled.
+ */
+static void test_deadline_order(void)
+{
+    static const char names[] = "abc";
+
+    unit_order_length = 0;
+    UNIT_CHECK(!schedule_deadline(&unit_order_process, 0, 0, (void *)&names[0]));
+    UNIT_CHECK(schedule_deadline(&unit_order_process, 0, 10, (void *)&names[0]));
+    UNIT_CHECK(schedule_deadline(&unit_order_process, 0, 3, (void *)&names[1]));
+    UNIT_CHECK(schedule(&unit_order_process, 0, (void *)&names[2]));
+    while( dispatch() );
+
+    UNIT_CHECK(unit_order_length == 3);
+#if SCHEDULE_POLICY == SCHEDULE_POLICY_EDF
+    UNIT_CHECK(unit_order[0] == 'c' && unit_order[1] == 'b' && unit_order[2] == 'a');
+#else
+    UNIT_CHECK(unit_order[0] == 'a' && unit_order[1] == 'b' && unit_order[2] == 'c');
+#endif
+}
+
+/**
+ * A coroutine which appends 'y', yields, then appends 'z'.
+ */
+static void unit_order_yield(void *params)
+{
+    (void)params;
+
+    SCHEDULER_CO_BEGIN();
+
+    unit_order[unit_order_length++] = 'y';
+    SCHEDULER_CO_YIELD();
+    unit_order[unit_order_length++] = 'z';
+
+    SCHEDULER_CO_END();
+}
+
+/**
+ * A yielding coroutine lets every other ready process run first under either policy, even those
+ * with a later deadline than its own.
+ */
+static void test_deadline_yield(void)
+{
+    static const char names[] = "b";
+
+    unit_order_length = 0;
+    UNIT_CHECK(schedule_coroutine(&unit_order_yield, 0, NULL));
+    UNIT_CHECK(schedule_deadline(&unit_order_process, 0, 10, (void *)&names[0]));
+    while( dispatch() );
+
+    UNIT_CHECK(unit_order_length == 3);
+    UNIT_CHECK(unit_order[0] == 'y' && unit_order[1] == 'b' && unit_order[2] == 'z');
+}
+
+/**
+ * Function and lateness reported to unit_deadline_miss().
+ */
+static void (*unit_miss_func)(void *) = NULL;
+static unsigned long unit_miss_lateness = 0;
+
+static void unit_deadline_miss(void (*func)(void *), unsigned long lateness)
+{
+    unit_miss_func = func;
+    unit_miss_lateness = lateness;
+}
+
+/**
+ * A run which completes after its deadline is counted and reported with its lateness, while a run
+ * which completes on its deadline tick is not.
+ */
+static void test_deadline_miss(void)
+{
+    static unsigned long in_time = 2*UNIT_TICK_CYCLES;
+    static unsigned long late = 5*UNIT_TICK_CYCLES;
+    scheduler_deadline_stats_t before, after;
+
+    scheduler_on_deadline_miss(&unit_deadline_miss);
+    scheduler_deadline_stats(&before);
+
+    UNIT_CHECK(schedule_deadline(&unit_busy_process, 0, 2, &in_time));
+    while( dispatch() );
+    scheduler_deadline_stats(&after);
+    UNIT_CHECK(after.misses == before.misses);
+    UNIT_CHECK(unit_miss_func == NULL);
+
+    UNIT_CHECK(schedule_deadline(&unit_busy_process, 0, 2, &late));
+    while( dispatch() );
+    scheduler_deadline_stats(&after);
+    UNIT_CHECK(after.misses == before.misses+1);
+    UNIT_CHECK(after.max_lateness >= 3);
+    UNIT_CHECK(unit_miss_func == &unit_busy_process);
+    UNIT_CHECK(unit_miss_lateness == 3);
+
+    scheduler_on_deadline_miss(NULL);
+}
+
+
+/**
+ * The time follows the simulated Timer1 to the count, in microseconds as well as counts, including
+ * while a period has ended but the tick ISR is held off.
+ */
+static void test_now_time(void)
+{
+    unsigned long long offset = scheduler_now_cycles() - scheduler_hw_host_cycles;
+    unsigned long long start_us;
+
+    scheduler_hw_host_advance(1234);
+    UNIT_CHECK(scheduler_now_cycles() - scheduler_hw_host_cycles == offset);
+
+    start_us = scheduler_now_us();
+    scheduler_hw_host_advance(3*UNIT_TICK_CYCLES);
+    UNIT_CHECK(scheduler_now_us() - start_us == 3*SCHEDULER_HW_TICK_US);
+
+    // Hold the tick ISR off across the end of a period, as a higher priority ISR would
+    IEC0bits.T1IE = 0;
+    scheduler_hw_host_advance(UNIT_TICK_CYCLES);
+    UNIT_CHECK(IFS0bits.T1IF);
+    UNIT_CHECK(scheduler_now_cycles() - scheduler_hw_host_cycles == offset);
+    IEC0bits.T1IE = 1;
+    _T1Interrupt();
+    UNIT_CHECK(scheduler_now_cycles() - scheduler_hw_host_cycles == offset);
+    UNIT_CHECK(get_ticks() == ticks);
+}
+
+
+/**
+ * A cancelled process never runs, its handle stops working, and the handle of the next process in
+ * its place differs. Processes are cancelled from the middle of the schedule heap and from the
+ * timing wheel, and only processes scheduled by the main loop have handles.
+ */
+static void test_handle_unschedule(void)
+{
+    static const char names[] = "abcde";
+    volatile unsigned long ran = 0;
+    scheduler_handle_t delayed, ready[5];
+    unsigned long start = ticks;
+    unsigned int iterator;
+
+    delayed = schedule(&unit_record_tick, 10, (void *)&ran);
+    UNIT_CHECK(delayed != 0 && delayed != SCHEDULER_HANDLE_DEFERRED);
+    UNIT_CHECK(unschedule(delayed));
+    UNIT_CHECK(!unschedule(delayed));
+    UNIT_CHECK(!reschedule(delayed, 1));
+    UNIT_CHECK(unit_wheel_empty());
+
+    // The next process takes the same place with a new handle
+    UNIT_CHECK(schedule(&unit_record_tick, 10, (void *)&ran) != delayed);
+    UNIT_CHECK(!unschedule(delayed));
+    UNIT_CHECK(!unschedule(0));
+    UNIT_CHECK(!unschedule(SCHEDULER_HANDLE_DEFERRED));
+    unit_run_until(&ran);
+    UNIT_CHECK(ran == start+10);
+
+    // Cancel from the middle and the end of the heap
+    unit_order_length = 0;
+    for( iterator = 0; iterator < 5; ++iterator )
+    {
+        ready[iterator] = schedule(&unit_order_process, -(int)iterator, (void *)&names[iterator]);
+    }
+    UNIT_CHECK(unschedule(ready[2]));
+    UNIT_CHECK(unschedule(ready[0]));
+    while( dispatch() );
+    UNIT_CHECK(unit_order_length == 3);
+    UNIT_CHECK(unit_order[0] == 'e' && unit_order[1] == 'd' && unit_order[2] == 'b');
+    UNIT_CHECK(!unschedule(ready[4]));
+
+    // An ISR's process has no handle yet
+    scheduler_hw_host_ipl = 4;
+    UNIT_CHECK(schedule(&unit_order_process, 0, (void *)&names[0]) == SCHEDULER_HANDLE_DEFERRED);
+    UNIT_CHECK(!unschedule(SCHEDULER_HANDLE_DEFERRED));
+    scheduler_hw_host_ipl = 0;
+    while( dispatch() );
+}
+
+/**
+ * Coroutine state for unit_cancel_coroutine().
+ */
+struct unit_cancel_s
+{
+    scheduler_handle_t handle;  /**< The coroutine's own handle */
+    int await;                  /**< Whether to await an event rather than sleep once cancelled */
+    unsigned int steps;         /**< Number of steps run so far */
+};
+
+/**
+ * A coroutine which cancels itself, then tries to suspend.
+ */
+static void unit_cancel_coroutine(void *params)
+{
+    struct unit_cancel_s *cancel = params;
+
+    SCHEDULER_CO_BEGIN();
+
+    cancel->steps++;
+    UNIT_CHECK(unschedule(cancel->handle));
+    if( cancel->await )
+    {
+        SCHEDULER_CO_AWAIT(&unit_event, 0x0002, 0);
+    }
+    else
+    {
+        SCHEDULER_CO_SLEEP(1);
+    }
+    cancel->steps++;
+
+    SCHEDULER_CO_END();
+}
+
+/**
+ * A coroutine which cancels itself returns at its next suspension point and is released rather
+ * than put back to sleep, and does not consume a bit already posted to the event it awaits.
+ */
+static void test_handle_unschedule_coroutine(void)
+{
+    struct unit_cancel_s cancel = {0};
+
+    cancel.handle = schedule_coroutine(&unit_cancel_coroutine, 0, &cancel);
+    UNIT_CHECK(cancel.handle != 0);
+    UNIT_CHECK(dispatch());
+    UNIT_CHECK(cancel.steps == 1);
+    UNIT_CHECK(schedule_length == 0);
+    UNIT_CHECK(unit_wheel_empty());
+    UNIT_CHECK(!unschedule(cancel.handle));
+    UNIT_CHECK(free_list != NULL && free_list->coroutine);
+
+    cancel.steps = 0;
+    cancel.await = true;
+    scheduler_event_post(&unit_event, 0x0002);
+    cancel.handle = schedule_coroutine(&unit_cancel_coroutine, 0, &cancel);
+    UNIT_CHECK(dispatch());
+    UNIT_CHECK(cancel.steps == 1);
+    UNIT_CHECK(unit_event.bits == 0x0002);
+    UNIT_CHECK(unit_event.waiters == NULL);
+    UNIT_CHECK(!dispatch());
+
+    unit_event.bits = 0;
+}
+
+/**
+ * A rescheduled process runs at its new time, whether it was delayed or ready, and a waiting
+ * process keeps waiting with its timeout moved. Cancelling a waiter removes it from its event.
+ */
+static void test_handle_reschedule(void)
+{
+    volatile unsigned long ran = 0;
+    struct unit_wake_s wake = {0};
+    scheduler_handle_t handle;
+    unsigned long start = ticks;
+
+    handle = schedule(&unit_record_tick, 50, (void *)&ran);
+    UNIT_CHECK(reschedule(handle, 5));
+    unit_run_until(&ran);
+    UNIT_CHECK(ran == start+5);
+
+    start = ticks;
+    ran = 0;
+    handle = schedule(&unit_record_tick, 0, (void *)&ran);
+    UNIT_CHECK(reschedule(handle, 3));
+    UNIT_CHECK(schedule_length == 0);
+    unit_run_until(&ran);
+    UNIT_CHECK(ran == start+3);
+
+    start = ticks;
+    handle = schedule_on_event(&unit_event_process, &unit_event, 0x0008, 100, &wake);
+    UNIT_CHECK(reschedule(handle, 4));
+    unit_run_wake(&wake, 200);
+    UNIT_CHECK(wake.runs == 1);
+    UNIT_CHECK(wake.tick == start+4);
+    UNIT_CHECK(wake.bits == 0);
+
+    handle = schedule_on_event(&unit_event_process, &unit_event, 0x0008, 0, &wake);
+    UNIT_CHECK(unit_event.waiters != NULL);
+    UNIT_CHECK(unschedule(handle));
+    UNIT_CHECK(unit_event.waiters == NULL);
+    UNIT_CHECK(unit_wheel_empty());
+    UNIT_CHECK(!dispatch());
+}
+
+
+/**
+ * Function and overrun reported to unit_budget_overrun().
+ */
+static void (*unit_overrun_func)(void *) = NULL;
+static unsigned long unit_overrun = 0;
+
+static void unit_budget_overrun(void (*func)(void *), unsigned long overrun)
+{
+    unit_overrun_func = func;
+    unit_overrun = overrun;
+}
+
+/**
+ * A process which runs until the tick ISR flags it over budget, or for 100 ticks.
+ */
+static void unit_polling_process(void *params)
+{
+    unsigned int iterator;
+
+    for( iterator = 0; iterator < 100 && !scheduler_budget_exceeded(); ++iterator )
+    {
+        scheduler_hw_host_advance(UNIT_TICK_CYCLES);
+    }
+    *(unsigned int *)params = iterator;
+}
+
+/**
+ * A run within budget is not counted. A run over budget is flagged by the tick ISR, which a process
+ * can poll to give up early, and is counted and reported with its overrun.
+ */
+static void test_budget_overrun(void)
+{
+    static unsigned long in_budget = 2*UNIT_TICK_CYCLES;
+    static unsigned long over_budget = 7*UNIT_TICK_CYCLES;
+    scheduler_budget_t budget;
+    unsigned int polled = 0;
+
+    UNIT_CHECK(!scheduler_budget_set(NULL, 1));
+    UNIT_CHECK(scheduler_budget_set(&unit_busy_process_2, 3));
+    UNIT_CHECK(scheduler_budget_set(&unit_polling_process, 4));
+    scheduler_on_budget_overrun(&unit_budget_overrun);
+
+    UNIT_CHECK(schedule(&unit_busy_process_2, 0, &in_budget));
+    while( dispatch() );
+    UNIT_CHECK(scheduler_budget_get(&unit_busy_process_2, &budget));
+    UNIT_CHECK(budget.overruns == 0 && budget.strikes == 0);
+    UNIT_CHECK(unit_overrun_func == NULL);
+
+    UNIT_CHECK(schedule(&unit_busy_process_2, 0, &over_budget));
+    while( dispatch() );
+    UNIT_CHECK(scheduler_budget_get(&unit_busy_process_2, &budget));
+    UNIT_CHECK(budget.overruns == 1 && budget.strikes == 1);
+    UNIT_CHECK(budget.max_overrun == 4);
+    UNIT_CHECK(unit_overrun_func == &unit_busy_process_2);
+    UNIT_CHECK(unit_overrun == 4);
+
+    // The process sees the flag on the first tick past its budget
+    UNIT_CHECK(schedule(&unit_polling_process, 0, &polled));
+    while( dispatch() );
+    UNIT_CHECK(polled == 5);
+    UNIT_CHECK(unit_overrun_func == &unit_polling_process);
+    UNIT_CHECK(unit_overrun == 1);
+    UNIT_CHECK(!scheduler_budget_exceeded());
+
+    // A run within budget clears the strikes
+    UNIT_CHECK(schedule(&unit_busy_process_2, 0, &in_budget));
+    while( dispatch() );
+    UNIT_CHECK(scheduler_budget_get(&unit_busy_process_2, &budget));
+    UNIT_CHECK(budget.overruns == 1 && budget.strikes == 0);
+
+    scheduler_on_budget_overrun(NULL);
+}
+
+/**
+ * After repeated overruns a function is demoted and its runs are held back behind other processes,
+ * keeping their deadlines, until a run completes within budget.
+ */
+static void test_budget_demote(void)
+{
+    static unsigned long over_budget = 5*UNIT_TICK_CYCLES;
+    static unsigned long in_budget = 0;
+    static const char names[] = "ab";
+    scheduler_budget_t budget;
+    unsigned long start;
+    unsigned int strike;
+
+    UNIT_CHECK(scheduler_budget_set(&unit_busy_process, 1));
+    for( strike = 0; strike < SCHEDULE_BUDGET_STRIKES; ++strike )
+    {
+        UNIT_CHECK(schedule(&unit_busy_process, 0, &over_budget));
+        while( dispatch() );
+    }
+    UNIT_CHECK(scheduler_budget_get(&unit_busy_process, &budget));
+    UNIT_CHECK(budget.strikes == SCHEDULE_BUDGET_STRIKES);
+    UNIT_CHECK(budget.demotions == 0);
+
+    // The demoted run is held back, and the process scheduled after it runs first
+    start = ticks;
+    unit_order_length = 0;
+    unit_miss_func = NULL;
+    scheduler_on_deadline_miss(&unit_deadline_miss);
+    UNIT_CHECK(schedule_deadline(&unit_busy_process, 0, 2, &in_budget));
+    UNIT_CHECK(schedule(&unit_order_process, 0, (void *)&names[0]));
+    UNIT_CHECK(dispatch());
+    UNIT_CHECK(dispatch());
+    UNIT_CHECK(unit_order_length == 1);
+    UNIT_CHECK(schedule_length == 0);
+    UNIT_CHECK(scheduler_budget_get(&unit_busy_process, &budget));
+    UNIT_CHECK(budget.demotions == 1);
+
+    // It runs once the back off has passed, and running within budget promotes it again
+    scheduler_hw_host_advance(SCHEDULE_BUDGET_BACKOFF*UNIT_TICK_CYCLES);
+    UNIT_CHECK(dispatch());
+    UNIT_CHECK(ticks == start+SCHEDULE_BUDGET_BACKOFF);
+    UNIT_CHECK(scheduler_budget_get(&unit_busy_process, &budget));
+    UNIT_CHECK(budget.strikes == 0 && budget.demotions == 1);
+    UNIT_CHECK(!dispatch());
+
+    // Holding the run back did not move its deadline
+    UNIT_CHECK(unit_miss_func == &unit_busy_process);
+    UNIT_CHECK(unit_miss_lateness == SCHEDULE_BUDGET_BACKOFF-2);
+    scheduler_on_deadline_miss(NULL);
+
+    UNIT_CHECK(scheduler_budget_set(&unit_busy_process, 0));
+}
+
+
+/**
+ * Periodic process state recorded by unit_periodic_process().
+ */
+struct unit_periodic_s
+{
+    unsigned long runs;         /**< Number of runs so far */
+    unsigned long released[8];  /**< Tick of each of the first runs */
+    unsigned long run_ticks;    /**< Ticks each run takes */
+    unsigned long slow_run;     /**< Run which takes slow_ticks instead, or 0 for none */
+    unsigned long slow_ticks;   /**< Ticks the slow run takes */
+};
+
+/**
+ * A periodic process which records the tick it started on and then takes some time to run.
+ */
+static void unit_periodic_process(void *params)
+{
+    struct unit_periodic_s *state = params;
+    unsigned long run_ticks = state->run_ticks;
+
+    if( state->runs < sizeof(state->released)/sizeof(state->released[0]) )
+    {
+        state->released[state->runs] = ticks;
+    }
+    if( ++state->runs == state->slow_run )
+    {
+        run_ticks = state->slow_ticks;
+    }
+
+    scheduler_hw_host_advance(run_ticks * UNIT_TICK_CYCLES);
+}
+
+/**
+ * A second periodic process, so the two can be told apart by schedule_periodic_stats().
+ */
+static void unit_periodic_late_process(void *params)
+{
+    unit_periodic_process(params);
+}
+
+/**
+ * Run passes of the main loop until @em state has run @em runs times.
+ */
+static void unit_run_periodic(struct unit_periodic_s *state, unsigned long runs)
+{
+    unsigned int passes;
+
+    for( passes = 0; state->runs < runs && passes < 10000; ++passes )
+    {
+        if( !dispatch() )
+        {
+            idle();
+        }
+    }
+}
+
+
+/**
+ * Releases are anchored to absolute ticks, so a process which takes time to run does not drift.
+ */
+static void test_periodic_no_drift(void)
+{
+    static struct unit_periodic_s state = { .run_ticks = 3 };
+    scheduler_periodic_stats_t stats;
+    unsigned long start = ticks;
+    unsigned int iterator;
+
+    UNIT_CHECK(schedule_periodic(&unit_periodic_process, 10, 5, &state));
+    unit_run_periodic(&state, 8);
+
+    for( iterator = 0; iterator < 8; ++iterator )
+    {
+        UNIT_CHECK(state.released[iterator] == start + 5 + 10*iterator);
+    }
+
+    UNIT_CHECK(schedule_periodic_stats(&unit_periodic_process, &stats));
+    UNIT_CHECK(stats.releases >= 8);
+    UNIT_CHECK(stats.deadline_misses == 0);
+    UNIT_CHECK(stats.overruns == 0);
+
+    // The process stays scheduled, stop it taking time so it does not disturb later tests
+    state.run_ticks = 0;
+}
+
+/**
+ * A run which completes more than a period late is counted as a deadline miss, the release it
+ * passed in full is skipped, and later releases stay on the original grid.
+ */
+static void test_periodic_overrun(void)
+{
+    static struct unit_periodic_s state = { .run_ticks = 1, .slow_run = 2, .slow_ticks = 25 };
+    scheduler_periodic_stats_t stats;
+    unsigned long start = ticks;
+
+    UNIT_CHECK(schedule_periodic(&unit_periodic_late_process, 10, 0, &state));
+    unit_run_periodic(&state, 5);
+
+    // Runs 0 and 1 are on time, run 1 takes until start+35 so the release at start+20 is late and
+    // the one at start+30 is skipped
+    UNIT_CHECK(state.released[0] == start);
+    UNIT_CHECK(state.released[1] == start + 10);
+    UNIT_CHECK(state.released[2] == start + 35);
+    UNIT_CHECK(state.released[3] == start + 40);
+    UNIT_CHECK(state.released[4] == start + 50);
+
+    UNIT_CHECK(schedule_periodic_stats(&unit_periodic_late_process, &stats));
+    UNIT_CHECK(stats.deadline_misses == 1);
+    UNIT_CHECK(stats.overruns == 1);
+
+    // The process stays scheduled, stop it taking time so it does not disturb later tests
+    state.run_ticks = 0;
+}
+
+/**
+ * A third periodic process, so it can be given a budget of its own.
+ */
+static void unit_periodic_budget_process(void *params)
+{
+    unit_periodic_process(params);
+}
+
+/**
+ * A demoted periodic process has each run held back, but its releases stay anchored to the original
+ * grid rather than drifting by the back off every period.
+ */
+static void test_periodic_budget_demote(void)
+{
+    static struct unit_periodic_s state = { .run_ticks = 2 };
+    scheduler_periodic_stats_t stats;
+    scheduler_budget_t budget;
+    unsigned long start = ticks;
+    unsigned long expected;
+    unsigned int iterator;
+
+    UNIT_CHECK(scheduler_budget_set(&unit_periodic_budget_process, 1));
+    UNIT_CHECK(schedule_periodic(&unit_periodic_budget_process, 10, 0, &state));
+    unit_run_periodic(&state, 8);
+
+    // The first SCHEDULE_BUDGET_STRIKES runs overrun on time, every later one is held back
+    for( iterator = 0; iterator < 8; ++iterator )
+    {
+        expected = start + 10*iterator;
+        if( iterator >= SCHEDULE_BUDGET_STRIKES )
+        {
+            expected += SCHEDULE_BUDGET_BACKOFF;
+        }
+        UNIT_CHECK(state.released[iterator] == expected);
+    }
+
+    UNIT_CHECK(scheduler_budget_get(&unit_periodic_budget_process, &budget));
+    UNIT_CHECK(budget.demotions == 8 - SCHEDULE_BUDGET_STRIKES);
+    UNIT_CHECK(schedule_periodic_stats(&unit_periodic_budget_process, &stats));
+    UNIT_CHECK(stats.deadline_misses == 0);
+    UNIT_CHECK(stats.overruns == 0);
+
+    state.run_ticks = 0;
+}
+
+/**
+ * Invalid periodic processes are rejected and unknown functions have no statistics.
+ */
+static void test_periodic_invalid(void)
+{
+    scheduler_periodic_stats_t stats;
+
+    UNIT_CHECK(!schedule_periodic(NULL, 10, 0, NULL));
+    UNIT_CHECK(!schedule_periodic(&unit_wake_process, 0, 0, NULL));
+    UNIT_CHECK(!schedule_periodic_stats(&unit_wake_process, &stats));
+}
+
+/**
+ * A cancelled periodic process stops being released and has no statistics.
+ */
+static void test_periodic_unschedule(void)
+{
+    scheduler_periodic_stats_t stats;
+    scheduler_handle_t handle;
+    unsigned long runs;
+
+    unit_wake_tick = 0;
+    handle = schedule_periodic(&unit_wake_process, 5, 0, NULL);
+    UNIT_CHECK(handle != 0);
+    unit_run_until(&unit_wake_tick);
+    UNIT_CHECK(schedule_periodic_stats(&unit_wake_process, &stats));
+    runs = stats.releases;
+
+    UNIT_CHECK(unschedule(handle));
+    UNIT_CHECK(!schedule_periodic_stats(&unit_wake_process, &stats));
+    unit_wake_tick = 0;
+    scheduler_hw_host_advance(20*UNIT_TICK_CYCLES);
+    while( dispatch() );
+    UNIT_CHECK(unit_wake_tick == 0);
+    UNIT_CHECK(runs == 1);
+}
+
+
+int main(void)
+{
+    unit_start();
+
+    test_tickless_delay();
+    test_tickless_mixed_delays();
+    test_tickless_early_wake();
+    test_tickless_empty();
+    test_tickless_wrap();
+    test_profile_times();
+    test_profile_dump();
+
+    // The event may still be on the active list, so it is only initialized once
+    scheduler_event_init(&unit_event);
+    test_event_post();
+    test_event_timeout();
+    test_event_mask();
+    test_coroutine_steps();
+    test_coroutine_posted();
+    test_deadline_order();
+    test_deadline_yield();
+    test_deadline_miss();
+    test_now_time();
+    test_handle_unschedule();
+    test_handle_unschedule_coroutine();
+    test_handle_reschedule();
+    test_budget_overrun();
+    test_budget_demote();
+
+    // Periodic processes stay scheduled, so these run last
+    test_periodic_invalid();
+    test_periodic_unschedule();
+    test_periodic_no_drift();
+    test_periodic_overrun();
+    test_periodic_budget_demote();
+
+    printf("scheduler_unit: %s (%u failures)\n", failures ? "FAILED" : "passed", failures);
+
+    return failures ? 1 : 0;
+}
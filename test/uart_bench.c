@@ -0,0 +1,250 @@
+/* -*- mode: C; tab-width: 4 -*- */
+/**
+ * @file uart_bench.c
+ *
+ * @brief Host benchmark for the ring buffer behind the UART software buffer mode.
+ *
+ * @details The UART driver needs the XC16 toolchain, but its ring buffer has no hardware
+ * dependencies, so the copy paths are timed on host. Bulk writes and reads, as made by uart_write()
+ * and uart_read(), are compared with single byte puts and gets, as made by the ISRs, for the
+ * software buffer sizes the UART supports. On x86 the cost is also given in bytes per TSC cycle. A
+ * producer and consumer thread then check the data survives the lock free hand over. Build and run
+ * from the repository root with:
+ *
+ * <tt>gcc -std=gnu99 -O2 -Iinclude -pthread -o uart_bench test/uart_bench.c && ./uart_bench</tt>
+ *
+ * @date 10/16/2026
+ * @carlnumber FIRM-0009
+ * @version 0.4.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <ringbuf.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_CYCLES() __rdtsc() /**< Read the cycle counter */
+#define BENCH_HAVE_CYCLES 1
+#else
+#define BENCH_CYCLES() 0ULL /**< No cycle counter on this host */
+#define BENCH_HAVE_CYCLES 0
+#endif
+
+#define BENCH_BYTES (64UL*1024UL*1024UL) /**< Number of bytes moved per measurement */
+#define BENCH_CHUNK 20U /**< Length of one uart_write() or uart_read() call */
+#define BENCH_THREAD_BYTES (16UL*1024UL*1024UL) /**< Number of bytes handed between threads */
+
+
+/**
+ * Return a monotonic timestamp in nanoseconds.
+ */
+static unsigned long long bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (unsigned long long)ts.tv_sec*1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Print the cost of moving BENCH_BYTES bytes.
+ */
+static void bench_report(const char *name,
+                         unsigned long long ns,
+                         unsigned long long cycles)
+{
+    printf("  %-28s %8.1f MB/s", name, (double)BENCH_BYTES*1e3/ns);
+    if( BENCH_HAVE_CYCLES )
+    {
+        printf(" %8.3f bytes/cycle", (double)BENCH_BYTES/cycles);
+    }
+    printf("\n");
+}
+
+
+/**
+ * Time bulk writes and reads of BENCH_CHUNK bytes through a ring buffer of the given size.
+ */
+static void bench_bulk(unsigned int size)
+{
+    static unsigned char storage[256];
+    unsigned char chunk[BENCH_CHUNK];
+    ringbuf_t ring;
+    unsigned long moved = 0;
+    unsigned long long start_ns, start_cycles, cycles;
+    char name[32];
+    unsigned int length;
+
+    if( !ringbuf_init(&ring, storage, size) )
+    {
+        return;
+    }
+    for( length = 0; length < BENCH_CHUNK; ++length )
+    {
+        chunk[length] = (unsigned char)length;
+    }
+
+    start_ns = bench_now_ns();
+    start_cycles = BENCH_CYCLES();
+    while( moved < BENCH_BYTES )
+    {
+        // Chunks longer than the ring buffer are cut short, as uart_write() would be
+        length = ringbuf_write(&ring, chunk, BENCH_CHUNK);
+        moved += ringbuf_read(&ring, chunk, length);
+    }
+    cycles = BENCH_CYCLES() - start_cycles;
+
+    snprintf(name, sizeof(name), "bulk, %u byte ring", size);
+    bench_report(name, bench_now_ns() - start_ns, cycles);
+}
+
+/**
+ * Time single byte puts and gets of BENCH_CHUNK bytes through a ring buffer of the given size.
+ */
+static void bench_bytes(unsigned int size)
+{
+    static unsigned char storage[256];
+    volatile unsigned char sink = 0;
+    ringbuf_t ring;
+    unsigned long moved = 0;
+    unsigned long long start_ns, start_cycles, cycles;
+    unsigned char value;
+    char name[32];
+    unsigned int index;
+
+    if( !ringbuf_init(&ring, storage, size) )
+    {
+        return;
+    }
+
+    start_ns = bench_now_ns();
+    start_cycles = BENCH_CYCLES();
+    while( moved < BENCH_BYTES )
+    {
+        for( index = 0; index < BENCH_CHUNK && ringbuf_put(&ring, (unsigned char)index); ++index )
+        {
+        }
+        while( ringbuf_get(&ring, &value) )
+        {
+            sink = value;
+            ++moved;
+        }
+    }
+    cycles = BENCH_CYCLES() - start_cycles;
+    (void)sink;
+
+    snprintf(name, sizeof(name), "byte, %u byte ring", size);
+    bench_report(name, bench_now_ns() - start_ns, cycles);
+}
+
+
+static ringbuf_t thread_ring; /**< Ring buffer shared by the producer and consumer threads */
+
+/**
+ * Write a counting sequence of BENCH_THREAD_BYTES bytes in chunks, yielding while full.
+ */
+static void *bench_producer(void *arg)
+{
+    unsigned char chunk[BENCH_CHUNK];
+    unsigned long sent = 0;
+    unsigned int written = 0;
+    unsigned int length, index;
+
+    (void)arg;
+
+    while( sent < BENCH_THREAD_BYTES )
+    {
+        // Refill the chunk once all of it is written
+        if( written == 0 )
+        {
+            for( index = 0; index < BENCH_CHUNK; ++index )
+            {
+                chunk[index] = (unsigned char)(sent + index);
+            }
+        }
+
+        length = ringbuf_write(&thread_ring, chunk + written, BENCH_CHUNK - written);
+        if( length == 0 )
+        {// Full, let the consumer run on a single core host
+            sched_yield();
+        }
+        written += length;
+        if( written == BENCH_CHUNK )
+        {
+            sent += BENCH_CHUNK;
+            written = 0;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Hand BENCH_THREAD_BYTES bytes from a producer thread to this one and check their order.
+ *
+ * @return Zero if every byte arrived in order.
+ */
+static int bench_threads(void)
+{
+    static unsigned char storage[64];
+    unsigned char chunk[BENCH_CHUNK];
+    unsigned long received = 0;
+    unsigned long long start_ns;
+    unsigned int length, index;
+    pthread_t producer;
+    int errors = 0;
+
+    if( !ringbuf_init(&thread_ring, storage, sizeof(storage)) )
+    {
+        return 1;
+    }
+
+    start_ns = bench_now_ns();
+    pthread_create(&producer, NULL, &bench_producer, NULL);
+    while( received < (BENCH_THREAD_BYTES/BENCH_CHUNK)*BENCH_CHUNK )
+    {
+        length = ringbuf_read(&thread_ring, chunk, BENCH_CHUNK);
+        if( length == 0 )
+        {// Empty, let the producer run on a single core host
+            sched_yield();
+        }
+        for( index = 0; index < length; ++index )
+        {
+            if( chunk[index] != (unsigned char)(received + index) )
+            {
+                ++errors;
+            }
+        }
+        received += length;
+    }
+    pthread_join(producer, NULL);
+
+    printf("  %-28s %8.1f MB/s, %d bytes out of order\n", "threads, 64 byte ring",
+           (double)received*1e3/(bench_now_ns() - start_ns), errors);
+
+    return errors;
+}
+
+
+int main(void)
+{
+    static const unsigned int sizes[] = {4, 16, 64, 128};
+    unsigned int iterator;
+
+    printf("UART ring buffer benchmark, %u byte writes and reads\n", BENCH_CHUNK);
+    for( iterator = 0; iterator < sizeof(sizes)/sizeof(sizes[0]); ++iterator )
+    {
+        bench_bulk(sizes[iterator]);
+        bench_bytes(sizes[iterator]);
+    }
+
+    printf("\nProducer and consumer threads\n");
+
+    return bench_threads() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,244 @@
+/* -*- mode: C; tab-width: 4 -*- */
+/**
+ * @file uart_hw_unit.c
+ *
+ * @brief Host test for the UART baud rate calculator in uart_hw.h.
+ *
+ * @details The calculator has no hardware dependencies, so it is checked on host. For a sweep of
+ * Fcy values, including clocks without a standard crystal behind them, and the standard baud rates,
+ * uart_hw_brg_calc() is compared with a brute force search over every BRG value and both BRGH
+ * settings. On XC16 unsigned long is 32 bits, so every rate the calculator accepts is also checked
+ * to give the same BRG counts in explicit 32-bit arithmetic, and rates which would wrap must be
+ * rejected. The compile time per-rate constants are compared with it for the _FCY_ given on the
+ * command line, and the table of settings and errors is printed. Build and run from the repository
+ * root with:
+ *
+ * <tt>gcc -std=gnu99 -O2 -Iinclude -D_FCY_=36850000UL -o uart_hw_unit test/uart_hw_unit.c && ./uart_hw_unit</tt>
+ *
+ * @date 10/16/2026
+ * @carlnumber FIRM-0009
+ * @version 0.4.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <uart_hw.h>
+
+#ifndef _FCY_
+#error "uart_hw_unit: Define _FCY_ on the command line, e.g. -D_FCY_=36850000UL."
+#endif
+
+
+/**
+ * Search every BRG value and both BRGH settings for the lowest bit time error, in ppm. Rates above
+ * Fcy/UART_HW_DIV_BRGH are outside the calculator's range and count as unreachable.
+ */
+static unsigned long unit_brute_force(unsigned long fcy,
+                                      unsigned long baud)
+{
+    unsigned long best = UART_HW_BAUD_ERROR_INVALID;
+    unsigned long long cycles, error;
+    unsigned long brg;
+    unsigned int brgh;
+
+    if( baud > fcy/UART_HW_DIV_BRGH )
+    {
+        return UART_HW_BAUD_ERROR_INVALID;
+    }
+
+    for( brgh = 0; brgh < 2; ++brgh )
+    {
+        for( brg = 0; brg <= UART_HW_BRG_MAX; ++brg )
+        {
+            cycles = (brgh ? UART_HW_DIV_BRGH : UART_HW_DIV_BRGL)*(brg + 1)*(unsigned long long)baud;
+            error = (cycles > fcy ? cycles - fcy : fcy - cycles)*1000000ULL/fcy;
+            if( error < best )
+            {
+                best = (unsigned long)error;
+            }
+        }
+    }
+
+    return best;
+}
+
+/**
+ * Check uart_hw_brg_calc() gives the lowest error and settings which generate it.
+ *
+ * @return The number of failures.
+ */
+static int unit_check(unsigned long fcy,
+                      unsigned long baud)
+{
+    unsigned long error, expected, actual;
+    unsigned int brgh = 2, brg = 0;
+    int failures = 0;
+
+    error = uart_hw_brg_calc(fcy, baud, &brgh, &brg);
+    expected = unit_brute_force(fcy, baud);
+
+    if( error != expected )
+    {
+        printf("  FAIL Fcy %lu, %lu baud: error %lu ppm, brute force %lu ppm\n",
+               fcy, baud, error, expected);
+        ++failures;
+    }
+    else if( error != UART_HW_BAUD_ERROR_INVALID )
+    {
+        // The settings must generate the error reported
+        actual = (brgh ? UART_HW_DIV_BRGH : UART_HW_DIV_BRGL)*((unsigned long)brg + 1)*baud;
+        actual = (unsigned long)((actual > fcy ? actual - fcy : fcy - actual)*1000000ULL/fcy);
+        if( brgh > 1 || actual != error )
+        {
+            printf("  FAIL Fcy %lu, %lu baud: BRGH %u BRG %u give %lu ppm, not %lu ppm\n",
+                   fcy, baud, brgh, brg, actual, error);
+            ++failures;
+        }
+    }
+
+    return failures;
+}
+
+/**
+ * Check a rate the calculator accepts gives the same BRG counts in 32-bit arithmetic, as on XC16,
+ * and that a rate whose counts wrap or divide by zero in 32 bits is rejected.
+ *
+ * @return The number of failures.
+ */
+static int unit_check_32bit(unsigned long fcy,
+                            unsigned long baud)
+{
+    uint32_t fcy32 = (uint32_t)fcy, baud32 = (uint32_t)baud;
+    uint32_t div_h = UART_HW_DIV_BRGH, div_l = UART_HW_DIV_BRGL;
+    unsigned int brgh, brg;
+    int accepted, wraps;
+
+    accepted = uart_hw_brg_calc(fcy, baud, &brgh, &brg) != UART_HW_BAUD_ERROR_INVALID;
+
+    // Any product over 32 bits wraps, including those which wrap to zero
+    wraps = 1ULL*UART_HW_DIV_BRGL*baud32 > UINT32_MAX
+            || 1ULL*fcy32 + 1ULL*UART_HW_DIV_BRGL*baud32/2 > UINT32_MAX;
+    if( accepted && wraps )
+    {
+        printf("  FAIL Fcy %lu, %lu baud: accepted but wraps in 32 bits\n", fcy, baud);
+        return 1;
+    }
+
+    if( accepted && (UART_HW_BRG_COUNT(fcy32, baud32, div_h) != UART_HW_BRG_COUNT(1ULL*fcy, 1ULL*baud, div_h)
+                     || UART_HW_BRG_COUNT(fcy32, baud32, div_l) != UART_HW_BRG_COUNT(1ULL*fcy, 1ULL*baud, div_l)) )
+    {
+        printf("  FAIL Fcy %lu, %lu baud: 32-bit BRG counts differ\n", fcy, baud);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+/** The rates of uart_baudrate_t */
+static const unsigned long rates[] = {1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200, 230400,
+                                      460800, 921600, 1000000, 1843200, 2000000, 3686400};
+
+/** The compile time settings of each rate in rates[] for _FCY_ */
+static const struct
+{
+    unsigned int brgh;
+    unsigned long brg;
+} constants[] = {
+    {UART_HW_BRGH_1200, UART_HW_BRG_1200},
+    {UART_HW_BRGH_2400, UART_HW_BRG_2400},
+    {UART_HW_BRGH_4800, UART_HW_BRG_4800},
+    {UART_HW_BRGH_9600, UART_HW_BRG_9600},
+    {UART_HW_BRGH_19200, UART_HW_BRG_19200},
+    {UART_HW_BRGH_38400, UART_HW_BRG_38400},
+    {UART_HW_BRGH_57600, UART_HW_BRG_57600},
+    {UART_HW_BRGH_115200, UART_HW_BRG_115200},
+    {UART_HW_BRGH_230400, UART_HW_BRG_230400},
+    {UART_HW_BRGH_460800, UART_HW_BRG_460800},
+    {UART_HW_BRGH_921600, UART_HW_BRG_921600},
+    {UART_HW_BRGH_1000000, UART_HW_BRG_1000000},
+    {UART_HW_BRGH_1843200, UART_HW_BRG_1843200},
+    {UART_HW_BRGH_2000000, UART_HW_BRG_2000000},
+    {UART_HW_BRGH_3686400, UART_HW_BRG_3686400},
+};
+
+int main(void)
+{
+    static const unsigned long fcys[] = {2000000, 3000000, 4000000, 6000000, 10000000, 12000000,
+                                         18425000, 20000000, 36850000, 40000000, 70000000};
+    static const unsigned long odd_rates[] = {300, 31250, 250000, 500000, 1500000, 3000000,
+                                              20000000};
+    unsigned long error;
+    unsigned int brgh, brg;
+    unsigned int fcy, rate;
+    int failures = 0;
+
+    // Calculator against brute force
+    for( fcy = 0; fcy < sizeof(fcys)/sizeof(fcys[0]); ++fcy )
+    {
+        for( rate = 0; rate < sizeof(rates)/sizeof(rates[0]); ++rate )
+        {
+            failures += unit_check(fcys[fcy], rates[rate]);
+        }
+        for( rate = 0; rate < sizeof(odd_rates)/sizeof(odd_rates[0]); ++rate )
+        {
+            failures += unit_check(fcys[fcy], odd_rates[rate]);
+        }
+    }
+
+    // Rates around the fastest the calculator accepts and those which wrap in 32 bits
+    for( fcy = 0; fcy < sizeof(fcys)/sizeof(fcys[0]); ++fcy )
+    {
+        for( rate = 0; rate < sizeof(rates)/sizeof(rates[0]); ++rate )
+        {
+            failures += unit_check_32bit(fcys[fcy], rates[rate]);
+        }
+        failures += unit_check_32bit(fcys[fcy], fcys[fcy]/UART_HW_DIV_BRGH);
+        failures += unit_check_32bit(fcys[fcy], fcys[fcy]/UART_HW_DIV_BRGH + 1);
+        failures += unit_check_32bit(fcys[fcy], 268435456UL);
+        failures += unit_check_32bit(fcys[fcy], 0xFFFFFFFFUL);
+    }
+    if( uart_hw_brg_calc(70000000UL, 268435456UL, &brgh, &brg) != UART_HW_BAUD_ERROR_INVALID ||
+        uart_hw_brg_calc(70000000UL, 70000000UL/UART_HW_DIV_BRGH + 1, &brgh, &brg) != UART_HW_BAUD_ERROR_INVALID ||
+        uart_hw_brg_calc(70000000UL, 70000000UL/UART_HW_DIV_BRGH, &brgh, &brg) != 0 )
+    {
+        printf("  FAIL fastest rate limit\n");
+        ++failures;
+    }
+
+    // Rates which cannot be generated at all
+    if( uart_hw_brg_calc(70000000UL, 0, &brgh, &brg) != UART_HW_BAUD_ERROR_INVALID ||
+        uart_hw_brg_calc(70000000UL, 50000000UL, &brgh, &brg) != UART_HW_BAUD_ERROR_INVALID ||
+        uart_hw_brg_calc(70000000UL, 10, &brgh, &brg) != UART_HW_BAUD_ERROR_INVALID )
+    {
+        printf("  FAIL unreachable rate reported as reachable\n");
+        ++failures;
+    }
+
+    // Compile time constants against the calculator
+    printf("Fcy %lu Hz, error limit %lu ppm\n", (unsigned long)_FCY_, (unsigned long)UART_DEF_BAUD_ERROR_PPM);
+    for( rate = 0; rate < sizeof(rates)/sizeof(rates[0]); ++rate )
+    {
+        error = uart_hw_brg_calc(_FCY_, rates[rate], &brgh, &brg);
+        if( error == UART_HW_BAUD_ERROR_INVALID )
+        {
+            printf("  %8lu baud: cannot be generated\n", rates[rate]);
+            continue;
+        }
+
+        printf("  %8lu baud: BRGH %u BRG %5u, %6lu ppm%s\n", rates[rate], brgh, brg, error,
+               error > UART_DEF_BAUD_ERROR_PPM ? ", refused" : "");
+        if( constants[rate].brgh != brgh || constants[rate].brg != brg )
+        {
+            printf("  FAIL constants BRGH %u BRG %lu differ\n", constants[rate].brgh,
+                   constants[rate].brg);
+            ++failures;
+        }
+    }
+
+    printf("%d failures\n", failures);
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,346 @@
+/* -*- mode: C; tab-width: 4 -*- */
+/**
+ * @file uart_lin_engine_unit.c
+ *
+ * @brief Host test for the LIN frame engine of the UART driver.
+ *
+ * @details The UART source is included directly and built against the register stand-ins of
+ * uart_hw.h, so that characters can be fed through the simulated RX FIFO into the LIN RX ISR and
+ * the frame timeout and schedule table driven through uart_tick(). Responses go out through the
+ * TX software buffer, which is read back here rather than sent. Build and run from the repository
+ * root with:
+ *
+ * <tt>gcc -std=gnu99 -fgnu89-inline -Iinclude -DUART_HOST -o uart_lin_engine_unit test/uart_lin_engine_unit.c && ./uart_lin_engine_unit</tt>
+ *
+ * @date 10/16/2026
+ * @carlnumber FIRM-0009
+ * @version 0.4.0
+ */
+
+#include <stdio.h>
+
+// Build as the dsPIC33F the driver targets, with the simulated hardware of uart_hw.h
+#define __XC16
+#define __HAS_DMA__
+#define __dsPIC33FJ128MC802__
+#ifndef _FCY_
+#define _FCY_ 40000000UL
+#endif
+
+#include "../source/uart_xc16.c"
+
+/** Check a condition, reporting and counting it on failure */
+#define UNIT_CHECK(cond) \
+    do { if( !(cond) ) { printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); ++failures; } } while(0)
+
+static unsigned int failures = 0;
+
+
+/* DMA channel stand-ins, the LIN engine only uses the TX software buffer */
+int dma_init(dma_channel_t *dma_channel, dma_attr_t *attr) { (void)dma_channel; (void)attr; return DMA_E_NONE; }
+int dma_enable(dma_channel_t *dma_channel) { (void)dma_channel; return DMA_E_NONE; }
+int dma_disable(dma_channel_t *dma_channel) { (void)dma_channel; return DMA_E_NONE; }
+int dma_force(dma_channel_t *dma_channel) { (void)dma_channel; return DMA_E_NONE; }
+int dma_cleanup(dma_channel_t *dma_channel) { (void)dma_channel; return DMA_E_NONE; }
+int dma_set_interrupt_on(dma_channel_t *dma_channel, dma_interrupt_on_t on) { (void)dma_channel; (void)on; return DMA_E_NONE; }
+int dma_set_block_size(dma_channel_t *dma_channel, unsigned int size) { (void)dma_channel; (void)size; return DMA_E_NONE; }
+int dma_set_buffer(dma_channel_t *dma_channel, dma_pingpong_status_t buffer) { (void)dma_channel; (void)buffer; return DMA_E_NONE; }
+
+
+/**
+ * Number of times each callback was called.
+ */
+static unsigned int unit_tx_calls = 0;
+static unsigned int unit_rx_calls = 0;
+
+static void unit_tx_callback(uart_module_t *module)
+{
+    (void)module;
+    unit_tx_calls++;
+}
+
+static void unit_rx_callback(uart_module_t *module)
+{
+    (void)module;
+    unit_rx_calls++;
+}
+
+/**
+ * The module under test, UART 1.
+ */
+static uart_module_t unit_module = { 1, &unit_tx_callback, &unit_rx_callback, NULL };
+
+/**
+ * Initialize and open the module as a LIN master or slave, with a fresh RX FIFO.
+ */
+static void unit_setup(int minor)
+{
+    uart_attr_t attr = {0};
+
+    if( unit_module.private != NULL )
+    {
+        uart_cleanup(&unit_module);
+    }
+    memset((void *)uart_hw_host_rx, 0, sizeof(uart_hw_host_rx));
+
+    attr.mode_settings = UART_MAJOR_MODE_LIN | minor;
+    attr.tx_buffer_settings = UART_TX_BUFFER_MODE_SOFT | UART_TX_BUFFER_SIZE_16;
+    attr.rx_buffer_settings = UART_RX_BUFFER_MODE_HWONLY;
+    UNIT_CHECK(uart_init(&unit_module, &attr, NULL, NULL) == UART_E_NONE);
+    UNIT_CHECK(uart_open(&unit_module, UART_DIRECTION_TXRX) == UART_E_NONE);
+
+    unit_tx_calls = 0;
+    unit_rx_calls = 0;
+}
+
+/**
+ * The state of the LIN frame state machine.
+ */
+static unsigned int unit_state(void)
+{
+    return UART_GET_PRIVATE(&unit_module)->lin_state_;
+}
+
+/**
+ * Receive @em count characters from the bus, running the RX ISR whenever the FIFO fills and once
+ * all have arrived.
+ */
+static void unit_receive(const unsigned char *characters,
+                         unsigned int count)
+{
+    unsigned int index;
+
+    for( index = 0; index < count; index++ )
+    {
+        if( !uart_hw_host_rx_feed(1, characters[index], false) )
+        {// FIFO full, let the ISR empty it
+            uart_rx_isr(&unit_module);
+            uart_hw_host_rx_feed(1, characters[index], false);
+        }
+    }
+    uart_rx_isr(&unit_module);
+}
+
+/**
+ * Receive a break, which reads as a zero character with a framing error.
+ */
+static void unit_break(void)
+{
+    uart_hw_host_rx_feed(1, 0x00, true);
+    uart_rx_isr(&unit_module);
+}
+
+/**
+ * Receive the header of frame @em id in one burst, as the RX FIFO holds it.
+ */
+static void unit_header(unsigned char id)
+{
+    uart_hw_host_rx_feed(1, 0x00, true);
+    uart_hw_host_rx_feed(1, UART_LIN_SYNC, false);
+    uart_hw_host_rx_feed(1, uart_lin_pid(id), false);
+    uart_rx_isr(&unit_module);
+}
+
+
+/**
+ * A break moves the slave to SYNC, the sync character to PID and the PID of a subscribed frame to
+ * RESPONSE. A response with a good checksum is copied into the frame.
+ */
+static void test_subscribe(void)
+{
+    uart_lin_frame_t frames[] = {
+        { .id = 0x10, .length = 2, .direction = UART_LIN_DIRECTION_SUBSCRIBE,
+          .checksum = UART_LIN_CHECKSUM_ENHANCED },
+    };
+    unsigned char response[3] = {0x12, 0x34, 0};
+    unsigned char sync = UART_LIN_SYNC;
+    unsigned char pid = uart_lin_pid(0x10);
+
+    unit_setup(UART_MINOR_MODE_LIN_SLAVE);
+    UNIT_CHECK(uart_lin_set_frames(&unit_module, frames, 1) == UART_E_NONE);
+    UNIT_CHECK(unit_state() == UART_LIN_STATE_IDLE);
+
+    unit_break();
+    UNIT_CHECK(unit_state() == UART_LIN_STATE_SYNC);
+    unit_receive(&sync, 1);
+    UNIT_CHECK(unit_state() == UART_LIN_STATE_PID);
+    unit_receive(&pid, 1);
+    UNIT_CHECK(unit_state() == UART_LIN_STATE_RESPONSE);
+    UNIT_CHECK(frames[0].status == UART_LIN_STATUS_BUSY);
+
+    response[2] = uart_lin_checksum(pid, response, 2, true);
+    unit_receive(response, 3);
+    UNIT_CHECK(unit_state() == UART_LIN_STATE_IDLE);
+    UNIT_CHECK(frames[0].status == UART_LIN_STATUS_OK);
+    UNIT_CHECK(frames[0].data[0] == 0x12 && frames[0].data[1] == 0x34);
+    UNIT_CHECK(unit_rx_calls == 1 && unit_tx_calls == 0);
+
+    // A wrong sync character drops the header
+    unit_break();
+    sync = 0x54;
+    unit_receive(&sync, 1);
+    UNIT_CHECK(unit_state() == UART_LIN_STATE_IDLE);
+}
+
+/**
+ * A response with a wrong checksum ends the frame with E_CHECKSUM and keeps the previous data.
+ */
+static void test_checksum_error(void)
+{
+    uart_lin_frame_t frames[] = {
+        { .id = 0x10, .length = 2, .direction = UART_LIN_DIRECTION_SUBSCRIBE,
+          .checksum = UART_LIN_CHECKSUM_ENHANCED, .data = {0xAA, 0xBB} },
+    };
+    unsigned char response[3] = {0x12, 0x34, 0};
+
+    unit_setup(UART_MINOR_MODE_LIN_SLAVE);
+    UNIT_CHECK(uart_lin_set_frames(&unit_module, frames, 1) == UART_E_NONE);
+
+    unit_header(0x10);
+    response[2] = uart_lin_checksum(uart_lin_pid(0x10), response, 2, true) ^ 0x01;
+    unit_receive(response, 3);
+    UNIT_CHECK(frames[0].status == UART_LIN_STATUS_E_CHECKSUM);
+    UNIT_CHECK(frames[0].data[0] == 0xAA && frames[0].data[1] == 0xBB);
+    UNIT_CHECK(unit_rx_calls == 1);
+}
+
+/**
+ * A published response is queued for sending once the PID arrives, and ends with OK when it reads
+ * back intact or with E_BIT when another node was sending too.
+ */
+static void test_publish_collision(void)
+{
+    uart_lin_frame_t frames[] = {
+        { .id = 0x11, .length = 2, .direction = UART_LIN_DIRECTION_PUBLISH,
+          .checksum = UART_LIN_CHECKSUM_CLASSIC, .data = {0x5A, 0xA5} },
+    };
+    unsigned char sent[4];
+    unsigned char readback[3];
+
+    unit_setup(UART_MINOR_MODE_LIN_SLAVE);
+    UNIT_CHECK(uart_lin_set_frames(&unit_module, frames, 1) == UART_E_NONE);
+
+    // Intact read back
+    unit_header(0x11);
+    UNIT_CHECK(frames[0].status == UART_LIN_STATUS_BUSY);
+    UNIT_CHECK(ringbuf_read(&UART_GET_PRIVATE(&unit_module)->tx_ring_, sent, sizeof(sent)) == 3);
+    UNIT_CHECK(sent[0] == 0x5A && sent[1] == 0xA5);
+    UNIT_CHECK(sent[2] == uart_lin_checksum(uart_lin_pid(0x11), frames[0].data, 2, false));
+    unit_receive(sent, 3);
+    UNIT_CHECK(frames[0].status == UART_LIN_STATUS_OK);
+    UNIT_CHECK(unit_tx_calls == 1 && unit_rx_calls == 0);
+
+    // The second character reads back differently
+    unit_header(0x11);
+    UNIT_CHECK(ringbuf_read(&UART_GET_PRIVATE(&unit_module)->tx_ring_, readback, sizeof(readback)) == 3);
+    readback[1] ^= 0x10;
+    unit_receive(readback, 2);
+    UNIT_CHECK(frames[0].status == UART_LIN_STATUS_E_BIT);
+    UNIT_CHECK(unit_state() == UART_LIN_STATE_IDLE);
+    UNIT_CHECK(unit_tx_calls == 2);
+}
+
+/**
+ * A response still in progress UART_DEF_LIN_FRAME_TICKS uart_tick() calls after its break is ended
+ * with E_NO_RESPONSE, as is one cut short by the next break.
+ */
+static void test_frame_timeout(void)
+{
+    uart_lin_frame_t frames[] = {
+        { .id = 0x10, .length = 2, .direction = UART_LIN_DIRECTION_SUBSCRIBE,
+          .checksum = UART_LIN_CHECKSUM_ENHANCED },
+    };
+    unsigned char data = 0x12;
+    unsigned int tick;
+
+    unit_setup(UART_MINOR_MODE_LIN_SLAVE);
+    UNIT_CHECK(uart_lin_set_frames(&unit_module, frames, 1) == UART_E_NONE);
+
+    unit_header(0x10);
+    unit_receive(&data, 1);
+    for( tick = 0; tick < UART_DEF_LIN_FRAME_TICKS; tick++ )
+    {
+        uart_tick(&unit_module);
+    }
+    UNIT_CHECK(frames[0].status == UART_LIN_STATUS_BUSY);
+    uart_tick(&unit_module);
+    UNIT_CHECK(frames[0].status == UART_LIN_STATUS_E_NO_RESPONSE);
+    UNIT_CHECK(unit_state() == UART_LIN_STATE_IDLE);
+    UNIT_CHECK(unit_rx_calls == 1);
+
+    // A break in the middle of a response ends it and starts the next frame
+    unit_header(0x10);
+    unit_receive(&data, 1);
+    unit_break();
+    UNIT_CHECK(frames[0].status == UART_LIN_STATUS_E_NO_RESPONSE);
+    UNIT_CHECK(unit_state() == UART_LIN_STATE_SYNC);
+    UNIT_CHECK(unit_rx_calls == 2);
+}
+
+/**
+ * A master sends the header of each slot, follows its own header like a slave, and ends a
+ * response which overruns its slot. A slot whose header cannot be sent because the transmitter is
+ * busy is skipped, and the frame ends through the same callback as any other.
+ */
+static void test_master_schedule(void)
+{
+    uart_lin_frame_t frames[] = {
+        { .id = 0x20, .length = 2, .direction = UART_LIN_DIRECTION_SUBSCRIBE,
+          .checksum = UART_LIN_CHECKSUM_ENHANCED },
+        { .id = 0x21, .length = 1, .direction = UART_LIN_DIRECTION_PUBLISH,
+          .checksum = UART_LIN_CHECKSUM_ENHANCED },
+    };
+    const uart_lin_slot_t schedule[] = {
+        { &frames[0], 1 },
+        { &frames[1], 1 },
+    };
+    volatile unsigned int *sta;
+    unsigned char data = 0x12;
+
+    unit_setup(UART_MINOR_MODE_LIN_MASTER);
+    sta = UART_GET_BASE_ADDRESS(&unit_module) + UART_SFR_OFFSET_UxSTA;
+    UNIT_CHECK(uart_lin_set_schedule(&unit_module, schedule, 2) == UART_E_NONE);
+
+    // The first slot starts on the next tick with the break, sync and PID
+    uart_tick(&unit_module);
+    UNIT_CHECK((*sta & UART_SFR_BITMASK_UTXBRK) != 0);
+    UNIT_CHECK(*(UART_GET_BASE_ADDRESS(&unit_module) + UART_SFR_OFFSET_UxTXREG) == uart_lin_pid(0x20));
+    UNIT_CHECK(UART_GET_PRIVATE(&unit_module)->lin_header_frame_ == &frames[0]);
+
+    // The header reads back, and half the response arrives before the slot ends
+    unit_header(0x20);
+    UNIT_CHECK(unit_state() == UART_LIN_STATE_RESPONSE);
+    unit_receive(&data, 1);
+    *sta &= ~UART_SFR_BITMASK_TRMT;
+    uart_tick(&unit_module);
+    UNIT_CHECK(frames[0].status == UART_LIN_STATUS_E_NO_RESPONSE);
+    UNIT_CHECK(unit_rx_calls == 1);
+
+    // The transmitter was still busy, so the second slot is skipped
+    UNIT_CHECK(frames[1].status == UART_LIN_STATUS_E_NO_RESPONSE);
+    UNIT_CHECK(unit_tx_calls == 1);
+    UNIT_CHECK(unit_state() == UART_LIN_STATE_IDLE);
+    UNIT_CHECK(UART_GET_PRIVATE(&unit_module)->lin_header_frame_ == NULL);
+
+    // Once idle the next slot sends its header again
+    *sta |= UART_SFR_BITMASK_TRMT;
+    *(UART_GET_BASE_ADDRESS(&unit_module) + UART_SFR_OFFSET_UxTXREG) = 0;
+    uart_tick(&unit_module);
+    UNIT_CHECK(*(UART_GET_BASE_ADDRESS(&unit_module) + UART_SFR_OFFSET_UxTXREG) == uart_lin_pid(0x20));
+}
+
+
+int main(void)
+{
+    test_subscribe();
+    test_checksum_error();
+    test_publish_collision();
+    test_frame_timeout();
+    test_master_schedule();
+
+    uart_cleanup(&unit_module);
+
+    printf("uart_lin_engine_unit: %s (%u failures)\n", failures == 0 ? "passed" : "FAILED", failures);
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
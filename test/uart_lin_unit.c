@@ -0,0 +1,153 @@
+/* -*- mode: C; tab-width: 4 -*- */
+/**
+ * @file uart_lin_unit.c
+ *
+ * @brief Host test for the LIN protocol helpers in uart_lin.h.
+ *
+ * @details The PID and checksum helpers have no hardware dependencies, so they are checked on host.
+ * Every frame identifier is given a PID by uart_lin_pid(), which is compared with the parity
+ * equations written out bit by bit, and every byte is checked by uart_lin_pid_is_valid(). The
+ * checksums are compared with the example of the LIN 2.x specification and a slow sum with carry.
+ * Build and run from the repository root with:
+ *
+ * <tt>gcc -std=gnu99 -O2 -Iinclude -o uart_lin_unit test/uart_lin_unit.c && ./uart_lin_unit</tt>
+ *
+ * @date 10/16/2026
+ * @carlnumber FIRM-0009
+ * @version 0.4.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <uart_lin.h>
+
+
+/**
+ * Return bit @em n of @em value.
+ */
+static unsigned int unit_bit(unsigned int value,
+                             unsigned int n)
+{
+    return (value >> n) & 1;
+}
+
+/**
+ * Return the checksum of @em data by summing with a 16 bit accumulator and folding the carries
+ * at the end.
+ */
+static unsigned char unit_checksum(unsigned char pid,
+                                   const unsigned char *data,
+                                   unsigned int length,
+                                   bool enhanced)
+{
+    unsigned long sum = enhanced ? pid : 0;
+    unsigned int index;
+
+    for( index = 0; index < length; ++index )
+    {
+        sum += data[index];
+    }
+    while( sum > 0xFF )
+    {
+        sum = (sum & 0xFF) + (sum >> 8);
+    }
+
+    return (unsigned char)~sum;
+}
+
+
+int main(void)
+{
+    static const unsigned char vectors[][2] = {{0x3C, 0x3C}, {0x3D, 0x7D}, {0x10, 0x50}, {0x01, 0xC1}};
+    static const unsigned char example[] = {0x55, 0x93, 0xE5};
+    unsigned char data[UART_LIN_MAX_DATA];
+    unsigned int id, pid, expected, length, index, valid = 0;
+    unsigned int seed = 1;
+    int failures = 0;
+
+    // PIDs against the parity equations
+    for( id = 0; id <= UART_LIN_ID_MASK; ++id )
+    {
+        expected = id
+                   | ((unit_bit(id, 0) ^ unit_bit(id, 1) ^ unit_bit(id, 2) ^ unit_bit(id, 4)) << 6)
+                   | ((1 ^ unit_bit(id, 1) ^ unit_bit(id, 3) ^ unit_bit(id, 4) ^ unit_bit(id, 5)) << 7);
+        if( uart_lin_pid(id) != expected || uart_lin_pid(id | 0xC0) != expected )
+        {
+            printf("  FAIL ID 0x%02X: PID 0x%02X, expected 0x%02X\n", id, uart_lin_pid(id), expected);
+            ++failures;
+        }
+    }
+    for( index = 0; index < sizeof(vectors)/sizeof(vectors[0]); ++index )
+    {
+        if( uart_lin_pid(vectors[index][0]) != vectors[index][1] )
+        {
+            printf("  FAIL ID 0x%02X: PID 0x%02X, expected 0x%02X\n", vectors[index][0],
+                   uart_lin_pid(vectors[index][0]), vectors[index][1]);
+            ++failures;
+        }
+    }
+
+    // Exactly one PID per frame identifier is valid
+    for( pid = 0; pid <= 0xFF; ++pid )
+    {
+        if( uart_lin_pid_is_valid(pid) )
+        {
+            ++valid;
+            if( uart_lin_pid(pid & UART_LIN_ID_MASK) != pid )
+            {
+                printf("  FAIL PID 0x%02X valid with the wrong parity\n", pid);
+                ++failures;
+            }
+        }
+    }
+    if( valid != UART_LIN_ID_MASK + 1 )
+    {
+        printf("  FAIL %u valid PIDs, expected %u\n", valid, UART_LIN_ID_MASK + 1);
+        ++failures;
+    }
+
+    // Example of the specification, enhanced and classic
+    if( uart_lin_checksum(0x4A, example, sizeof(example), true) != 0xE6 )
+    {
+        printf("  FAIL enhanced example checksum 0x%02X, expected 0xE6\n",
+               uart_lin_checksum(0x4A, example, sizeof(example), true));
+        ++failures;
+    }
+    if( uart_lin_checksum(0x4A, example, sizeof(example), false) != unit_checksum(0, example, sizeof(example), false) )
+    {
+        printf("  FAIL classic example checksum 0x%02X\n",
+               uart_lin_checksum(0x4A, example, sizeof(example), false));
+        ++failures;
+    }
+
+    // Carries of all 0xFF data, and random responses of every length
+    for( index = 0; index < UART_LIN_MAX_DATA; ++index )
+    {
+        data[index] = 0xFF;
+    }
+    if( uart_lin_checksum(0xFF, data, UART_LIN_MAX_DATA, true) != 0x00 )
+    {
+        printf("  FAIL all 0xFF checksum 0x%02X, expected 0x00\n",
+               uart_lin_checksum(0xFF, data, UART_LIN_MAX_DATA, true));
+        ++failures;
+    }
+    for( pid = 0; pid < 10000; ++pid )
+    {
+        length = 1 + pid % UART_LIN_MAX_DATA;
+        for( index = 0; index < length; ++index )
+        {
+            seed = seed*1103515245U + 12345U;
+            data[index] = (unsigned char)(seed >> 16);
+        }
+        if( uart_lin_checksum(pid & 0xFF, data, length, pid & 1) != unit_checksum(pid & 0xFF, data, length, pid & 1) )
+        {
+            printf("  FAIL checksum of response %u\n", pid);
+            ++failures;
+        }
+    }
+
+    printf("%d failures\n", failures);
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}